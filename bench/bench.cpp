@@ -0,0 +1,339 @@
+#include "bench.h"
+
+#include <imnodes.h>
+
+#include <math.h>
+#include <algorithm>
+#include <random>
+
+namespace bench
+{
+void HeadlessInitialize(const ImVec2& display_size)
+{
+    ImGui::CreateContext();
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = display_size;
+    io.IniFilename = nullptr;
+    // Large graphs emit more than 64k vertices into the canvas draw list.
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+
+    // The font atlas has to be built before the first frame, even though
+    // nothing will ever be rendered.
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    imnodes::Initialize();
+}
+
+void HeadlessShutdown()
+{
+    imnodes::Shutdown();
+    ImGui::DestroyContext();
+}
+
+void HeadlessNewFrame(const ImVec2& mouse_pos, const bool left_mouse_down)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    io.DeltaTime = 1.f / 60.f;
+    io.MousePos = mouse_pos;
+    io.MouseDown[0] = left_mouse_down;
+    ImGui::NewFrame();
+}
+
+void HeadlessEndFrame() { ImGui::Render(); }
+
+ThreadPool::ThreadPool(const int num_threads)
+    : workers_(), mutex_(), work_available_(), work_done_(), job_(nullptr),
+      job_data_(nullptr), job_count_(0), next_job_(0), jobs_remaining_(0),
+      generation_(0u), quit_(false)
+{
+    for (int i = 1; i < num_threads; ++i)
+    {
+        workers_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(
+    void (*job)(int, void*),
+    const int job_count,
+    void* const job_data,
+    void* const user_data)
+{
+    ThreadPool& pool = *static_cast<ThreadPool*>(user_data);
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex_);
+        pool.job_ = job;
+        pool.job_data_ = job_data;
+        pool.job_count_ = job_count;
+        pool.next_job_ = 0;
+        pool.jobs_remaining_ = job_count;
+        ++pool.generation_;
+    }
+    pool.work_available_.notify_all();
+
+    pool.run_jobs();
+
+    std::unique_lock<std::mutex> lock(pool.mutex_);
+    pool.work_done_.wait(lock, [&pool] { return pool.jobs_remaining_ == 0; });
+}
+
+void ThreadPool::worker_loop()
+{
+    unsigned seen_generation = 0u;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_available_.wait(lock, [&] {
+                return quit_ || generation_ != seen_generation;
+            });
+            if (quit_)
+            {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        run_jobs();
+    }
+}
+
+void ThreadPool::run_jobs()
+{
+    for (;;)
+    {
+        int job_idx;
+        void (*job)(int, void*);
+        void* job_data;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (next_job_ >= job_count_)
+            {
+                return;
+            }
+            job_idx = next_job_++;
+            job = job_;
+            job_data = job_data_;
+        }
+
+        job(job_idx, job_data);
+
+        bool all_done;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            all_done = --jobs_remaining_ == 0;
+        }
+        if (all_done)
+        {
+            work_done_.notify_all();
+        }
+    }
+}
+
+Graph MakeGraph(
+    const int num_nodes,
+    const int num_links,
+    const ImVec2& origin,
+    const ImVec2& extent,
+    const bool jitter)
+{
+    const int columns = std::max(
+        static_cast<int>(sqrtf(num_nodes * extent.x / extent.y)), 1);
+    const int rows = (num_nodes + columns - 1) / columns;
+    const ImVec2 cell_size(extent.x / columns, extent.y / rows);
+
+    std::mt19937 rng(1234u);
+    std::uniform_real_distribution<float> jitter_dist(0.f, 1.f);
+    std::uniform_int_distribution<int> node_dist(0, num_nodes - 1);
+    std::uniform_int_distribution<int> neighbour_dist(-2, 2);
+
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        ImVec2 cell(
+            static_cast<float>(i % columns), static_cast<float>(i / columns));
+        if (jitter)
+        {
+            cell.x += jitter_dist(rng);
+            cell.y += jitter_dist(rng);
+        }
+        imnodes::SetNodeGridSpacePos(
+            i,
+            ImVec2(
+                origin.x + cell.x * cell_size.x,
+                origin.y + cell.y * cell_size.y));
+    }
+
+    Graph graph;
+    graph.num_nodes = num_nodes;
+    graph.links.reserve(num_links);
+    for (int i = 0; i < num_links; ++i)
+    {
+        const int start = node_dist(rng);
+        const int neighbour =
+            start + neighbour_dist(rng) + neighbour_dist(rng) * columns;
+        const int end = std::min(std::max(neighbour, 0), num_nodes - 1);
+        graph.links.push_back({i, OutputAttr(start), InputAttr(end)});
+    }
+    return graph;
+}
+
+void SubmitGraph(const Graph& graph)
+{
+    for (int i = 0; i < graph.num_nodes; ++i)
+    {
+        imnodes::BeginNode(i);
+        imnodes::BeginInputAttribute(InputAttr(i));
+        ImGui::Dummy(ImVec2(10.f, 10.f));
+        imnodes::EndAttribute();
+        imnodes::BeginOutputAttribute(OutputAttr(i));
+        ImGui::Dummy(ImVec2(10.f, 10.f));
+        imnodes::EndAttribute();
+        imnodes::EndNode();
+    }
+
+    for (const Graph::Link& link : graph.links)
+    {
+        imnodes::Link(link.id, link.start_attr, link.end_attr);
+    }
+}
+
+int PlaceNodesOnSquareGrid(const int num_nodes)
+{
+    const int columns =
+        static_cast<int>(ceilf(sqrtf(static_cast<float>(num_nodes))));
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        imnodes::SetNodeGridSpacePos(
+            i,
+            ImVec2(
+                150.f * static_cast<float>(i % columns),
+                120.f * static_cast<float>(i / columns)));
+    }
+    return columns;
+}
+
+ChainFrameStats ChainFrame(const int num_nodes, const int num_group_nodes)
+{
+    const Timer timer;
+    HeadlessNewFrame(ImVec2(0.f, 0.f), false);
+
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+    imnodes::BeginNodeEditor();
+
+    ChainFrameStats stats = {0.0, 0, 0};
+    const bool zoomed_out = imnodes::IsEditorZoomedOut();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        if (imnodes::IsNodeCollapsed(i))
+        {
+            continue;
+        }
+        imnodes::BeginNode(i);
+        imnodes::BeginNodeTitleBar();
+        if (!zoomed_out)
+        {
+            ImGui::Text("node %d", i);
+        }
+        imnodes::EndNodeTitleBar();
+        imnodes::BeginInputAttribute(InputAttr(i));
+        if (!zoomed_out)
+        {
+            ImGui::Text("input");
+        }
+        imnodes::EndAttribute();
+        imnodes::BeginOutputAttribute(OutputAttr(i));
+        if (!zoomed_out)
+        {
+            ImGui::Text("output");
+        }
+        imnodes::EndAttribute();
+        imnodes::EndNode();
+        ++stats.nodes;
+    }
+
+    for (int i = 0; i < num_group_nodes; ++i)
+    {
+        imnodes::BeginNode(num_nodes + i);
+        imnodes::BeginNodeTitleBar();
+        if (!zoomed_out)
+        {
+            ImGui::Text("group %d", i);
+        }
+        imnodes::EndNodeTitleBar();
+        imnodes::EndNode();
+        ++stats.nodes;
+    }
+
+    for (int i = 0; i + 1 < num_nodes; ++i)
+    {
+        imnodes::Link(i, OutputAttr(i), InputAttr(i + 1));
+    }
+
+    imnodes::EndNodeEditor();
+    ImGui::End();
+
+    HeadlessEndFrame();
+
+    stats.ms = timer.elapsed_ms();
+    stats.vertices = ImGui::GetDrawData()->TotalVtxCount;
+    return stats;
+}
+
+ChainFrameStats MedianChainFrame(
+    const int num_nodes,
+    const int num_group_nodes,
+    const int frames)
+{
+    ChainFrame(num_nodes, num_group_nodes);
+
+    std::vector<double> samples;
+    ChainFrameStats stats = {0.0, 0, 0};
+    for (int i = 0; i < frames; ++i)
+    {
+        stats = ChainFrame(num_nodes, num_group_nodes);
+        samples.push_back(stats.ms);
+    }
+    stats.ms = Median(samples);
+    return stats;
+}
+
+double Median(std::vector<double>& samples)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    const size_t mid = samples.size() / 2;
+    std::nth_element(samples.begin(), samples.begin() + mid, samples.end());
+    return samples[mid];
+}
+
+double Percentile(std::vector<double>& samples, const double fraction)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    const size_t rank = std::min(
+        static_cast<size_t>(fraction * static_cast<double>(samples.size())),
+        samples.size() - 1);
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+} // namespace bench
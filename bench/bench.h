@@ -0,0 +1,162 @@
+#pragma once
+
+#include <imgui.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+// Creates an ImGui context which can run frames without a window or a
+// renderer, and an imnodes context on top of it.
+void HeadlessInitialize(const ImVec2& display_size);
+void HeadlessShutdown();
+
+// Starts a new ImGui frame with the mouse at mouse_pos. The left mouse button
+// is held down while left_mouse_down is true.
+void HeadlessNewFrame(const ImVec2& mouse_pos, bool left_mouse_down);
+void HeadlessEndFrame();
+
+class Timer
+{
+public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    double elapsed_ms() const
+    {
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start_;
+        return elapsed.count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// A minimal thread pool which implements imnodes::IO::ParallelFor. The calling
+// thread takes part in running the jobs, so a pool of size one runs
+// everything on the calling thread.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Matches the signature of imnodes::IO::ParallelFor::run. user_data must
+    // point to the ThreadPool.
+    static void parallel_for(
+        void (*job)(int job_idx, void* job_data),
+        int job_count,
+        void* job_data,
+        void* user_data);
+
+private:
+    void worker_loop();
+    void run_jobs();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+
+    // The current batch of jobs. Protected by mutex_.
+    void (*job_)(int, void*);
+    void* job_data_;
+    int job_count_;
+    int next_job_;
+    int jobs_remaining_;
+    unsigned generation_;
+    bool quit_;
+};
+
+// The attributes of node i in the synthetic graphs.
+inline int InputAttr(const int node) { return node << 1; }
+inline int OutputAttr(const int node) { return (node << 1) | 1; }
+
+struct Graph
+{
+    struct Link
+    {
+        int id;
+        int start_attr, end_attr;
+    };
+
+    int num_nodes;
+    std::vector<Link> links;
+};
+
+// Places the nodes of the current editor on a grid which covers the rect from
+// origin to origin + extent, jittered within their cells if jitter is true.
+// Each link connects a node to one of its neighbours on the grid. The graph
+// is the same for the same arguments.
+Graph MakeGraph(
+    int num_nodes,
+    int num_links,
+    const ImVec2& origin,
+    const ImVec2& extent,
+    bool jitter);
+// Submits the graph's nodes, each with a small input and output attribute,
+// and its links. Call between BeginNodeEditor() and EndNodeEditor().
+void SubmitGraph(const Graph& graph);
+
+// Places nodes 0 to num_nodes - 1 of the current editor on a square grid, 150
+// by 120 units apart. Returns the number of columns.
+int PlaceNodesOnSquareGrid(int num_nodes);
+
+struct ChainFrameStats
+{
+    double ms;
+    // The number of nodes submitted, including the group nodes.
+    int nodes;
+    int vertices;
+};
+
+// Runs a whole frame of a chain of num_nodes nodes, in which each node is
+// linked to the next. The node contents are skipped while the editor is
+// zoomed out, as the host is expected to do. Collapsed nodes are skipped
+// altogether, and num_group_nodes group nodes, whose ids follow the node ids,
+// are submitted after the chain.
+ChainFrameStats ChainFrame(int num_nodes, int num_group_nodes);
+// Runs a first frame, which measures the nodes or moves them to their zoomed
+// out positions, and then the given number of frames. Returns the median
+// frame time, along with the counts of the last frame.
+ChainFrameStats MedianChainFrame(
+    int num_nodes,
+    int num_group_nodes,
+    int frames);
+
+// Returns the median of the samples. Reorders the samples.
+double Median(std::vector<double>& samples);
+// Returns the sample below which the fraction of the samples lie, e.g. 0.99
+// for the 99th percentile. Reorders the samples.
+double Percentile(std::vector<double>& samples, double fraction);
+
+// The benchmarks. Each one prints its own results to stdout.
+void BoxSelectionBenchmark(int num_nodes, int num_links);
+// Runs the 1k and 10k node DAGs if num_nodes is zero.
+void LayoutBenchmark(int num_nodes);
+// Runs 1k, 10k and 50k nodes if num_nodes is zero.
+void OverlapBenchmark(int num_nodes);
+// Runs 1k, 10k and 50k nodes if num_nodes is zero.
+void ZoomBenchmark(int num_nodes);
+// Runs 10k and 100k nodes if num_nodes is zero.
+void GroupsBenchmark(int num_nodes, int group_size);
+// Runs the scans over 10k, 200k and 1M nodes, and the editor over 10k and
+// 200k nodes, if num_nodes is zero.
+void HotDataBenchmark(int num_nodes);
+// Returns false if the links drawn in parallel differ from the links drawn
+// serially.
+bool LinksBenchmark(int num_nodes, int num_links);
+void FrameBenchmark(
+    int num_nodes,
+    int num_links,
+    int selected_percent,
+    int visible_percent,
+    int frames);
+} // namespace bench
@@ -0,0 +1,215 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <stdio.h>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+// Returns the time spent in EndNodeEditor(), in milliseconds.
+double show_graph(const Graph& graph, const ImVec2& display_size)
+{
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(display_size);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+    imnodes::BeginNodeEditor();
+
+    // ImDrawList skips fully transparent curves, so the links aren't
+    // tessellated. This keeps the link rendering cost out of the measurement,
+    // while the links are still hit tested by the box selector.
+    imnodes::PushColorStyle(imnodes::ColorStyle_Link, 0u);
+    imnodes::PushColorStyle(imnodes::ColorStyle_LinkHovered, 0u);
+    imnodes::PushColorStyle(imnodes::ColorStyle_LinkSelected, 0u);
+
+    SubmitGraph(graph);
+
+    imnodes::PopColorStyle();
+    imnodes::PopColorStyle();
+    imnodes::PopColorStyle();
+
+    const Timer timer;
+    imnodes::EndNodeEditor();
+    const double elapsed = timer.elapsed_ms();
+
+    ImGui::End();
+    return elapsed;
+}
+
+struct Result
+{
+    double idle_ms;
+    double selecting_ms;
+    int num_selected_nodes;
+    int num_selected_links;
+    unsigned selection_hash;
+};
+
+unsigned hash_selection()
+{
+    std::vector<int> ids(imnodes::NumSelectedNodes());
+    if (!ids.empty())
+    {
+        imnodes::GetSelectedNodes(ids.data());
+    }
+    ids.resize(ids.size() + imnodes::NumSelectedLinks());
+    if (imnodes::NumSelectedLinks() > 0)
+    {
+        imnodes::GetSelectedLinks(ids.data() + imnodes::NumSelectedNodes());
+    }
+
+    unsigned hash = 2166136261u;
+    for (const int id : ids)
+    {
+        hash = (hash ^ static_cast<unsigned>(id)) * 16777619u;
+    }
+    return hash;
+}
+
+// Runs a single frame, and returns the time spent in EndNodeEditor().
+double frame(const Graph& graph, const ImVec2& mouse_pos, const bool mouse_down)
+{
+    HeadlessNewFrame(mouse_pos, mouse_down);
+    const double elapsed = show_graph(graph, ImGui::GetIO().DisplaySize);
+    HeadlessEndFrame();
+    return elapsed;
+}
+
+// Clicks the empty canvas at box_start, which clears the previous selection,
+// and presses the mouse down again to start a new box selection.
+void start_box_selection(const Graph& graph, const ImVec2& box_start)
+{
+    frame(graph, box_start, true);
+    frame(graph, box_start, false);
+    frame(graph, box_start, true);
+}
+
+Result run(const Graph& graph, const int frames)
+{
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+    Result result;
+
+    // Time dragging the box selector along the empty margin at the top of the
+    // canvas. Every node and link is tested against the box, but nothing ends
+    // up being selected, so the cost of drawing the selection doesn't change
+    // between the measured frames. Once the mouse is released, the box
+    // selector is no longer updated, so the difference is the cost of box
+    // selection.
+    {
+        const ImVec2 box_end(display_size.x - 12.f, 60.f);
+        start_box_selection(graph, ImVec2(12.f, 12.f));
+
+        std::vector<double> selecting, idle;
+        for (int i = 0; i < frames; ++i)
+        {
+            selecting.push_back(frame(graph, box_end, true));
+        }
+        for (int i = 0; i < frames; ++i)
+        {
+            idle.push_back(frame(graph, box_end, false));
+        }
+        result.idle_ms = Median(idle);
+        result.selecting_ms = Median(selecting);
+    }
+
+    // Then select a narrow box in the middle of the canvas, which overlaps
+    // some of the nodes and links.
+    {
+        const float center_x = 0.5f * display_size.x;
+        start_box_selection(graph, ImVec2(center_x - 50.f, 12.f));
+        frame(graph, ImVec2(center_x + 50.f, 0.5f * display_size.y), false);
+
+        result.num_selected_nodes = imnodes::NumSelectedNodes();
+        result.num_selected_links = imnodes::NumSelectedLinks();
+        result.selection_hash = hash_selection();
+    }
+
+    return result;
+}
+
+void print_result(const char* label, const Result& result, const double base)
+{
+    const double box_ms = result.selecting_ms - result.idle_ms;
+    printf(
+        "%-10s %12.3f %12.3f %12.3f %8.2fx %8d %8d %08x\n",
+        label,
+        result.idle_ms,
+        result.selecting_ms,
+        box_ms,
+        base > 0.0 ? base / box_ms : 1.0,
+        result.num_selected_nodes,
+        result.num_selected_links,
+        result.selection_hash);
+}
+} // namespace
+
+// Measures how box selection scales with the number of threads used by
+// imnodes::IO::ParallelFor. The box selection cost is the difference between
+// the median EndNodeEditor() time while dragging the box selector, and after
+// releasing it. The selection of a second, smaller box is checked afterwards:
+// the selection hash must be the same for every thread count.
+void BoxSelectionBenchmark(const int num_nodes, const int num_links)
+{
+    const ImVec2 display_size(1920.f, 1080.f);
+    const int frames = 15;
+
+    HeadlessInitialize(display_size);
+    // The nodes cover the canvas, apart from a margin around its edges.
+    const float margin = 80.f;
+    const Graph graph = MakeGraph(
+        num_nodes,
+        num_links,
+        ImVec2(margin, margin),
+        ImVec2(display_size.x - 2.f * margin, display_size.y - 2.f * margin),
+        true);
+
+    // Warm up, so that all nodes have been measured.
+    for (int i = 0; i < 2; ++i)
+    {
+        frame(graph, ImVec2(0.f, 0.f), false);
+    }
+
+    printf(
+        "box selection: %d nodes, %d links, %d frames\n",
+        num_nodes,
+        num_links,
+        frames);
+    printf(
+        "%-10s %12s %12s %12s %9s %8s %8s %8s\n",
+        "threads",
+        "idle ms",
+        "selecting ms",
+        "box ms",
+        "speedup",
+        "nodes",
+        "links",
+        "hash");
+
+    imnodes::IO& io = imnodes::GetIO();
+    io.parallel_for.run = nullptr;
+    const Result serial = run(graph, frames);
+    print_result("serial", serial, 0.0);
+
+    const double serial_box_ms = serial.selecting_ms - serial.idle_ms;
+    const int thread_counts[] = {1, 2, 4, 8};
+    for (const int num_threads : thread_counts)
+    {
+        ThreadPool pool(num_threads);
+        io.parallel_for.run = ThreadPool::parallel_for;
+        io.parallel_for.user_data = &pool;
+        io.parallel_for.min_elements = 0;
+
+        char label[16];
+        snprintf(label, sizeof(label), "%d", num_threads);
+        print_result(label, run(graph, frames), serial_box_ms);
+
+        io.parallel_for.run = nullptr;
+        io.parallel_for.user_data = nullptr;
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
@@ -0,0 +1,254 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+enum Phase
+{
+    Phase_Begin,
+    Phase_Nodes,
+    Phase_Links,
+    Phase_End,
+    Phase_Render,
+    Phase_Count
+};
+
+const char* const phase_names[Phase_Count] = {
+    "BeginNodeEditor",
+    "nodes",
+    "links",
+    "EndNodeEditor",
+    "ImGui::Render"};
+
+struct Samples
+{
+    std::vector<double> ms[Phase_Count];
+    std::vector<double> total_ms;
+    int vertices;
+    int indices;
+    int commands;
+};
+
+// Runs a single frame, and times each of its phases.
+void frame(
+    const Graph& graph,
+    const ImVec2& mouse_pos,
+    const bool mouse_down,
+    Samples* const samples)
+{
+    double ms[Phase_Count];
+    const Timer frame_timer;
+
+    HeadlessNewFrame(mouse_pos, mouse_down);
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+
+    Timer timer;
+    imnodes::BeginNodeEditor();
+    ms[Phase_Begin] = timer.elapsed_ms();
+
+    timer = Timer();
+    const bool zoomed_out = imnodes::IsEditorZoomedOut();
+    for (int i = 0; i < graph.num_nodes; ++i)
+    {
+        imnodes::BeginNode(i);
+        imnodes::BeginNodeTitleBar();
+        if (!zoomed_out)
+        {
+            ImGui::TextUnformatted("node");
+        }
+        imnodes::EndNodeTitleBar();
+        imnodes::BeginInputAttribute(InputAttr(i));
+        ImGui::Dummy(ImVec2(60.f, 10.f));
+        imnodes::EndAttribute();
+        imnodes::BeginOutputAttribute(OutputAttr(i));
+        ImGui::Dummy(ImVec2(60.f, 10.f));
+        imnodes::EndAttribute();
+        imnodes::EndNode();
+    }
+    ms[Phase_Nodes] = timer.elapsed_ms();
+
+    timer = Timer();
+    for (const Graph::Link& link : graph.links)
+    {
+        imnodes::Link(link.id, link.start_attr, link.end_attr);
+    }
+    ms[Phase_Links] = timer.elapsed_ms();
+
+    timer = Timer();
+    imnodes::EndNodeEditor();
+    ms[Phase_End] = timer.elapsed_ms();
+
+    ImGui::End();
+
+    timer = Timer();
+    HeadlessEndFrame();
+    ms[Phase_Render] = timer.elapsed_ms();
+
+    if (samples != nullptr)
+    {
+        for (int i = 0; i < Phase_Count; ++i)
+        {
+            samples->ms[i].push_back(ms[i]);
+        }
+        samples->total_ms.push_back(frame_timer.elapsed_ms());
+
+        const ImDrawData* const draw_data = ImGui::GetDrawData();
+        samples->vertices = draw_data->TotalVtxCount;
+        samples->indices = draw_data->TotalIdxCount;
+        samples->commands = 0;
+        for (int i = 0; i < draw_data->CmdListsCount; ++i)
+        {
+            samples->commands += draw_data->CmdLists[i]->CmdBuffer.Size;
+        }
+    }
+}
+
+// Zooms out until the whole graph is visible, and box selects the nodes in
+// the leftmost selected_fraction of it, along with the links between them.
+// Then goes back to a zoom of 1, with the top left corner of the graph in
+// view.
+void select_nodes(const Graph& graph, const float selected_fraction)
+{
+    frame(graph, ImVec2(0.f, 0.f), false, nullptr);
+    imnodes::EditorContextFitToContent();
+    frame(graph, ImVec2(0.f, 0.f), false, nullptr);
+
+    if (selected_fraction > 0.f)
+    {
+        // The fitted graph is centered in the canvas, which is inset by the
+        // window padding, so the box selector starts at the empty margin.
+        const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+        const float padding = ImGui::GetStyle().WindowPadding.x;
+        const float canvas_width = display_size.x - 2.f * padding;
+        const ImVec2 panning = imnodes::EditorContextGetPanning();
+        const float graph_width = canvas_width - 2.f * panning.x;
+        const ImVec2 box_start(padding + 2.f, padding + 2.f);
+        const ImVec2 box_end(
+            padding + panning.x + selected_fraction * graph_width,
+            display_size.y - padding - 2.f);
+
+        frame(graph, box_start, true, nullptr);
+        frame(graph, box_end, true, nullptr);
+        frame(graph, box_end, false, nullptr);
+    }
+
+    imnodes::EditorContextSetZoom(1.f, ImVec2(0.f, 0.f));
+    imnodes::EditorContextResetPanning(ImVec2(0.f, 0.f));
+}
+
+void print_phase(const char* const name, std::vector<double>& ms)
+{
+    printf(
+        "  %-16s %10.3f %10.3f %10.3f %10.3f\n",
+        name,
+        Percentile(ms, 0.5),
+        Percentile(ms, 0.9),
+        Percentile(ms, 0.99),
+        Percentile(ms, 1.0));
+}
+} // namespace
+
+// Times the phases of whole frames of a synthetic graph, while the mouse
+// sweeps across the canvas, and reports their percentiles along with the
+// size of the draw data.
+void FrameBenchmark(
+    const int num_nodes,
+    const int num_links,
+    const int selected_percent,
+    const int visible_percent,
+    const int frames)
+{
+    HeadlessInitialize(ImVec2(1920.f, 1080.f));
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+
+    const float visible_fraction =
+        std::min(std::max(visible_percent, 1), 100) / 100.f;
+    const float selected_fraction =
+        std::min(std::max(selected_percent, 0), 100) / 100.f;
+    // The nodes cover visible_fraction of the canvas's area at a zoom of 1.
+    const Graph graph = MakeGraph(
+        num_nodes,
+        num_links,
+        ImVec2(0.f, 0.f),
+        ImVec2(
+            display_size.x / sqrtf(visible_fraction),
+            display_size.y / sqrtf(visible_fraction)),
+        false);
+    select_nodes(graph, selected_fraction);
+
+    // Warm up, so that the pools and the draw lists have grown to their final
+    // sizes.
+    for (int i = 0; i < 10; ++i)
+    {
+        frame(graph, ImVec2(0.f, 0.f), false, nullptr);
+    }
+
+    // The mouse moves back and forth along the diagonal of the canvas, which
+    // hovers over nodes, pins and links along the way.
+    Samples samples;
+    for (int i = 0; i < frames; ++i)
+    {
+        const float t = fabsf(fmodf(i / 120.f, 2.f) - 1.f);
+        frame(
+            graph,
+            ImVec2(t * display_size.x, t * display_size.y),
+            false,
+            &samples);
+    }
+
+    printf(
+        "frame: %d nodes, %d links, %d selected, %d%% visible, %d frames\n",
+        num_nodes,
+        num_links,
+        imnodes::NumSelectedNodes(),
+        static_cast<int>(visible_fraction * 100.f + 0.5f),
+        frames);
+    printf(
+        "  %-16s %10s %10s %10s %10s\n", "phase", "p50 ms", "p90", "p99", "max");
+    for (int i = 0; i < Phase_Count; ++i)
+    {
+        print_phase(phase_names[i], samples.ms[i]);
+    }
+    print_phase("frame", samples.total_ms);
+    printf(
+        "  last frame: %d vertices, %d indices, %d draw commands\n",
+        samples.vertices,
+        samples.indices,
+        samples.commands);
+
+    // Only collected when imnodes.cpp is compiled with IMNODES_ENABLE_STATS.
+    const imnodes::FrameStats& stats = imnodes::GetFrameStats();
+    if (stats.nodes_submitted > 0)
+    {
+        printf(
+            "  last frame stats: %d/%d nodes, %d/%d pins, %d/%d links drawn, "
+            "%d hover and %d render bezier segments\n",
+            stats.nodes_drawn,
+            stats.nodes_submitted,
+            stats.pins_drawn,
+            stats.pins_submitted,
+            stats.links_drawn,
+            stats.links_submitted,
+            stats.hover_bezier_segments,
+            stats.render_bezier_segments);
+        printf(
+            "  update %.3f ms, draw %.3f ms, interaction %.3f ms\n",
+            stats.update_ms,
+            stats.draw_ms,
+            stats.interaction_ms);
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
@@ -0,0 +1,96 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <stdio.h>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+void run(const int num_nodes, const int group_size, const int frames)
+{
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::EditorContextSet(editor);
+
+    PlaceNodesOnSquareGrid(num_nodes);
+
+    const ChainFrameStats expanded = MedianChainFrame(num_nodes, 0, frames);
+
+    // The first group_size nodes, in the top left corner, stay expanded, and
+    // the rest are collapsed into groups of group_size consecutive nodes.
+    const int num_groups = (num_nodes - 1) / group_size;
+    const Timer collapse_timer;
+    std::vector<int> members;
+    for (int i = 0; i < num_groups; ++i)
+    {
+        members.clear();
+        const int begin = (i + 1) * group_size;
+        for (int node = begin;
+             node < num_nodes && node < begin + group_size;
+             ++node)
+        {
+            members.push_back(node);
+        }
+        imnodes::CollapseNodeGroup(
+            num_nodes + i, members.data(), static_cast<int>(members.size()));
+    }
+
+    const double collapse_ms = collapse_timer.elapsed_ms();
+    // The collapsed nodes are skipped, and the group nodes are submitted in
+    // their place. The first frame drops the collapsed nodes.
+    const ChainFrameStats collapsed =
+        MedianChainFrame(num_nodes, num_groups, frames);
+
+    printf(
+        "%-8d %8d %12.3f %12.3f %12d %12.3f %12d %12d\n",
+        num_nodes,
+        num_groups,
+        collapse_ms,
+        expanded.ms,
+        expanded.vertices,
+        collapsed.ms,
+        collapsed.vertices,
+        collapsed.nodes);
+
+    imnodes::EditorContextSet(nullptr);
+    imnodes::EditorContextFree(editor);
+}
+} // namespace
+
+// Times whole frames with all of the nodes expanded, and with all but the
+// first group_size nodes collapsed into groups of group_size nodes. Only the
+// visible nodes are drawn either way, but every expanded node is laid out.
+void GroupsBenchmark(const int num_nodes, const int group_size)
+{
+    const int frames = 7;
+
+    HeadlessInitialize(ImVec2(1920.f, 1080.f));
+
+    printf("groups of %d nodes: median frame of %d\n", group_size, frames);
+    printf(
+        "%-8s %8s %12s %12s %12s %12s %12s %12s\n",
+        "nodes",
+        "groups",
+        "collapse ms",
+        "expanded ms",
+        "vertices",
+        "collapsed ms",
+        "vertices",
+        "submitted");
+
+    if (num_nodes > 0)
+    {
+        run(num_nodes, group_size, frames);
+    }
+    else
+    {
+        run(10000, group_size, frames);
+        run(100000, group_size, frames);
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
@@ -0,0 +1,381 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+struct Rect
+{
+    ImVec2 min, max;
+
+    bool overlaps(const Rect& other) const
+    {
+        return other.min.y < max.y && other.max.y > min.y &&
+               other.min.x < max.x && other.max.x > min.x;
+    }
+};
+
+// The records mirror the layout of imnodes' NodeData and PinData when the
+// screen space node rect and pin position were stored inline, so that a scan
+// over the geometry strides over all of the other fields too.
+struct NodeRecord
+{
+    int id;
+    ImVec2 origin;
+    Rect title_bar_content_rect;
+    Rect rect;
+    ImVec2 grid_space_size;
+    ImU16 style_idx;
+    int pin_index_begin, pin_index_end;
+    bool draggable;
+    bool geometry_in_grid_space;
+};
+
+struct PinRecord
+{
+    int id;
+    int parent_node_idx;
+    Rect attribute_rect;
+    int type;
+    int shape;
+    ImVec2 pos;
+    int flags;
+    ImU16 style_idx;
+};
+
+// The scans return a value derived from every element, so that they can't be
+// optimized away.
+template<typename Rects>
+int count_overlaps(const Rects& rects, const Rect& box)
+{
+    int count = 0;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        count += box.overlaps(rects[i]) ? 1 : 0;
+    }
+    return count;
+}
+
+template<typename Points>
+int find_nearest(const Points& points, const ImVec2& mouse_pos)
+{
+    int nearest = -1;
+    float nearest_dist_sqr = FLT_MAX;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const ImVec2 d(points[i].x - mouse_pos.x, points[i].y - mouse_pos.y);
+        const float dist_sqr = d.x * d.x + d.y * d.y;
+        if (dist_sqr < nearest_dist_sqr)
+        {
+            nearest_dist_sqr = dist_sqr;
+            nearest = static_cast<int>(i);
+        }
+    }
+    return nearest;
+}
+
+// Presents the rect or the position of the records as an array, so that the
+// same scans run over both layouts.
+struct NodeRects
+{
+    const std::vector<NodeRecord>& nodes;
+    size_t size() const { return nodes.size(); }
+    const Rect& operator[](const size_t i) const { return nodes[i].rect; }
+};
+
+struct PinPositions
+{
+    const std::vector<PinRecord>& pins;
+    size_t size() const { return pins.size(); }
+    const ImVec2& operator[](const size_t i) const { return pins[i].pos; }
+};
+
+template<typename Scan>
+double median_ns_per_element(const Scan& scan, const size_t num_elements)
+{
+    const int runs = 21;
+    std::vector<double> samples;
+    int checksum = 0;
+    for (int i = 0; i < runs; ++i)
+    {
+        const Timer timer;
+        checksum += scan();
+        samples.push_back(timer.elapsed_ms() * 1e6 / num_elements);
+    }
+    // Keeps the results alive.
+    if (checksum == -1)
+    {
+        printf("\n");
+    }
+    return Median(samples);
+}
+
+void print_scan(
+    const char* label,
+    const size_t aos_stride,
+    const double aos_ns,
+    const size_t soa_stride,
+    const double soa_ns)
+{
+    printf(
+        "%-14s %10d %10.3f %10d %10.3f %8.2fx\n",
+        label,
+        static_cast<int>(aos_stride),
+        aos_ns,
+        static_cast<int>(soa_stride),
+        soa_ns,
+        aos_ns / soa_ns);
+}
+
+// Times the scans which only test geometry over the two layouts. The nodes
+// are scattered over a large canvas, and the box and the canvas only overlap
+// a few of them, as when box selecting or culling a large graph.
+void run_scans(const int num_nodes)
+{
+    const int num_pins = 2 * num_nodes;
+    const float extent = 100.f * sqrtf(static_cast<float>(num_nodes));
+
+    std::mt19937 rng(1234u);
+    std::uniform_real_distribution<float> pos_dist(0.f, extent);
+
+    std::vector<NodeRecord> node_records(num_nodes);
+    std::vector<Rect> node_rects(num_nodes);
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        const ImVec2 min(pos_dist(rng), pos_dist(rng));
+        const Rect rect = {min, ImVec2(min.x + 80.f, min.y + 60.f)};
+        node_records[i] = NodeRecord();
+        node_records[i].id = i;
+        node_records[i].rect = rect;
+        node_rects[i] = rect;
+    }
+
+    std::vector<PinRecord> pin_records(num_pins);
+    std::vector<ImVec2> pin_positions(num_pins);
+    for (int i = 0; i < num_pins; ++i)
+    {
+        const Rect& rect = node_rects[i / 2];
+        const ImVec2 pos(
+            i % 2 == 0 ? rect.min.x : rect.max.x,
+            0.5f * (rect.min.y + rect.max.y));
+        pin_records[i] = PinRecord();
+        pin_records[i].id = i;
+        pin_records[i].pos = pos;
+        pin_positions[i] = pos;
+    }
+
+    const ImVec2 center(0.5f * extent, 0.5f * extent);
+    const Rect box = {center, ImVec2(center.x + 400.f, center.y + 300.f)};
+    const Rect canvas = {
+        ImVec2(center.x - 960.f, center.y - 540.f),
+        ImVec2(center.x + 960.f, center.y + 540.f)};
+
+    const NodeRects aos_rects = {node_records};
+    const PinPositions aos_positions = {pin_records};
+
+    printf("%d nodes, %d pins\n", num_nodes, num_pins);
+    print_scan(
+        "box selection",
+        sizeof(NodeRecord),
+        median_ns_per_element(
+            [&] { return count_overlaps(aos_rects, box); }, num_nodes),
+        sizeof(Rect),
+        median_ns_per_element(
+            [&] { return count_overlaps(node_rects, box); }, num_nodes));
+    print_scan(
+        "culling",
+        sizeof(NodeRecord),
+        median_ns_per_element(
+            [&] { return count_overlaps(aos_rects, canvas); }, num_nodes),
+        sizeof(Rect),
+        median_ns_per_element(
+            [&] { return count_overlaps(node_rects, canvas); }, num_nodes));
+    print_scan(
+        "pin picking",
+        sizeof(PinRecord),
+        median_ns_per_element(
+            [&] { return find_nearest(aos_positions, center); }, num_pins),
+        sizeof(ImVec2),
+        median_ns_per_element(
+            [&] { return find_nearest(pin_positions, center); }, num_pins));
+}
+
+// Accumulates the time spent in the box selection zone.
+struct ZoneTimer
+{
+    Timer timer;
+    double begin_ms;
+    double total_ms;
+};
+
+void begin_zone(const char* const name, void* const user_data)
+{
+    ZoneTimer& zone = *static_cast<ZoneTimer*>(user_data);
+    if (strcmp(name, "box_selector_update_selection") == 0)
+    {
+        zone.begin_ms = zone.timer.elapsed_ms();
+    }
+}
+
+void end_zone(const char* const name, void* const user_data)
+{
+    ZoneTimer& zone = *static_cast<ZoneTimer*>(user_data);
+    if (strcmp(name, "box_selector_update_selection") == 0)
+    {
+        zone.total_ms += zone.timer.elapsed_ms() - zone.begin_ms;
+    }
+}
+
+void show_nodes(
+    const int num_nodes,
+    const ImVec2& mouse_pos,
+    const bool mouse_down)
+{
+    HeadlessNewFrame(mouse_pos, mouse_down);
+
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+    imnodes::BeginNodeEditor();
+
+    const bool zoomed_out = imnodes::IsEditorZoomedOut();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        imnodes::BeginNode(i);
+        if (!zoomed_out)
+        {
+            ImGui::Dummy(ImVec2(40.f, 30.f));
+        }
+        imnodes::EndNode();
+    }
+
+    imnodes::EndNodeEditor();
+    ImGui::End();
+
+    HeadlessEndFrame();
+}
+
+// Times the editor's own box selection over the nodes, zoomed out so that all
+// of them are laid out without drawing their contents. The box is dragged
+// along the empty margin at the top of the canvas, so that the selection stays
+// empty and only the scan is measured.
+void run_editor(const int num_nodes)
+{
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::EditorContextSet(editor);
+
+    const int columns =
+        static_cast<int>(ceilf(sqrtf(static_cast<float>(num_nodes))));
+    const float margin = 0.05f * 150.f * static_cast<float>(columns);
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        imnodes::SetNodeGridSpacePos(
+            i,
+            ImVec2(
+                margin + 150.f * static_cast<float>(i % columns),
+                margin + 120.f * static_cast<float>(i / columns)));
+    }
+    show_nodes(num_nodes, ImVec2(0.f, 0.f), false);
+
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+    imnodes::EditorContextSetZoom(
+        std::min(display_size.x, display_size.y) /
+            (150.f * static_cast<float>(columns) + 2.f * margin),
+        ImVec2(0.f, 0.f));
+    show_nodes(num_nodes, ImVec2(0.f, 0.f), false);
+
+    ZoneTimer zone;
+    zone.begin_ms = 0.0;
+    zone.total_ms = 0.0;
+    imnodes::IO& io = imnodes::GetIO();
+    io.profiler.begin_zone = begin_zone;
+    io.profiler.end_zone = end_zone;
+    io.profiler.user_data = &zone;
+
+    // The first click only moves the mouse over the canvas.
+    const ImVec2 box_start(12.f, 12.f);
+    const ImVec2 box_end(display_size.x - 12.f, 20.f);
+    show_nodes(num_nodes, box_start, true);
+    show_nodes(num_nodes, box_start, false);
+    show_nodes(num_nodes, box_start, true);
+    const int frames = 15;
+    std::vector<double> samples;
+    for (int i = 0; i < frames; ++i)
+    {
+        zone.total_ms = 0.0;
+        show_nodes(num_nodes, box_end, true);
+        samples.push_back(zone.total_ms);
+    }
+    show_nodes(num_nodes, box_end, false);
+
+    io.profiler.begin_zone = nullptr;
+    io.profiler.end_zone = nullptr;
+    io.profiler.user_data = nullptr;
+
+    const double box_ms = Median(samples);
+    printf(
+        "%-8d %12.3f %12.3f\n",
+        num_nodes,
+        box_ms,
+        box_ms * 1e6 / num_nodes);
+
+    imnodes::EditorContextSet(nullptr);
+    imnodes::EditorContextFree(editor);
+}
+} // namespace
+
+// Compares scanning the node rects and the pin positions when they are stored
+// inline in the node and pin records, and in arrays of their own, as imnodes
+// stores them. The bytes per element is the stride of the scan: every cache
+// line which holds an element's geometry is brought in whole, so the scans over
+// the records read several times more memory. Then times the editor's box
+// selection, which scans the node rects.
+void HotDataBenchmark(const int num_nodes)
+{
+    HeadlessInitialize(ImVec2(1920.f, 1080.f));
+
+    printf("hot data: median over 21 scans\n");
+    printf(
+        "%-14s %10s %10s %10s %10s %9s\n",
+        "scan",
+        "aos bytes",
+        "aos ns",
+        "soa bytes",
+        "soa ns",
+        "speedup");
+    if (num_nodes > 0)
+    {
+        run_scans(num_nodes);
+    }
+    else
+    {
+        run_scans(10000);
+        run_scans(200000);
+        run_scans(1000000);
+    }
+
+    printf("\neditor box selection: median of 15 frames\n");
+    printf("%-8s %12s %12s\n", "nodes", "box ms", "ns per node");
+    if (num_nodes > 0)
+    {
+        run_editor(num_nodes);
+    }
+    else
+    {
+        run_editor(10000);
+        run_editor(200000);
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
@@ -0,0 +1,183 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+struct Dag
+{
+    struct Link
+    {
+        int id;
+        int start_node, end_node;
+    };
+
+    int num_nodes;
+    std::vector<Link> links;
+};
+
+// Adds a node with one or two incoming links. Most links come from the
+// previous nodes, which makes for a long and narrow DAG with some long links.
+void add_node(Dag& dag, std::mt19937& rng)
+{
+    const int node = dag.num_nodes++;
+    if (node == 0)
+    {
+        return;
+    }
+
+    std::uniform_int_distribution<int> num_links_dist(1, 2);
+    std::uniform_int_distribution<int> distance_dist(1, 40);
+    const int num_links = num_links_dist(rng);
+    for (int i = 0; i < num_links; ++i)
+    {
+        const int start = std::max(node - distance_dist(rng), 0);
+        dag.links.push_back({static_cast<int>(dag.links.size()), start, node});
+    }
+}
+
+void show_dag(const Dag& dag)
+{
+    HeadlessNewFrame(ImVec2(0.f, 0.f), false);
+
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+    imnodes::BeginNodeEditor();
+
+    for (int i = 0; i < dag.num_nodes; ++i)
+    {
+        imnodes::BeginNode(i);
+        imnodes::BeginInputAttribute(InputAttr(i));
+        ImGui::Dummy(ImVec2(60.f + (i % 3) * 20.f, 10.f));
+        imnodes::EndAttribute();
+        imnodes::BeginOutputAttribute(OutputAttr(i));
+        ImGui::Dummy(ImVec2(60.f, 10.f + (i % 2) * 20.f));
+        imnodes::EndAttribute();
+        imnodes::EndNode();
+    }
+
+    for (const Dag::Link& link : dag.links)
+    {
+        imnodes::Link(
+            link.id, OutputAttr(link.start_node), InputAttr(link.end_node));
+    }
+
+    imnodes::EndNodeEditor();
+    ImGui::End();
+
+    HeadlessEndFrame();
+}
+
+// Returns the number of links which don't point from left to right.
+int count_backward_links(const Dag& dag)
+{
+    int count = 0;
+    for (const Dag::Link& link : dag.links)
+    {
+        if (imnodes::GetNodeGridSpacePos(link.start_node).x >=
+            imnodes::GetNodeGridSpacePos(link.end_node).x)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void run(const int num_nodes, const int runs)
+{
+    // Each run gets its own editor context, so that the runs don't share any
+    // nodes.
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::EditorContextSet(editor);
+
+    std::mt19937 rng(1234u);
+    Dag dag;
+    dag.num_nodes = 0;
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        add_node(dag, rng);
+    }
+    // Submit the graph, so that the nodes get measured.
+    show_dag(dag);
+
+    std::vector<double> full;
+    for (int i = 0; i < runs; ++i)
+    {
+        const Timer timer;
+        imnodes::LayoutCurrentEditor();
+        full.push_back(timer.elapsed_ms());
+    }
+    const int backward_links = count_backward_links(dag);
+
+    // Add a few nodes at a time, and only lay out the affected layers.
+    const int nodes_per_update = 5;
+    std::vector<double> incremental;
+    for (int i = 0; i < runs; ++i)
+    {
+        for (int j = 0; j < nodes_per_update; ++j)
+        {
+            add_node(dag, rng);
+        }
+        show_dag(dag);
+
+        const Timer timer;
+        imnodes::UpdateCurrentEditorLayout();
+        incremental.push_back(timer.elapsed_ms());
+    }
+    const int incremental_backward_links = count_backward_links(dag);
+
+    printf(
+        "%-8d %8d %12.3f %16.3f %10d %10d\n",
+        num_nodes,
+        static_cast<int>(dag.links.size()),
+        Median(full),
+        Median(incremental),
+        backward_links,
+        incremental_backward_links);
+
+    imnodes::EditorContextSet(nullptr);
+    imnodes::EditorContextFree(editor);
+}
+} // namespace
+
+// Times the full layered layout of random DAGs, and the incremental layout
+// after adding a handful of nodes. The links of a DAG should all point from
+// left to right after either layout.
+void LayoutBenchmark(const int num_nodes)
+{
+    const int runs = 7;
+
+    HeadlessInitialize(ImVec2(1920.f, 1080.f));
+
+    printf("layered layout: median of %d runs\n", runs);
+    printf(
+        "%-8s %8s %12s %16s %10s %10s\n",
+        "nodes",
+        "links",
+        "full ms",
+        "incremental ms",
+        "backward",
+        "backward+");
+
+    if (num_nodes > 0)
+    {
+        run(num_nodes, runs);
+    }
+    else
+    {
+        run(1000, runs);
+        run(10000, runs);
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
@@ -0,0 +1,227 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+// A copy of the draw data of a frame, which is compared between the serial
+// and the parallel link drawing.
+struct DrawDataCopy
+{
+    struct Command
+    {
+        ImVec4 clip_rect;
+        ImTextureID texture_id;
+        unsigned int vtx_offset;
+        unsigned int idx_offset;
+        unsigned int elem_count;
+    };
+
+    std::vector<ImDrawVert> vertices;
+    std::vector<ImDrawIdx> indices;
+    std::vector<Command> commands;
+};
+
+DrawDataCopy copy_draw_data()
+{
+    DrawDataCopy copy;
+    const ImDrawData* const draw_data = ImGui::GetDrawData();
+    for (int i = 0; i < draw_data->CmdListsCount; ++i)
+    {
+        const ImDrawList& draw_list = *draw_data->CmdLists[i];
+        copy.vertices.insert(
+            copy.vertices.end(),
+            draw_list.VtxBuffer.begin(),
+            draw_list.VtxBuffer.end());
+        copy.indices.insert(
+            copy.indices.end(),
+            draw_list.IdxBuffer.begin(),
+            draw_list.IdxBuffer.end());
+        for (const ImDrawCmd& cmd : draw_list.CmdBuffer)
+        {
+            copy.commands.push_back(
+                {cmd.ClipRect,
+                 cmd.TextureId,
+                 cmd.VtxOffset,
+                 cmd.IdxOffset,
+                 cmd.ElemCount});
+        }
+    }
+    return copy;
+}
+
+bool operator==(
+    const DrawDataCopy::Command& lhs,
+    const DrawDataCopy::Command& rhs)
+{
+    return memcmp(&lhs.clip_rect, &rhs.clip_rect, sizeof(ImVec4)) == 0 &&
+           lhs.texture_id == rhs.texture_id &&
+           lhs.vtx_offset == rhs.vtx_offset &&
+           lhs.idx_offset == rhs.idx_offset &&
+           lhs.elem_count == rhs.elem_count;
+}
+
+// The vertices are compared bitwise, so that the copies are only equal if the
+// parallel tessellation produces exactly the same floats.
+bool operator==(const DrawDataCopy& lhs, const DrawDataCopy& rhs)
+{
+    return lhs.vertices.size() == rhs.vertices.size() &&
+           memcmp(
+               lhs.vertices.data(),
+               rhs.vertices.data(),
+               lhs.vertices.size() * sizeof(ImDrawVert)) == 0 &&
+           lhs.indices == rhs.indices && lhs.commands == rhs.commands;
+}
+
+// Returns the time spent in EndNodeEditor(), in milliseconds.
+double frame(const Graph& graph, const bool transparent_links)
+{
+    HeadlessNewFrame(ImVec2(0.f, 0.f), false);
+
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+    imnodes::BeginNodeEditor();
+
+    // ImDrawList skips fully transparent curves, so none of the links emit
+    // any vertices.
+    if (transparent_links)
+    {
+        imnodes::PushColorStyle(imnodes::ColorStyle_Link, 0u);
+        imnodes::PushColorStyle(imnodes::ColorStyle_LinkHovered, 0u);
+        imnodes::PushColorStyle(imnodes::ColorStyle_LinkSelected, 0u);
+    }
+
+    SubmitGraph(graph);
+
+    if (transparent_links)
+    {
+        imnodes::PopColorStyle();
+        imnodes::PopColorStyle();
+        imnodes::PopColorStyle();
+    }
+
+    const Timer timer;
+    imnodes::EndNodeEditor();
+    const double elapsed = timer.elapsed_ms();
+
+    ImGui::End();
+    HeadlessEndFrame();
+    return elapsed;
+}
+
+// Returns the median EndNodeEditor() time, and copies the draw data of the
+// last frame.
+double run(
+    const Graph& graph,
+    const bool transparent_links,
+    const int frames,
+    DrawDataCopy& draw_data)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < frames; ++i)
+    {
+        samples.push_back(frame(graph, transparent_links));
+    }
+    draw_data = copy_draw_data();
+    return Median(samples);
+}
+} // namespace
+
+// Times EndNodeEditor(), where the links are drawn, as the links are
+// tessellated serially and in parallel through imnodes::IO::ParallelFor. The
+// draw data of every parallel run is checked against the serial run: the
+// vertices, indices and draw commands must be identical. The links are drawn
+// opaque, and then fully transparent, in which case none of them emit any
+// vertices.
+bool LinksBenchmark(const int num_nodes, const int num_links)
+{
+    const ImVec2 display_size(1920.f, 1080.f);
+    const int frames = 15;
+
+    HeadlessInitialize(display_size);
+    const float margin = 80.f;
+    const Graph graph = MakeGraph(
+        num_nodes,
+        num_links,
+        ImVec2(margin, margin),
+        ImVec2(display_size.x - 2.f * margin, display_size.y - 2.f * margin),
+        true);
+
+    // Warm up, so that all nodes have been measured.
+    for (int i = 0; i < 2; ++i)
+    {
+        frame(graph, false);
+    }
+
+    printf(
+        "links: %d nodes, %d links, %d frames\n", num_nodes, num_links, frames);
+    printf(
+        "%-12s %-8s %12s %9s %10s %10s\n",
+        "links",
+        "threads",
+        "end ms",
+        "speedup",
+        "vertices",
+        "identical");
+
+    imnodes::IO& io = imnodes::GetIO();
+    bool all_identical = true;
+    const bool transparent_links[] = {false, true};
+    for (const bool transparent : transparent_links)
+    {
+        const char* const label = transparent ? "transparent" : "opaque";
+
+        io.parallel_for.run = nullptr;
+        DrawDataCopy serial;
+        const double serial_ms = run(graph, transparent, frames, serial);
+        printf(
+            "%-12s %-8s %12.3f %8.2fx %10d %10s\n",
+            label,
+            "serial",
+            serial_ms,
+            1.0,
+            static_cast<int>(serial.vertices.size()),
+            "-");
+
+        const int thread_counts[] = {1, 2, 4, 8};
+        for (const int num_threads : thread_counts)
+        {
+            ThreadPool pool(num_threads);
+            io.parallel_for.run = ThreadPool::parallel_for;
+            io.parallel_for.user_data = &pool;
+            io.parallel_for.min_elements = 0;
+
+            DrawDataCopy parallel;
+            const double parallel_ms =
+                run(graph, transparent, frames, parallel);
+            const bool identical = parallel == serial;
+            all_identical = all_identical && identical;
+
+            char threads[16];
+            snprintf(threads, sizeof(threads), "%d", num_threads);
+            printf(
+                "%-12s %-8s %12.3f %8.2fx %10d %10s\n",
+                label,
+                threads,
+                parallel_ms,
+                serial_ms / parallel_ms,
+                static_cast<int>(parallel.vertices.size()),
+                identical ? "yes" : "NO");
+
+            io.parallel_for.run = nullptr;
+            io.parallel_for.user_data = nullptr;
+        }
+    }
+
+    HeadlessShutdown();
+    return all_identical;
+}
+} // namespace bench
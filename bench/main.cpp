@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+int int_arg(const int argc, char** argv, const int idx, const int fallback)
+{
+    return idx < argc ? atoi(argv[idx]) : fallback;
+}
+
+void print_usage()
+{
+    printf("usage: bench <benchmark> [arguments]\n\n");
+    printf("benchmarks:\n");
+    printf("  box_selection [num_nodes=50000] [num_links=200000]\n");
+    printf(
+        "  frame [num_nodes=10000] [num_links=20000] [selected_percent=10]\n"
+        "        [visible_percent=25] [frames=300]\n");
+    printf("  groups [num_nodes=10000 and 100000] [group_size=1000]\n");
+    printf("  hot_data [num_nodes=10000, 200000 and 1000000]\n");
+    printf("  layout [num_nodes=1000 and 10000]\n");
+    printf("  links [num_nodes=10000] [num_links=40000]\n");
+    printf("  overlap [num_nodes=1000, 10000 and 50000]\n");
+    printf("  zoom [num_nodes=1000, 10000 and 50000]\n");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        print_usage();
+        return 1;
+    }
+
+    const char* name = argv[1];
+    if (strcmp(name, "box_selection") == 0)
+    {
+        bench::BoxSelectionBenchmark(
+            int_arg(argc, argv, 2, 50000), int_arg(argc, argv, 3, 200000));
+    }
+    else if (strcmp(name, "frame") == 0)
+    {
+        bench::FrameBenchmark(
+            int_arg(argc, argv, 2, 10000),
+            int_arg(argc, argv, 3, 20000),
+            int_arg(argc, argv, 4, 10),
+            int_arg(argc, argv, 5, 25),
+            int_arg(argc, argv, 6, 300));
+    }
+    else if (strcmp(name, "groups") == 0)
+    {
+        bench::GroupsBenchmark(
+            int_arg(argc, argv, 2, 0), int_arg(argc, argv, 3, 1000));
+    }
+    else if (strcmp(name, "hot_data") == 0)
+    {
+        bench::HotDataBenchmark(int_arg(argc, argv, 2, 0));
+    }
+    else if (strcmp(name, "layout") == 0)
+    {
+        bench::LayoutBenchmark(int_arg(argc, argv, 2, 0));
+    }
+    else if (strcmp(name, "links") == 0)
+    {
+        if (!bench::LinksBenchmark(
+                int_arg(argc, argv, 2, 10000), int_arg(argc, argv, 3, 40000)))
+        {
+            return 1;
+        }
+    }
+    else if (strcmp(name, "overlap") == 0)
+    {
+        bench::OverlapBenchmark(int_arg(argc, argv, 2, 0));
+    }
+    else if (strcmp(name, "zoom") == 0)
+    {
+        bench::ZoomBenchmark(int_arg(argc, argv, 2, 0));
+    }
+    else
+    {
+        print_usage();
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace bench
+{
+namespace
+{
+void show_nodes(const int num_nodes)
+{
+    HeadlessNewFrame(ImVec2(0.f, 0.f), false);
+
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration);
+    imnodes::BeginNodeEditor();
+
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        imnodes::BeginNode(i);
+        ImGui::Dummy(ImVec2(40.f + (i % 5) * 10.f, 20.f + (i % 3) * 10.f));
+        imnodes::EndNode();
+    }
+
+    imnodes::EndNodeEditor();
+    ImGui::End();
+
+    HeadlessEndFrame();
+}
+
+struct Rect
+{
+    float min_x, min_y, max_x, max_y;
+    bool movable;
+};
+
+// Counts the overlapping pairs which involve a movable node, with a sweep
+// along the x axis.
+int count_overlaps(const int num_nodes, const std::vector<bool>& movable)
+{
+    std::vector<Rect> rects;
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        const ImVec2 pos = imnodes::GetNodeGridSpacePos(i);
+        const ImVec2 size = imnodes::GetNodeDimensions(i);
+        rects.push_back(
+            {pos.x, pos.y, pos.x + size.x, pos.y + size.y, movable[i]});
+    }
+    std::sort(rects.begin(), rects.end(), [](const Rect& a, const Rect& b) {
+        return a.min_x < b.min_x;
+    });
+
+    int count = 0;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        for (size_t j = i + 1;
+             j < rects.size() && rects[j].min_x < rects[i].max_x;
+             ++j)
+        {
+            if ((rects[i].movable || rects[j].movable) &&
+                rects[j].min_y < rects[i].max_y &&
+                rects[i].min_y < rects[j].max_y)
+            {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+void run(const int num_nodes)
+{
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::EditorContextSet(editor);
+
+    // Scatter the nodes densely, and drop a tenth of them on a single pile,
+    // as if they had been pasted without positions.
+    std::mt19937 rng(1234u);
+    const float extent = 100.f * sqrtf(static_cast<float>(num_nodes));
+    std::uniform_real_distribution<float> pos_dist(0.f, extent);
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        const ImVec2 pos = i % 10 == 0 ? ImVec2(0.5f * extent, 0.5f * extent)
+                                       : ImVec2(pos_dist(rng), pos_dist(rng));
+        imnodes::SetNodeGridSpacePos(i, pos);
+    }
+    show_nodes(num_nodes);
+
+    // The odd nodes and the pile are movable, apart from the first node on
+    // the pile. The other nodes stay in place.
+    std::vector<int> ids;
+    std::vector<bool> movable(num_nodes, false);
+    for (int i = 1; i < num_nodes; ++i)
+    {
+        if (i % 2 == 1 || i % 10 == 0)
+        {
+            ids.push_back(i);
+            movable[i] = true;
+        }
+    }
+
+    const int overlaps_before = count_overlaps(num_nodes, movable);
+    const Timer timer;
+    imnodes::RemoveNodeOverlaps(ids.data(), static_cast<int>(ids.size()));
+    const double elapsed = timer.elapsed_ms();
+    show_nodes(num_nodes);
+
+    printf(
+        "%-8d %8d %12.3f %10d %10d\n",
+        num_nodes,
+        static_cast<int>(ids.size()),
+        elapsed,
+        overlaps_before,
+        count_overlaps(num_nodes, movable));
+
+    imnodes::EditorContextSet(nullptr);
+    imnodes::EditorContextFree(editor);
+}
+} // namespace
+
+// Times removing the overlaps between randomly scattered nodes, a bit over half
+// of which are allowed to move. No overlaps should remain afterwards.
+void OverlapBenchmark(const int num_nodes)
+{
+    HeadlessInitialize(ImVec2(1920.f, 1080.f));
+
+    printf("overlap removal\n");
+    printf(
+        "%-8s %8s %12s %10s %10s\n",
+        "nodes",
+        "movable",
+        "ms",
+        "before",
+        "after");
+
+    if (num_nodes > 0)
+    {
+        run(num_nodes);
+    }
+    else
+    {
+        run(1000);
+        run(10000);
+        run(50000);
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
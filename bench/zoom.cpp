@@ -0,0 +1,77 @@
+#include "bench.h"
+
+#include <imnodes.h>
+#include <imgui.h>
+
+#include <stdio.h>
+#include <algorithm>
+
+namespace bench
+{
+namespace
+{
+void run(const int num_nodes, const int frames)
+{
+    imnodes::EditorContext* const editor = imnodes::EditorContextCreate();
+    imnodes::EditorContextSet(editor);
+
+    const int columns = PlaceNodesOnSquareGrid(num_nodes);
+
+    // At a zoom of 1, only the nodes in the top left corner are visible, but
+    // all of them are laid out.
+    const ChainFrameStats detail = MedianChainFrame(num_nodes, 0, frames);
+
+    // Zoomed out far enough for all of the nodes to be visible.
+    const ImVec2 display_size = ImGui::GetIO().DisplaySize;
+    const float extent = 150.f * static_cast<float>(columns);
+    imnodes::EditorContextSetZoom(
+        std::min(display_size.x, display_size.y) / extent, ImVec2(0.f, 0.f));
+    const float zoom = imnodes::EditorContextGetZoom();
+    const ChainFrameStats zoomed_out = MedianChainFrame(num_nodes, 0, frames);
+
+    printf(
+        "%-8d %10.4f %12.3f %12d %12.3f %12d\n",
+        num_nodes,
+        zoom,
+        detail.ms,
+        detail.vertices,
+        zoomed_out.ms,
+        zoomed_out.vertices);
+
+    imnodes::EditorContextSet(nullptr);
+    imnodes::EditorContextFree(editor);
+}
+} // namespace
+
+// Times whole frames at a zoom of 1, and zoomed out to fit all of the nodes,
+// where the nodes are drawn as plain rectangles.
+void ZoomBenchmark(const int num_nodes)
+{
+    const int frames = 7;
+
+    HeadlessInitialize(ImVec2(1920.f, 1080.f));
+
+    printf("zoom: median frame of %d\n", frames);
+    printf(
+        "%-8s %10s %12s %12s %12s %12s\n",
+        "nodes",
+        "zoom",
+        "detail ms",
+        "vertices",
+        "zoomed ms",
+        "vertices");
+
+    if (num_nodes > 0)
+    {
+        run(num_nodes, frames);
+    }
+    else
+    {
+        run(1000, frames);
+        run(10000, frames);
+        run(50000, frames);
+    }
+
+    HeadlessShutdown();
+}
+} // namespace bench
@@ -5,6 +5,13 @@
 // [SECTION] editor context definition
 // [SECTION] ui state logic
 // [SECTION] render helpers
+// [SECTION] link routing
+// [SECTION] minimap
+// [SECTION] layered layout
+// [SECTION] force layout
+// [SECTION] overlap removal
+// [SECTION] node groups
+// [SECTION] memory
 // [SECTION] API implementation
 
 #include "imnodes.h"
@@ -27,13 +34,42 @@
 #include <string.h> // strlen, strncmp
 #include <stdio.h>  // for fwrite, ssprintf, sscanf
 #include <stdlib.h>
+#include <stdarg.h> // va_list
+
+#if defined(_MSC_VER)
+#include <intrin.h> // _InterlockedExchange, _InterlockedCompareExchange
+#endif
+
+// Storage class of the current context pointer. See the comment above
+// CreateContext() in imnodes.h.
+#ifndef IMNODES_THREAD_LOCAL
+#define IMNODES_THREAD_LOCAL
+#endif
+
+// FrameStats are only collected when IMNODES_ENABLE_STATS is defined. Otherwise
+// the statements wrapped in IMNODES_STAT() compile to nothing.
+#ifdef IMNODES_ENABLE_STATS
+#define IMNODES_STAT(statement) statement
+#else
+#define IMNODES_STAT(statement)
+#endif
+
+// The clock used by the stats and the trace capture, and yielding while
+// waiting for a worker.
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h> // QueryPerformanceCounter, SwitchToThread, Sleep
+#else
+#include <sched.h> // sched_yield
+#include <time.h>  // clock_gettime, nanosleep
+#endif
 
 namespace imnodes
 {
 namespace
 {
-bool initialized = false;
-
 enum ScopeFlags
 {
     Scope_None = 1,
@@ -56,6 +92,14 @@ enum AttributeType
     AttributeType_Output
 };
 
+enum SnapshotSaveState
+{
+    SnapshotSaveState_Idle,
+    SnapshotSaveState_Pending,
+    SnapshotSaveState_Succeeded,
+    SnapshotSaveState_Failed
+};
+
 enum ElementStateChange
 {
     ElementStateChange_None = 0,
@@ -66,6 +110,432 @@ enum ElementStateChange
 
 // [SECTION] internal data structures
 
+// The following two functions are used to publish results computed on worker
+// threads back to the UI thread.
+inline void atomic_store_release(volatile int* const ptr, const int value)
+{
+#if defined(_MSC_VER)
+    _InterlockedExchange(reinterpret_cast<volatile long*>(ptr), value);
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+inline int atomic_load_acquire(const volatile int* const ptr)
+{
+#if defined(_MSC_VER)
+    return _InterlockedCompareExchange(
+        reinterpret_cast<volatile long*>(const_cast<volatile int*>(ptr)), 0, 0);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// Called in a loop while waiting for a worker. Yields to the other threads
+// for the first few calls, and then sleeps for a millisecond per call, so that
+// a long wait doesn't keep a core busy.
+inline void wait_for_worker(int& num_waits)
+{
+    const int num_yields = 64;
+#if defined(_WIN32)
+    if (num_waits < num_yields)
+    {
+        SwitchToThread();
+    }
+    else
+    {
+        Sleep(1);
+    }
+#else
+    if (num_waits < num_yields)
+    {
+        sched_yield();
+    }
+    else
+    {
+        const timespec duration = {0, 1000000};
+        nanosleep(&duration, NULL);
+    }
+#endif
+    num_waits = ImMin(num_waits + 1, num_yields);
+}
+
+inline int num_jobs_for(const int num_elements, const int elements_per_job)
+{
+    return (num_elements + elements_per_job - 1) / elements_per_job;
+}
+
+// Runs task(task_data) via the user's task runner, or synchronously if none
+// was provided.
+void run_task(const IO& io, void (*task)(void*), void* const task_data)
+{
+    if (io.task_runner.run != NULL)
+    {
+        io.task_runner.run(task, task_data, io.task_runner.user_data);
+    }
+    else
+    {
+        task(task_data);
+    }
+}
+
+inline void* editor_alloc(
+    const EditorAllocator* const allocator,
+    const size_t size)
+{
+    if (allocator != NULL && allocator->alloc != NULL)
+    {
+        return allocator->alloc(size, allocator->user_data);
+    }
+    return ImGui::MemAlloc(size);
+}
+
+inline void editor_free(const EditorAllocator* const allocator, void* const ptr)
+{
+    if (allocator != NULL && allocator->free != NULL)
+    {
+        allocator->free(ptr, allocator->user_data);
+    }
+    else
+    {
+        ImGui::MemFree(ptr);
+    }
+}
+
+// An ImVector which gets its memory from an editor context's allocator. Like
+// ImVector, it moves its elements with memcpy, and doesn't construct or
+// destruct them.
+template<typename T>
+struct EditorVector
+{
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    int Size;
+    int Capacity;
+    T* Data;
+    const EditorAllocator* allocator;
+
+    explicit EditorVector(const EditorAllocator* const allocator = NULL)
+        : Size(0), Capacity(0), Data(NULL), allocator(allocator)
+    {
+    }
+
+    ~EditorVector()
+    {
+        if (Data != NULL)
+        {
+            editor_free(allocator, Data);
+        }
+    }
+
+    inline bool empty() const { return Size == 0; }
+    inline int size() const { return Size; }
+
+    inline T& operator[](const int i)
+    {
+        assert(i >= 0 && i < Size);
+        return Data[i];
+    }
+
+    inline const T& operator[](const int i) const
+    {
+        assert(i >= 0 && i < Size);
+        return Data[i];
+    }
+
+    inline T* begin() { return Data; }
+    inline const T* begin() const { return Data; }
+    inline T* end() { return Data + Size; }
+    inline const T* end() const { return Data + Size; }
+
+    inline T& back()
+    {
+        assert(Size > 0);
+        return Data[Size - 1];
+    }
+
+    inline const T& back() const
+    {
+        assert(Size > 0);
+        return Data[Size - 1];
+    }
+
+    // Frees the memory, like ImVector::clear().
+    inline void clear()
+    {
+        if (Data != NULL)
+        {
+            editor_free(allocator, Data);
+        }
+        Size = Capacity = 0;
+        Data = NULL;
+    }
+
+    inline void swap(EditorVector<T>& rhs)
+    {
+        assert(allocator == rhs.allocator);
+        ImSwap(Size, rhs.Size);
+        ImSwap(Capacity, rhs.Capacity);
+        ImSwap(Data, rhs.Data);
+    }
+
+    inline int grow_capacity(const int size) const
+    {
+        const int new_capacity = Capacity ? (Capacity + Capacity / 2) : 8;
+        return new_capacity > size ? new_capacity : size;
+    }
+
+    inline void reserve(const int new_capacity)
+    {
+        if (new_capacity <= Capacity)
+        {
+            return;
+        }
+        T* const new_data = static_cast<T*>(
+            editor_alloc(allocator, size_t(new_capacity) * sizeof(T)));
+        if (Data != NULL)
+        {
+            memcpy(
+                static_cast<void*>(new_data),
+                Data,
+                size_t(Size) * sizeof(T));
+            editor_free(allocator, Data);
+        }
+        Data = new_data;
+        Capacity = new_capacity;
+    }
+
+    inline void resize(const int new_size)
+    {
+        if (new_size > Capacity)
+        {
+            reserve(grow_capacity(new_size));
+        }
+        Size = new_size;
+    }
+
+    inline void resize(const int new_size, const T& v)
+    {
+        if (new_size > Capacity)
+        {
+            reserve(grow_capacity(new_size));
+        }
+        for (int i = Size; i < new_size; ++i)
+        {
+            memcpy(static_cast<void*>(&Data[i]), &v, sizeof(v));
+        }
+        Size = new_size;
+    }
+
+    inline void push_back(const T& v)
+    {
+        if (Size == Capacity)
+        {
+            reserve(grow_capacity(Size + 1));
+        }
+        memcpy(static_cast<void*>(&Data[Size]), &v, sizeof(v));
+        ++Size;
+    }
+
+    inline void pop_back()
+    {
+        assert(Size > 0);
+        --Size;
+    }
+
+    inline T* insert(const T* const it, const T& v)
+    {
+        assert(it >= Data && it <= Data + Size);
+        const ptrdiff_t offset = it - Data;
+        if (Size == Capacity)
+        {
+            reserve(grow_capacity(Size + 1));
+        }
+        if (offset < Size)
+        {
+            memmove(
+                static_cast<void*>(Data + offset + 1),
+                Data + offset,
+                size_t(Size - offset) * sizeof(T));
+        }
+        memcpy(static_cast<void*>(&Data[offset]), &v, sizeof(v));
+        ++Size;
+        return Data + offset;
+    }
+
+    inline T* erase(const T* const it)
+    {
+        assert(it >= Data && it < Data + Size);
+        const ptrdiff_t offset = it - Data;
+        memmove(
+            static_cast<void*>(Data + offset),
+            Data + offset + 1,
+            size_t(Size - offset - 1) * sizeof(T));
+        --Size;
+        return Data + offset;
+    }
+
+    inline bool contains(const T& v) const
+    {
+        for (int i = 0; i < Size; ++i)
+        {
+            if (Data[i] == v)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    EditorVector(const EditorVector<T>&);
+    EditorVector<T>& operator=(const EditorVector<T>&);
+};
+
+// The subset of ImGuiStorage used by the editor, in the editor's memory.
+struct IdMap
+{
+    typedef ImGuiStorage::ImGuiStoragePair Pair;
+
+    // Sorted by key.
+    EditorVector<Pair> pairs;
+
+    explicit IdMap(const EditorAllocator* const allocator = NULL)
+        : pairs(allocator)
+    {
+    }
+
+    inline const Pair* lower_bound(const ImGuiID key) const
+    {
+        const Pair* first = pairs.begin();
+        int count = pairs.size();
+        while (count > 0)
+        {
+            const int step = count / 2;
+            if (first[step].key < key)
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+    inline int GetInt(const ImGuiID key, const int default_value = 0) const
+    {
+        const Pair* const it = lower_bound(key);
+        return it != pairs.end() && it->key == key ? it->val_i : default_value;
+    }
+
+    inline void SetInt(const ImGuiID key, const int value)
+    {
+        const Pair* const it = lower_bound(key);
+        if (it != pairs.end() && it->key == key)
+        {
+            pairs[int(it - pairs.begin())].val_i = value;
+        }
+        else
+        {
+            pairs.insert(it, Pair(key, value));
+        }
+    }
+
+    // Keeps the capacity, as the maps are refilled right away.
+    inline void Clear() { pairs.resize(0); }
+};
+
+// Bump allocates an editor context's memory from a list of blocks, which are
+// all released at once when the context is freed.
+struct MemoryArena
+{
+    struct Block
+    {
+        Block* next;
+        size_t size;
+        size_t used;
+    };
+
+    Block* blocks;
+    size_t block_size;
+
+    MemoryArena() : blocks(NULL), block_size(0) {}
+};
+
+const size_t arena_alignment = 16;
+
+inline size_t align_arena_size(const size_t size)
+{
+    return (size + arena_alignment - 1) & ~(arena_alignment - 1);
+}
+
+void* arena_alloc(const size_t size, void* const user_data)
+{
+    MemoryArena& arena = *static_cast<MemoryArena*>(user_data);
+    const size_t header_size = align_arena_size(sizeof(MemoryArena::Block));
+    const size_t aligned_size = align_arena_size(size);
+
+    MemoryArena::Block* block = arena.blocks;
+    if (block == NULL || block->used + aligned_size > block->size)
+    {
+        const size_t block_size = ImMax(aligned_size, arena.block_size);
+        block = static_cast<MemoryArena::Block*>(
+            ImGui::MemAlloc(header_size + block_size));
+        block->size = block_size;
+        block->used = 0;
+        // Allocations which don't fit in a regular block get a block of their
+        // own, which goes behind the current block, so that the rest of the
+        // current block is still used.
+        if (arena.blocks != NULL && block_size > arena.block_size)
+        {
+            block->next = arena.blocks->next;
+            arena.blocks->next = block;
+        }
+        else
+        {
+            block->next = arena.blocks;
+            arena.blocks = block;
+        }
+    }
+
+    void* const ptr =
+        reinterpret_cast<char*>(block) + header_size + block->used;
+    block->used += aligned_size;
+    return ptr;
+}
+
+void arena_free(void* const ptr, void* const user_data)
+{
+    // The memory is released along with the arena.
+    (void)ptr;
+    (void)user_data;
+}
+
+void arena_release(MemoryArena& arena)
+{
+    MemoryArena::Block* block = arena.blocks;
+    arena.blocks = NULL;
+    while (block != NULL)
+    {
+        MemoryArena::Block* const next = block->next;
+        ImGui::MemFree(block);
+        block = next;
+    }
+}
+
+// Orders the pairs of an IdMap by key, as its lookups expect.
+int compare_id_map_pairs(const void* lhs, const void* rhs)
+{
+    const ImGuiID lhs_key = static_cast<const IdMap::Pair*>(lhs)->key;
+    const ImGuiID rhs_key = static_cast<const IdMap::Pair*>(rhs)->key;
+    return int(lhs_key > rhs_key) - int(lhs_key < rhs_key);
+}
+
 // The object T must have the following interface:
 //
 // struct T
@@ -77,16 +547,25 @@ enum ElementStateChange
 template<typename T>
 struct ObjectPool
 {
-    ImVector<T> pool;
-    ImVector<bool> in_use;
-    ImVector<int> free_list;
-    ImGuiStorage id_map;
-
-    ObjectPool() : pool(), in_use(), free_list(), id_map() {}
+    EditorVector<T> pool;
+    EditorVector<bool> in_use;
+    EditorVector<int> free_list;
+    IdMap id_map;
+    // The most objects in use at the start of a frame since the pool was
+    // created or compacted.
+    int max_live;
+
+    explicit ObjectPool(const EditorAllocator* const allocator)
+        : pool(allocator), in_use(allocator), free_list(allocator),
+          id_map(allocator), max_live(0)
+    {
+    }
 
     inline void update()
     {
-        free_list.clear();
+        // Keeps the capacity, so that an editor which allocates from an arena
+        // doesn't allocate a new free list every frame.
+        free_list.resize(0);
         for (int i = 0; i < in_use.size(); ++i)
         {
             if (!in_use[i])
@@ -95,6 +574,7 @@ struct ObjectPool
                 free_list.push_back(i);
             }
         }
+        max_live = ImMax(max_live, pool.size() - free_list.size());
         // set all values to false
         memset(in_use.Data, 0, sizeof(bool) * in_use.size());
     }
@@ -127,6 +607,57 @@ struct ObjectPool
         return pool[index];
     }
 
+    inline int num_in_use() const
+    {
+        int count = 0;
+        for (int i = 0; i < in_use.size(); ++i)
+        {
+            count += in_use[i] ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Moves the objects in use to the front of the pool, keeping their order,
+    // and frees the rest of the slots. The ids of the freed objects are
+    // dropped from id_map. new_indices maps the old indices to the new ones,
+    // or to -1 for the freed objects.
+    inline void compact(ImVector<int>& new_indices)
+    {
+        const int num_live = num_in_use();
+        new_indices.resize(pool.size());
+
+        // ImVector moves its elements with memcpy, so the objects keep
+        // whatever they own.
+        EditorVector<T> compacted(pool.allocator);
+        compacted.reserve(num_live);
+        EditorVector<IdMap::Pair> pairs(pool.allocator);
+        pairs.reserve(num_live);
+        for (int i = 0; i < pool.size(); ++i)
+        {
+            new_indices[i] = -1;
+            if (in_use[i])
+            {
+                new_indices[i] = compacted.size();
+                pairs.push_back(IdMap::Pair(
+                    static_cast<ImGuiID>(pool[i].id), compacted.size()));
+                compacted.push_back(pool[i]);
+            }
+        }
+        qsort(
+            pairs.Data,
+            pairs.size(),
+            sizeof(IdMap::Pair),
+            compare_id_map_pairs);
+
+        pool.swap(compacted);
+        id_map.pairs.swap(pairs);
+        in_use.clear();
+        in_use.reserve(num_live);
+        in_use.resize(num_live, true);
+        free_list.clear();
+        max_live = num_live;
+    }
+
     // Predicate must define operator()(const T& lhs, const T& operator) ->
     // bool.
     template<typename Predicate>
@@ -188,32 +719,101 @@ private:
     int m_index;
 };
 
-struct NodeData
+// The styles of the elements are interned into per-frame palettes, as most
+// elements share a few styles. The elements store their index in the palette.
+struct NodeStyle
 {
-    int id;
-    ImVec2 origin; // The node origin is in editor space
-    ImRect title_bar_content_rect;
-    ImRect rect;
+    ImU32 background, background_hovered, background_selected, outline,
+        titlebar, titlebar_hovered, titlebar_selected;
+    // In screen space units.
+    float corner_rounding;
+    ImVec2 padding;
+};
 
-    struct
-    {
-        ImU32 background, background_hovered, background_selected, outline,
-            titlebar, titlebar_hovered, titlebar_selected;
-    } color_style;
+struct PinStyle
+{
+    ImU32 background, hovered;
+};
 
-    struct
-    {
-        float corner_rounding;
-        ImVec2 padding;
-    } layout_style;
+struct LinkStyle
+{
+    ImU32 base, hovered, selected;
+};
 
-    ImVector<int> pin_indices;
-    bool draggable;
+// The styles are compared bitwise, so T must not contain padding.
+template<typename T>
+struct StylePalette
+{
+    ImVector<T> styles;
+    // Maps the hashes of the styles to their indices.
+    ImGuiStorage lookup;
+    // Consecutive elements usually share their style.
+    int last_idx;
 
-    NodeData()
-        : id(0), origin(100.0f, 100.0f), title_bar_content_rect(),
-          rect(ImVec2(0.0f, 0.0f), ImVec2(0.0f, 0.0f)), color_style(),
-          layout_style(), pin_indices(), draggable(true)
+    StylePalette() : styles(), lookup(), last_idx(-1) {}
+
+    // Keeps the memory for the next frame.
+    inline void reset()
+    {
+        styles.resize(0);
+        lookup.Data.resize(0);
+        last_idx = -1;
+    }
+
+    inline ImU16 intern(const T& style)
+    {
+        if (last_idx != -1 &&
+            memcmp(&styles[last_idx], &style, sizeof(T)) == 0)
+        {
+            return static_cast<ImU16>(last_idx);
+        }
+
+        const ImGuiID key = ImHashData(&style, sizeof(T));
+        int idx = lookup.GetInt(key, -1);
+        // On a hash collision, the style is added again under the same key.
+        if (idx == -1 || memcmp(&styles[idx], &style, sizeof(T)) != 0)
+        {
+            // The indices are 16 bit. Once the palette is full, the element
+            // gets the style of the element before it.
+            if (styles.size() > 0xFFFF)
+            {
+                return static_cast<ImU16>(last_idx);
+            }
+            idx = styles.size();
+            styles.push_back(style);
+            lookup.SetInt(key, idx);
+        }
+        last_idx = idx;
+        return static_cast<ImU16>(idx);
+    }
+};
+
+struct NodeData
+{
+    int id;
+    ImVec2 origin; // The node origin is in editor space
+    ImRect title_bar_content_rect;
+    // The size of the rect in grid space units, as measured during the last
+    // frame which drew the node's contents.
+    ImVec2 grid_space_size;
+    // The node's style in Context::node_styles, set when the node is
+    // submitted.
+    ImU16 style_idx;
+
+    // The node's pins are Context::pin_indices[pin_index_begin] up to
+    // pin_index_end, set when the node is submitted.
+    int pin_index_begin, pin_index_end;
+    bool draggable;
+    // Set when the rects were loaded from a file with SaveFlags_NodeGeometry,
+    // and are still in grid space.
+    bool geometry_in_grid_space;
+
+    NodeData()
+        : id(0), origin(100.0f, 100.0f), title_bar_content_rect(),
+          grid_space_size(0.0f, 0.0f), style_idx(0), pin_index_begin(0),
+          pin_index_end(0),
+          draggable(true),
+          geometry_in_grid_space(false)
     {
     }
 };
@@ -225,18 +825,14 @@ struct PinData
     ImRect attribute_rect;
     AttributeType type;
     PinShape shape;
-    ImVec2 pos; // screen-space coordinates
     int flags;
-
-    struct
-    {
-        ImU32 background, hovered;
-    } color_style;
+    // The pin's style in Context::pin_styles.
+    ImU16 style_idx;
 
     PinData()
         : id(), parent_node_idx(), attribute_rect(), type(AttributeType_None),
-          shape(PinShape_CircleFilled), pos(), flags(AttributeFlags_None),
-          color_style()
+          shape(PinShape_CircleFilled), flags(AttributeFlags_None),
+          style_idx(0)
     {
     }
 };
@@ -245,13 +841,10 @@ struct LinkData
 {
     int id;
     int start_pin_idx, end_pin_idx;
+    // The link's style in Context::link_styles.
+    ImU16 style_idx;
 
-    struct
-    {
-        ImU32 base, hovered, selected;
-    } color_style;
-
-    LinkData() : id(), start_pin_idx(), end_pin_idx(), color_style() {}
+    LinkData() : id(), start_pin_idx(), end_pin_idx(), style_idx(0) {}
 };
 
 struct LinkPredicate
@@ -295,6 +888,299 @@ struct LinkBezierData
     int num_segments;
 };
 
+struct LinkDrawCommand
+{
+    LinkBezierData link_data;
+    // The screen space points of the link's orthogonal route, which is drawn
+    // instead of the curve when there are any.
+    const ImVec2* route_points;
+    int num_route_points;
+    ImU32 color;
+    // The number of vertices and indices emitted into the staging draw list.
+    int vtx_count, idx_count;
+
+    LinkDrawCommand()
+        : link_data(), route_points(NULL), num_route_points(0), color(),
+          vtx_count(0), idx_count(0)
+    {
+    }
+};
+
+// Shared by all the jobs of draw_links_parallel(). Job i tessellates the
+// commands in ranges[i] into staging_draw_lists[i].
+struct LinkTessellationJobs
+{
+    struct Range
+    {
+        int begin, end;
+        // Upper bounds on the number of vertices, indices and path points the
+        // range emits, used to preallocate the staging draw lists.
+        int max_vtx, max_idx, max_path_size;
+    };
+
+    LinkDrawCommand* commands;
+    const Range* ranges;
+    ImDrawList* const* staging_draw_lists;
+    float thickness;
+};
+
+struct TraceEvent
+{
+    // Points to a string literal.
+    const char* name;
+    // Microseconds since the capture started.
+    double time;
+    bool begin;
+};
+
+// Records the profiling zones for StartTraceCapture().
+struct TraceCapture
+{
+    ImVector<char> file_name;
+    // The editor frames left to skip before recording starts, and the frames
+    // left to record. The capture is running while frames_left > 0.
+    int frames_to_skip;
+    int frames_left;
+    bool recording;
+    double start_ms;
+    ImVector<TraceEvent> events;
+
+    TraceCapture()
+        : file_name(), frames_to_skip(0), frames_left(0), recording(false),
+          start_ms(0.0), events()
+    {
+    }
+};
+
+// The result of the last layout, which lets an incremental layout keep the
+// existing nodes in their layers.
+struct LayoutState
+{
+    // Maps the node ids to their layer + 1.
+    IdMap node_layers;
+    // The grid space x coordinate of each layer.
+    EditorVector<float> layer_xs;
+
+    explicit LayoutState(const EditorAllocator* const allocator)
+        : node_layers(allocator), layer_xs(allocator)
+    {
+    }
+};
+
+struct ForceLayout;
+
+// The cached orthogonal route of a link, in grid space.
+struct LinkRoute
+{
+    // The range of the route's points in LinkRouter::points. The route hasn't
+    // been computed if it has no points.
+    int point_begin, num_points;
+    // The pin positions the route was computed for.
+    ImVec2 start, end;
+    // Contains the route, expanded by the route spacing.
+    ImRect bounds;
+
+    LinkRoute() : point_begin(0), num_points(0), start(), end(), bounds() {}
+};
+
+struct RouteSearchItem
+{
+    float cost;
+    int state;
+};
+
+struct LinkRouter
+{
+    // Indexed by link index.
+    EditorVector<LinkRoute> routes;
+    // The points of all routes in grid space, and in screen space for the
+    // current frame. Recomputed routes are appended, and the points are
+    // compacted once enough of them are unused.
+    EditorVector<ImVec2> points;
+    EditorVector<ImVec2> screen_points;
+    int num_used_points;
+    // The spacing the routes were computed with.
+    float spacing;
+
+    // The grid space rect of each node when the routes were last updated.
+    // Nodes which weren't in use have empty rects.
+    EditorVector<ImRect> node_rects;
+    // The old and new rects of the nodes which changed since the last update.
+    EditorVector<ImRect> dirty_rects;
+    EditorVector<int> dirty_link_indices;
+
+    // A spatial hash of the node rects, only built when there are routes to
+    // compute. The nodes overlapping the cells which hash to a bucket are
+    // linked through entry_next, starting from bucket_heads.
+    float cell_size;
+    EditorVector<int> bucket_heads;
+    EditorVector<int> entry_nodes, entry_next;
+    // Used to skip the nodes which were already found by a query.
+    EditorVector<int> node_query_stamps;
+    int query_stamp;
+
+    // Scratch buffers of the route search.
+    EditorVector<ImRect> obstacles;
+    EditorVector<float> xs, ys;
+    EditorVector<bool> blocked_cells;
+    EditorVector<float> costs;
+    EditorVector<int> parents;
+    EditorVector<RouteSearchItem> open_states;
+    EditorVector<ImVec2> path;
+
+    explicit LinkRouter(const EditorAllocator* const allocator)
+        : routes(allocator), points(allocator), screen_points(allocator),
+          num_used_points(0), spacing(0.f), node_rects(allocator),
+          dirty_rects(allocator), dirty_link_indices(allocator),
+          cell_size(1.f), bucket_heads(allocator), entry_nodes(allocator),
+          entry_next(allocator), node_query_stamps(allocator), query_stamp(0),
+          obstacles(allocator), xs(allocator), ys(allocator),
+          blocked_cells(allocator), costs(allocator), parents(allocator),
+          open_states(allocator), path(allocator)
+    {
+    }
+};
+
+// The bins of a link in the minimap. A link runs between the bins of its
+// nodes' centers.
+struct MiniMapLink
+{
+    int start_bin, end_bin;
+
+    MiniMapLink() : start_bin(-1), end_bin(-1) {}
+};
+
+// A coarse summary of the editor for drawing the minimap. The grid space
+// bounds of the nodes are split into bins, which count how much of each bin
+// the node rects cover, and how many links pass through it.
+struct MiniMapSummary
+{
+    // Set while MiniMap() is being called every frame. The bins are only kept
+    // up to date while the minimap is shown.
+    bool shown;
+    // Set when the bins have to be rebuilt from scratch.
+    bool dirty;
+    float size_fraction;
+    MiniMapLocation location;
+
+    ImRect bounds;
+    ImVec2 bin_size;
+    int columns, rows;
+    // Indexed by bin. The node coverage is in 1/256ths of the bin area.
+    EditorVector<int> node_coverage;
+    EditorVector<int> link_counts;
+
+    // What each node and link has added to the bins. Indexed by node and link
+    // index. Nodes which haven't added anything have empty rects.
+    EditorVector<ImRect> node_rects;
+    EditorVector<MiniMapLink> links;
+
+    // Where the minimap was drawn during the last frame, and how it maps the
+    // grid space to the screen space.
+    ImRect screen_rect;
+    ImVec2 screen_origin;
+    float scale;
+
+    explicit MiniMapSummary(const EditorAllocator* const allocator)
+        : shown(false), dirty(true), size_fraction(0.f),
+          location(MiniMapLocation_TopRight), bounds(), bin_size(),
+          columns(0), rows(0), node_coverage(allocator),
+          link_counts(allocator), node_rects(allocator), links(allocator),
+          screen_rect(), screen_origin(), scale(1.f)
+    {
+    }
+};
+
+// The grid lines, drawn relative to the canvas origin, with the first line in
+// each direction at zero. Panning only changes where the lines are copied to,
+// and how many of them are visible. The block is rebuilt when any of the
+// values which it was built with change.
+struct GridCache
+{
+    ImVec2 canvas_size;
+    float spacing;
+    ImU32 color;
+    ImDrawListFlags flags;
+    ImVec2 tex_uv_white_pixel;
+    bool built;
+
+    // The vertical lines come first, followed by the horizontal lines. Each
+    // line has the same number of vertices and indices.
+    int num_vertical_lines;
+    int num_horizontal_lines;
+    int vtx_per_line;
+    int idx_per_line;
+    EditorVector<ImDrawVert> vertices;
+    EditorVector<ImDrawIdx> indices;
+
+    explicit GridCache(const EditorAllocator* const allocator)
+        : canvas_size(0.f, 0.f), spacing(0.f), color(0u),
+          flags(ImDrawListFlags_None), tex_uv_white_pixel(0.f, 0.f),
+          built(false), num_vertical_lines(0), num_horizontal_lines(0),
+          vtx_per_line(0), idx_per_line(0), vertices(allocator),
+          indices(allocator)
+    {
+    }
+};
+
+// What draw_node() draws a node's background, title bar and outline with. The
+// title bar rect is relative to the node's rect.
+struct NodeGeometryKey
+{
+    ImVec2 size;
+    ImRect title_bar_rect;
+    ImU32 background, titlebar, outline;
+    float corner_rounding;
+    bool has_title_bar;
+    bool has_outline;
+
+    NodeGeometryKey()
+        : size(0.f, 0.f), title_bar_rect(), background(0u), titlebar(0u),
+          outline(0u), corner_rounding(0.f), has_title_bar(false),
+          has_outline(false)
+    {
+    }
+};
+
+// A node's block of vertices and indices in NodeGeometryCache. The block is
+// reused when the node's geometry changes, as long as the new geometry fits.
+struct NodeGeometry
+{
+    NodeGeometryKey key;
+    bool built;
+    int vtx_begin, vtx_count, vtx_capacity;
+    int idx_begin, idx_count, idx_capacity;
+
+    NodeGeometry()
+        : key(), built(false), vtx_begin(0), vtx_count(0), vtx_capacity(0),
+          idx_begin(0), idx_count(0), idx_capacity(0)
+    {
+    }
+};
+
+// The background geometry of each node, relative to the node's rect. As long as
+// its key doesn't change, a node's geometry is copied to where the node is,
+// instead of being tessellated again. The whole cache is dropped when the draw
+// list flags or the white pixel UV change, and when the blocks which were
+// outgrown take up too much of it.
+struct NodeGeometryCache
+{
+    ImDrawListFlags flags;
+    ImVec2 tex_uv_white_pixel;
+    // Indexed like the node pool, but only grown as the nodes are drawn.
+    EditorVector<NodeGeometry> nodes;
+    EditorVector<ImDrawVert> vertices;
+    EditorVector<ImDrawIdx> indices;
+    int stale_vertices;
+
+    explicit NodeGeometryCache(const EditorAllocator* const allocator)
+        : flags(ImDrawListFlags_None), tex_uv_white_pixel(0.f, 0.f),
+          nodes(allocator), vertices(allocator), indices(allocator),
+          stale_vertices(0)
+    {
+    }
+};
+
 enum ClickInteractionType
 {
     ClickInteractionType_Node,
@@ -302,9 +1188,68 @@ enum ClickInteractionType
     ClickInteractionType_LinkCreation,
     ClickInteractionType_Panning,
     ClickInteractionType_BoxSelection,
+    ClickInteractionType_MiniMap,
     ClickInteractionType_None
 };
 
+// A node which was collapsed into a group, and what it's restored with when
+// the group is expanded.
+struct NodeGroupMember
+{
+    int node_id;
+    int group_idx;
+    // The node's origin relative to the group node's origin, in grid space.
+    ImVec2 offset;
+    ImVec2 grid_space_size;
+    bool draggable;
+};
+
+// A pin of a collapsed node, which the group node submits as a proxy pin while
+// it's linked to a pin outside of the group.
+struct NodeGroupPin
+{
+    int pin_id;
+    int group_idx;
+    AttributeType type;
+    PinShape shape;
+    int flags;
+};
+
+struct NodeGroup
+{
+    int id;
+    // The group's ranges of NodeGroups::members and NodeGroups::pins. The
+    // proxy pins come first, up to proxy_end.
+    int member_begin, member_end;
+    int pin_begin, proxy_end, pin_end;
+    // The group which the group is nested in, through any number of groups,
+    // or the group itself if it isn't nested.
+    int outermost_idx;
+};
+
+// The collapsed groups, in the order they were collapsed in, so that a nested
+// group comes before the group it was collapsed into. The members and pins of
+// each group are contiguous, in the order of the groups.
+struct NodeGroups
+{
+    EditorVector<NodeGroup> groups;
+    EditorVector<NodeGroupMember> members;
+    EditorVector<NodeGroupPin> pins;
+    // Map the group ids to the groups, and the ids of the collapsed nodes and
+    // their pins to their records. The pins of a nested group node, which are
+    // also the pins of a member of the outer group, map to the outer group's
+    // record.
+    IdMap group_ids;
+    IdMap member_ids;
+    IdMap pin_ids;
+
+    explicit NodeGroups(const EditorAllocator* const allocator)
+        : groups(allocator), members(allocator), pins(allocator),
+          group_ids(allocator), member_ids(allocator), pin_ids(allocator)
+    {
+    }
+};
+
 struct ClickInteractionState
 {
     struct
@@ -338,16 +1283,54 @@ struct StyleElement
     }
 };
 
-// [SECTION] global struct
-// this stores data which only lives for one frame
-struct
+const int num_pin_shapes = PinShape_QuadFilled + 1;
+
+// The vertices and indices which ImGui emits for a pin shape centered on the
+// origin. The inner vertices are white, and the anti-aliasing fringe is
+// transparent white, so masking the colors with the pin color gives the colors
+// ImGui would have used. The template is rebuilt when any of the values which
+// it was built with change.
+struct PinShapeTemplate
+{
+    float size;
+    float line_thickness;
+    float zoom;
+    ImDrawListFlags flags;
+    ImVec2 tex_uv_white_pixel;
+    bool built;
+    ImVector<ImDrawVert> vertices;
+    ImVector<ImDrawIdx> indices;
+
+    PinShapeTemplate()
+        : size(0.f), line_thickness(0.f), zoom(0.f),
+          flags(ImDrawListFlags_None), tex_uv_white_pixel(0.f, 0.f),
+          built(false), vertices(), indices()
+    {
+    }
+};
+
+} // namespace
+
+// [SECTION] context definition
+// this stores data which only lives for one frame, along with the style and
+// IO which are shared by all editor contexts.
+struct Context
 {
     EditorContext* default_editor_ctx;
     EditorContext* editor_ctx;
     ImDrawList* canvas_draw_list;
+    // The sizes of the canvas draw list buffers in BeginNodeEditor().
+    int canvas_vtx_begin;
+    int canvas_idx_begin;
     ImVec2 canvas_origin_screen_space;
     ImRect canvas_rect_screen_space;
     ScopeFlags current_scope;
+    // Set when the current editor's zoom is below the detail zoom threshold.
+    bool zoomed_out;
+    // Set when the mouse is over the minimap, which hides the elements below.
+    bool minimap_hovered;
+    // The grid space bounds of the nodes submitted so far during this frame.
+    ImRect content_bounds;
 
     IO io;
     Style style;
@@ -355,6 +1338,16 @@ struct
     ImVector<StyleElement> style_modifier_stack;
     ImGuiTextBuffer text_buffer;
 
+    // The styles of the elements submitted to the current editor during this
+    // frame.
+    StylePalette<NodeStyle> node_styles;
+    StylePalette<PinStyle> pin_styles;
+    StylePalette<LinkStyle> link_styles;
+    // The pins submitted to the current editor during this frame. The pins
+    // are submitted node by node, so each node's pins are a range of this
+    // array.
+    ImVector<int> pin_indices;
+
     int current_attribute_flags;
     ImVector<int> attribute_flag_stack;
 
@@ -370,12 +1363,211 @@ struct
     OptionalIndex deleted_link_idx;
 
     int element_state_change;
-} g;
+
+    // Scratch buffers for the parallel box selection.
+    ImVector<bool> box_selector_node_hits;
+    ImVector<bool> box_selector_link_hits;
+
+    // Scratch buffers for the parallel link tessellation.
+    ImVector<LinkDrawCommand> link_draw_commands;
+    ImVector<LinkTessellationJobs::Range> link_tessellation_ranges;
+    ImVector<ImDrawList*> link_staging_draw_lists;
+
+    PinShapeTemplate pin_shape_templates[num_pin_shapes];
+    // The geometry which is drawn once and then copied, such as the pin shape
+    // templates and the grid, is drawn into this draw list.
+    ImDrawList* scratch_draw_list;
+
+    FrameStats stats;
+
+    TraceCapture trace_capture;
+
+    Context()
+        : default_editor_ctx(NULL), editor_ctx(NULL), canvas_draw_list(NULL),
+          canvas_vtx_begin(0), canvas_idx_begin(0),
+          canvas_origin_screen_space(0.f, 0.f),
+          canvas_rect_screen_space(ImVec2(0.f, 0.f), ImVec2(0.f, 0.f)),
+          current_scope(Scope_None), zoomed_out(false), minimap_hovered(false),
+          content_bounds(), io(), style(), color_modifier_stack(),
+          style_modifier_stack(), text_buffer(), node_styles(), pin_styles(),
+          link_styles(), pin_indices(),
+          current_attribute_flags(AttributeFlags_None),
+          attribute_flag_stack(), current_node_idx(0), current_pin_idx(0),
+          hovered_node_idx(), hovered_link_idx(), hovered_pin_idx(),
+          hovered_pin_flags(AttributeFlags_None), active_pin_idx(),
+          deleted_link_idx(), element_state_change(ElementStateChange_None),
+          box_selector_node_hits(), box_selector_link_hits(),
+          link_draw_commands(), link_tessellation_ranges(),
+          link_staging_draw_lists(), scratch_draw_list(NULL), stats(),
+          trace_capture()
+    {
+    }
+
+    ~Context()
+    {
+        for (int i = 0; i < link_staging_draw_lists.size(); ++i)
+        {
+            IM_DELETE(link_staging_draw_lists[i]);
+        }
+        if (scratch_draw_list != NULL)
+        {
+            IM_DELETE(scratch_draw_list);
+        }
+    }
+};
+
+namespace
+{
+// The current context. Each function which touches per-frame state reads it
+// through this pointer, so that separate contexts share no mutable state.
+IMNODES_THREAD_LOCAL Context* g = NULL;
 
 EditorContext& editor_context_get()
 {
-    assert(g.editor_ctx != NULL);
-    return *g.editor_ctx;
+    // No current context. Did you call CreateContext() and
+    // SetCurrentContext(), or Initialize()?
+    assert(g != NULL);
+    assert(g->editor_ctx != NULL);
+    return *g->editor_ctx;
+}
+
+inline const NodeStyle& get_node_style(const NodeData& node)
+{
+    return g->node_styles.styles[node.style_idx];
+}
+
+inline const PinStyle& get_pin_style(const PinData& pin)
+{
+    return g->pin_styles.styles[pin.style_idx];
+}
+
+inline const LinkStyle& get_link_style(const LinkData& link)
+{
+    return g->link_styles.styles[link.style_idx];
+}
+
+// A monotonic clock, in milliseconds.
+double get_time_ms()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return 1000.0 * double(counter.QuadPart) / double(frequency.QuadPart);
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return 1000.0 * double(time.tv_sec) + 1e-6 * double(time.tv_nsec);
+#endif
+}
+
+void begin_profile_zone(const char* const name)
+{
+    const IO::Profiler& profiler = g->io.profiler;
+    if (profiler.begin_zone != NULL)
+    {
+        profiler.begin_zone(name, profiler.user_data);
+    }
+
+    TraceCapture& capture = g->trace_capture;
+    if (capture.recording)
+    {
+        const TraceEvent event = {
+            name, 1000.0 * (get_time_ms() - capture.start_ms), true};
+        capture.events.push_back(event);
+    }
+}
+
+void end_profile_zone(const char* const name)
+{
+    TraceCapture& capture = g->trace_capture;
+    if (capture.recording)
+    {
+        const TraceEvent event = {
+            name, 1000.0 * (get_time_ms() - capture.start_ms), false};
+        capture.events.push_back(event);
+    }
+
+    const IO::Profiler& profiler = g->io.profiler;
+    if (profiler.end_zone != NULL)
+    {
+        profiler.end_zone(name, profiler.user_data);
+    }
+}
+
+// Begins a profiling zone, which ends when the scope is left.
+struct ProfileZone
+{
+    const char* name;
+
+    ProfileZone(const char* const zone_name) : name(zone_name)
+    {
+        begin_profile_zone(name);
+    }
+
+    ~ProfileZone() { end_profile_zone(name); }
+};
+
+// Writes the recorded zones in the Chrome trace event format, which can be
+// opened in chrome://tracing or https://ui.perfetto.dev.
+void write_trace_capture(const TraceCapture& capture)
+{
+    FILE* file = ImFileOpen(capture.file_name.Data, "wt");
+    if (!file)
+    {
+        return;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (int i = 0; i < capture.events.size(); ++i)
+    {
+        const TraceEvent& event = capture.events[i];
+        fprintf(
+            file,
+            "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,"
+            "\"tid\":0}%s\n",
+            event.name,
+            event.begin ? 'B' : 'E',
+            event.time,
+            i + 1 < capture.events.size() ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+}
+
+// Called at the start of each editor frame.
+void begin_trace_capture_frame()
+{
+    TraceCapture& capture = g->trace_capture;
+    if (capture.frames_left == 0 || capture.recording)
+    {
+        return;
+    }
+
+    if (capture.frames_to_skip > 0)
+    {
+        --capture.frames_to_skip;
+        return;
+    }
+
+    capture.recording = true;
+    capture.start_ms = get_time_ms();
+    capture.events.resize(0);
+}
+
+// Called at the end of each editor frame. Writes the trace once the last frame
+// has been recorded.
+void end_trace_capture_frame()
+{
+    TraceCapture& capture = g->trace_capture;
+    if (!capture.recording || --capture.frames_left > 0)
+    {
+        return;
+    }
+
+    capture.recording = false;
+    write_trace_capture(capture);
+    capture.events.clear();
 }
 
 inline bool is_mouse_hovering_near_point(const ImVec2& point, float radius)
@@ -434,15 +1626,15 @@ inline float get_distance_to_cubic_bezier(
     return ImSqrt(ImLengthSqr(to_curve));
 }
 
-inline ImRect get_containing_rect_for_bezier_curve(const BezierCurve& bezier)
+inline ImRect get_containing_rect_for_bezier_curve(
+    const BezierCurve& bezier,
+    const float hover_distance)
 {
     const ImVec2 min = ImVec2(
         ImMin(bezier.p0.x, bezier.p3.x), ImMin(bezier.p0.y, bezier.p3.y));
     const ImVec2 max = ImVec2(
         ImMax(bezier.p0.x, bezier.p3.x), ImMax(bezier.p0.y, bezier.p3.y));
 
-    const float hover_distance = g.style.link_hover_distance;
-
     ImRect rect(min, max);
     rect.Add(bezier.p1);
     rect.Add(bezier.p2);
@@ -479,19 +1671,22 @@ inline LinkBezierData get_link_renderable(
 
 inline bool is_mouse_hovering_near_link(
     const BezierCurve& bezier,
-    const int num_segments)
+    const int num_segments,
+    const float hover_distance)
 {
     const ImVec2 mouse_pos = ImGui::GetIO().MousePos;
 
     // First, do a simple bounding box test against the box containing the link
     // to see whether calculating the distance to the link is worth doing.
-    const ImRect link_rect = get_containing_rect_for_bezier_curve(bezier);
+    const ImRect link_rect =
+        get_containing_rect_for_bezier_curve(bezier, hover_distance);
 
     if (link_rect.Contains(mouse_pos))
     {
+        IMNODES_STAT(g->stats.hover_bezier_segments += num_segments);
         const float distance =
             get_distance_to_cubic_bezier(mouse_pos, bezier, num_segments);
-        if (distance < g.style.link_hover_distance)
+        if (distance < hover_distance)
         {
             return true;
         }
@@ -608,7 +1803,8 @@ inline bool rectangle_overlaps_link(
     const ImRect& rectangle,
     const ImVec2& start,
     const ImVec2& end,
-    const AttributeType start_type)
+    const AttributeType start_type,
+    const float line_segments_per_length)
 {
     // First level: simple rejection test via rectangle overlap:
 
@@ -637,36 +1833,136 @@ inline bool rectangle_overlaps_link(
         // link
 
         const LinkBezierData link_data = get_link_renderable(
-            start, end, start_type, g.style.link_line_segments_per_length);
+            start, end, start_type, line_segments_per_length);
         return rectangle_overlaps_bezier(rectangle, link_data);
     }
 
     return false;
 }
+
+inline bool is_mouse_hovering_near_route(
+    const ImVec2* const points,
+    const int num_points,
+    const ImRect& bounds,
+    const float hover_distance)
+{
+    const ImVec2 mouse_pos = ImGui::GetIO().MousePos;
+
+    ImRect hover_rect = bounds;
+    hover_rect.Expand(hover_distance);
+    if (!hover_rect.Contains(mouse_pos))
+    {
+        return false;
+    }
+
+    for (int i = 1; i < num_points; ++i)
+    {
+        const ImVec2 closest =
+            ImLineClosestPoint(points[i - 1], points[i], mouse_pos);
+        if (ImLengthSqr(closest - mouse_pos) < hover_distance * hover_distance)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The segments of a route are horizontal or vertical, so each segment
+// overlaps the rectangle exactly when its bounding rect does.
+inline bool rectangle_overlaps_route(
+    const ImRect& rectangle,
+    const ImVec2* const points,
+    const int num_points)
+{
+    for (int i = 1; i < num_points; ++i)
+    {
+        const ImVec2 min = ImMin(points[i - 1], points[i]);
+        const ImVec2 max = ImMax(points[i - 1], points[i]);
+        if (min.x <= rectangle.Max.x && rectangle.Min.x <= max.x &&
+            min.y <= rectangle.Max.y && rectangle.Min.y <= max.y)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 } // namespace
 
 // [SECTION] editor context definition
 
 struct EditorContext
 {
+    // Provides the memory of the editor's containers, and of the context
+    // itself. The arena is only used by editors created with an arena.
+    EditorAllocator allocator;
+    MemoryArena arena;
+
     ObjectPool<NodeData> nodes;
     ObjectPool<PinData> pins;
     ObjectPool<LinkData> links;
 
+    // The screen space rect of each node, and position of each pin, indexed
+    // like the pools. They are kept apart from the rest of the node and pin
+    // data, so that the scans which only test geometry, such as box selection
+    // and culling, touch as few cache lines as possible.
+    EditorVector<ImRect> node_rects;
+    EditorVector<ImVec2> pin_positions;
+
     // ui related fields
     ImVec2 panning;
+    float zoom;
 
-    ImVector<int> selected_node_indices;
-    ImVector<int> selected_link_indices;
+    EditorVector<int> selected_node_indices;
+    EditorVector<int> selected_link_indices;
 
     ClickInteractionType click_interaction_type;
     ClickInteractionState click_interaction_state;
 
+    // True if any node has geometry which was loaded, but hasn't been moved to
+    // screen space yet.
+    bool has_grid_space_geometry;
+
+    LayoutState layout;
+
+    // The running force layout, and the stopped ones which are waiting for
+    // their worker to finish.
+    ForceLayout* force_layout;
+    EditorVector<ForceLayout*> stopped_force_layouts;
+
+    LinkRouter link_router;
+    MiniMapSummary minimap;
+    GridCache grid;
+    NodeGeometryCache node_geometry;
+    NodeGroups node_groups;
+
+    // The grid space bounds of all of the nodes, and of the selected nodes and
+    // the nodes at either end of the selected links, as of the last frame.
+    // Empty rects (Min > Max) if there are no such nodes.
+    ImRect content_bounds;
+    ImRect selection_bounds;
+
+    // The vertices and indices which the editor emitted into the canvas draw
+    // list during its last frame.
+    int canvas_vertices;
+    int canvas_indices;
+
+    // Nothing is allocated until the editor is used, so the allocator can be
+    // set after the context has been constructed.
     EditorContext()
-        : nodes(), pins(), links(), panning(0.f, 0.f), selected_node_indices(),
-          selected_link_indices(),
+        : allocator(), arena(), nodes(&allocator), pins(&allocator),
+          links(&allocator), node_rects(&allocator),
+          pin_positions(&allocator), panning(0.f, 0.f), zoom(1.f),
+          selected_node_indices(&allocator),
+          selected_link_indices(&allocator),
           click_interaction_type(ClickInteractionType_None),
-          click_interaction_state()
+          click_interaction_state(), has_grid_space_geometry(false),
+          layout(&allocator), force_layout(NULL),
+          stopped_force_layouts(&allocator), link_router(&allocator),
+          minimap(&allocator), grid(&allocator), node_geometry(&allocator),
+          node_groups(&allocator),
+          content_bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX),
+          selection_bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX),
+          canvas_vertices(0), canvas_indices(0)
     {
     }
 };
@@ -675,25 +1971,84 @@ namespace
 {
 // [SECTION] ui state logic
 
+#ifdef IMNODES_ENABLE_STATS
+// Fills in the counters which are only known at the end of the frame.
+void end_frame_stats(const EditorContext& editor)
+{
+    FrameStats& stats = g->stats;
+    stats.nodes_culled = stats.nodes_submitted - stats.nodes_drawn;
+    stats.pins_culled = stats.pins_submitted - stats.pins_drawn;
+    stats.links_culled = stats.links_submitted - stats.links_drawn;
+
+    stats.node_pool_size = editor.nodes.pool.size();
+    stats.node_free_list_size = editor.nodes.free_list.size();
+    stats.pin_pool_size = editor.pins.pool.size();
+    stats.pin_free_list_size = editor.pins.free_list.size();
+    stats.link_pool_size = editor.links.pool.size();
+    stats.link_free_list_size = editor.links.free_list.size();
+
+    stats.canvas_vertices =
+        g->canvas_draw_list->VtxBuffer.Size - g->canvas_vtx_begin;
+    stats.canvas_indices =
+        g->canvas_draw_list->IdxBuffer.Size - g->canvas_idx_begin;
+}
+#endif
+
+// Nodes and pins are only created through these, so that node_rects and
+// pin_positions always have an element for each slot of the pools.
+int find_or_create_node_index(EditorContext& editor, const int node_id)
+{
+    const int node_idx = editor.nodes.find_or_create_index_for(node_id);
+    if (node_idx == editor.node_rects.size())
+    {
+        editor.node_rects.push_back(ImRect(ImVec2(0.f, 0.f), ImVec2(0.f, 0.f)));
+    }
+    assert(editor.node_rects.size() == editor.nodes.pool.size());
+    return node_idx;
+}
+
+int find_or_create_pin_index(EditorContext& editor, const int pin_id)
+{
+    const int pin_idx = editor.pins.find_or_create_index_for(pin_id);
+    if (pin_idx == editor.pin_positions.size())
+    {
+        editor.pin_positions.push_back(ImVec2(0.f, 0.f));
+    }
+    assert(editor.pin_positions.size() == editor.pins.pool.size());
+    return pin_idx;
+}
+
 ImVec2 get_screen_space_pin_coordinates(
     const ImRect& node_rect,
     const ImRect& attribute_rect,
-    const AttributeType type)
+    const AttributeType type,
+    const float pin_offset)
 {
     assert(type == AttributeType_Input || type == AttributeType_Output);
     const float x = type == AttributeType_Input
-                        ? (node_rect.Min.x - g.style.pin_offset)
-                        : (node_rect.Max.x + g.style.pin_offset);
+                        ? (node_rect.Min.x - pin_offset)
+                        : (node_rect.Max.x + pin_offset);
     return ImVec2(x, 0.5f * (attribute_rect.Min.y + attribute_rect.Max.y));
 }
 
 ImVec2 get_screen_space_pin_coordinates(
-    const EditorContext& editor,
-    const PinData& pin)
-{
-    const ImRect& parent_node_rect =
-        editor.nodes.pool[pin.parent_node_idx].rect;
-    return get_screen_space_pin_coordinates(
+    const ImRect& node_rect,
+    const ImRect& attribute_rect,
+    const AttributeType type)
+{
+    return get_screen_space_pin_coordinates(
+        node_rect,
+        attribute_rect,
+        type,
+        g->style.pin_offset * editor_context_get().zoom);
+}
+
+ImVec2 get_screen_space_pin_coordinates(
+    const EditorContext& editor,
+    const PinData& pin)
+{
+    const ImRect& parent_node_rect = editor.node_rects[pin.parent_node_idx];
+    return get_screen_space_pin_coordinates(
         parent_node_rect, pin.attribute_rect, pin.type);
 }
 
@@ -721,8 +2076,8 @@ void begin_node_selection(EditorContext& editor, const int node_idx)
     // moved at once.
     if (!editor.selected_node_indices.contains(node_idx))
     {
-        editor.selected_node_indices.clear();
-        editor.selected_link_indices.clear();
+        editor.selected_node_indices.resize(0);
+        editor.selected_link_indices.resize(0);
         editor.selected_node_indices.push_back(node_idx);
     }
 }
@@ -732,8 +2087,8 @@ void begin_link_selection(EditorContext& editor, const int link_idx)
     editor.click_interaction_type = ClickInteractionType_Link;
     // When a link is selected, clear all other selections, and insert the link
     // as the sole selection.
-    editor.selected_node_indices.clear();
-    editor.selected_link_indices.clear();
+    editor.selected_node_indices.resize(0);
+    editor.selected_link_indices.resize(0);
     editor.selected_link_indices.push_back(link_idx);
 }
 
@@ -747,7 +2102,7 @@ void begin_link_detach(
     state.link_creation.start_pin_idx = detach_pin_idx == link.start_pin_idx
                                             ? link.end_pin_idx
                                             : link.start_pin_idx;
-    g.deleted_link_idx = link_idx;
+    g->deleted_link_idx = link_idx;
 }
 
 void begin_link_interaction(EditorContext& editor, const int link_idx)
@@ -756,10 +2111,10 @@ void begin_link_interaction(EditorContext& editor, const int link_idx)
     // This may result in a link detach via click and drag.
     if (editor.click_interaction_type == ClickInteractionType_LinkCreation)
     {
-        if ((g.hovered_pin_flags &
+        if ((g->hovered_pin_flags &
              AttributeFlags_EnableLinkDetachWithDragClick) != 0)
         {
-            begin_link_detach(editor, link_idx, g.hovered_pin_idx.value());
+            begin_link_detach(editor, link_idx, g->hovered_pin_idx.value());
         }
     }
     // If we aren't near a pin, check if we are clicking the link with the
@@ -767,18 +2122,18 @@ void begin_link_interaction(EditorContext& editor, const int link_idx)
     else
     {
         const bool modifier_pressed =
-            g.io.link_detach_with_modifier_click.modifier == NULL
+            g->io.link_detach_with_modifier_click.modifier == NULL
                 ? false
-                : *g.io.link_detach_with_modifier_click.modifier;
+                : *g->io.link_detach_with_modifier_click.modifier;
 
         if (modifier_pressed)
         {
             const LinkData& link = editor.links.pool[link_idx];
-            const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
-            const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
             const ImVec2& mouse_pos = ImGui::GetIO().MousePos;
-            const float dist_to_start = ImLengthSqr(start_pin.pos - mouse_pos);
-            const float dist_to_end = ImLengthSqr(end_pin.pos - mouse_pos);
+            const float dist_to_start = ImLengthSqr(
+                editor.pin_positions[link.start_pin_idx] - mouse_pos);
+            const float dist_to_end = ImLengthSqr(
+                editor.pin_positions[link.end_pin_idx] - mouse_pos);
             const int closest_pin_idx = dist_to_start < dist_to_end
                                             ? link.start_pin_idx
                                             : link.end_pin_idx;
@@ -798,17 +2153,28 @@ void begin_link_creation(EditorContext& editor, const int hovered_pin_idx)
     editor.click_interaction_type = ClickInteractionType_LinkCreation;
     editor.click_interaction_state.link_creation.start_pin_idx =
         hovered_pin_idx;
-    g.element_state_change |= ElementStateChange_LinkStarted;
+    g->element_state_change |= ElementStateChange_LinkStarted;
 }
 
 void begin_canvas_interaction(EditorContext& editor)
 {
+    // The minimap is drawn over everything else in the canvas, so it takes the
+    // clicks first.
+    if (g->minimap_hovered)
+    {
+        if (ImGui::IsMouseClicked(0) && editor.minimap.columns > 0)
+        {
+            editor.click_interaction_type = ClickInteractionType_MiniMap;
+        }
+        return;
+    }
+
     const bool any_ui_element_hovered =
-        g.hovered_node_idx.has_value() || g.hovered_link_idx.has_value() ||
-        g.hovered_pin_idx.has_value() || ImGui::IsAnyItemHovered();
+        g->hovered_node_idx.has_value() || g->hovered_link_idx.has_value() ||
+        g->hovered_pin_idx.has_value() || ImGui::IsAnyItemHovered();
 
     const bool mouse_not_in_canvas =
-        !(g.canvas_rect_screen_space.Contains(ImGui::GetMousePos()) &&
+        !(g->canvas_rect_screen_space.Contains(ImGui::GetMousePos()) &&
           ImGui::IsWindowHovered());
 
     if (any_ui_element_hovered || mouse_not_in_canvas)
@@ -820,8 +2186,8 @@ void begin_canvas_interaction(EditorContext& editor)
     const bool middle_mouse_clicked = ImGui::IsMouseClicked(2);
 
     const bool started_panning =
-        g.io.emulate_three_button_mouse.enabled
-            ? (left_mouse_clicked && *g.io.emulate_three_button_mouse.modifier)
+        g->io.emulate_three_button_mouse.enabled
+            ? (left_mouse_clicked && *g->io.emulate_three_button_mouse.modifier)
             : middle_mouse_clicked;
 
     editor.click_interaction_type = started_panning
@@ -835,8 +2201,124 @@ void begin_canvas_interaction(EditorContext& editor)
     }
 }
 
+// The box selection tests are written so that they can run on worker threads:
+// everything they read from the imnodes context is copied into this struct.
+struct BoxSelectionJobs
+{
+    const EditorContext* editor;
+    // Set when the links are routed, in which case the routes are tested
+    // instead of the curves.
+    const LinkRouter* link_router;
+    // Set when the editor is zoomed out, and the links are straight lines
+    // between the pins.
+    bool straight_links;
+    ImRect box_rect;
+    float pin_offset;
+    float line_segments_per_length;
+
+    // Only used when the tests are split into jobs. The first num_node_jobs
+    // jobs test the nodes, and the rest test the links.
+    int elements_per_job;
+    int num_node_jobs;
+    bool* node_hits;
+    bool* link_hits;
+};
+
+inline bool box_selection_overlaps_node(
+    const BoxSelectionJobs& jobs,
+    const int node_idx)
+{
+    const EditorContext& editor = *jobs.editor;
+    return editor.nodes.in_use[node_idx] &&
+           jobs.box_rect.Overlaps(editor.node_rects[node_idx]);
+}
+
+inline bool box_selection_overlaps_link(
+    const BoxSelectionJobs& jobs,
+    const int link_idx)
+{
+    const EditorContext& editor = *jobs.editor;
+    if (!editor.links.in_use[link_idx])
+    {
+        return false;
+    }
+
+    if (jobs.link_router != NULL)
+    {
+        const LinkRoute& route = jobs.link_router->routes[link_idx];
+        return rectangle_overlaps_route(
+            jobs.box_rect,
+            jobs.link_router->screen_points.Data + route.point_begin,
+            route.num_points);
+    }
+
+    const LinkData& link = editor.links.pool[link_idx];
+
+    const PinData& pin_start = editor.pins.pool[link.start_pin_idx];
+    const PinData& pin_end = editor.pins.pool[link.end_pin_idx];
+
+    if (jobs.straight_links)
+    {
+        return rectangle_overlaps_line_segment(
+            jobs.box_rect,
+            editor.pin_positions[link.start_pin_idx],
+            editor.pin_positions[link.end_pin_idx]);
+    }
+
+    const ImRect& node_start_rect =
+        editor.node_rects[pin_start.parent_node_idx];
+    const ImRect& node_end_rect = editor.node_rects[pin_end.parent_node_idx];
+
+    const ImVec2 start = get_screen_space_pin_coordinates(
+        node_start_rect,
+        pin_start.attribute_rect,
+        pin_start.type,
+        jobs.pin_offset);
+    const ImVec2 end = get_screen_space_pin_coordinates(
+        node_end_rect, pin_end.attribute_rect, pin_end.type, jobs.pin_offset);
+
+    return rectangle_overlaps_link(
+        jobs.box_rect,
+        start,
+        end,
+        pin_start.type,
+        jobs.line_segments_per_length);
+}
+
+void box_selection_job(const int job_idx, void* const job_data)
+{
+    const BoxSelectionJobs& jobs = *static_cast<BoxSelectionJobs*>(job_data);
+    const EditorContext& editor = *jobs.editor;
+
+    if (job_idx < jobs.num_node_jobs)
+    {
+        const int begin = job_idx * jobs.elements_per_job;
+        const int end =
+            ImMin(begin + jobs.elements_per_job, editor.nodes.pool.size());
+        for (int node_idx = begin; node_idx < end; ++node_idx)
+        {
+            jobs.node_hits[node_idx] =
+                box_selection_overlaps_node(jobs, node_idx);
+        }
+    }
+    else
+    {
+        const int begin =
+            (job_idx - jobs.num_node_jobs) * jobs.elements_per_job;
+        const int end =
+            ImMin(begin + jobs.elements_per_job, editor.links.pool.size());
+        for (int link_idx = begin; link_idx < end; ++link_idx)
+        {
+            jobs.link_hits[link_idx] =
+                box_selection_overlaps_link(jobs, link_idx);
+        }
+    }
+}
+
 void box_selector_update_selection(EditorContext& editor, ImRect box_rect)
 {
+    const ProfileZone zone("box_selector_update_selection");
+
     // Invert box selector coordinates as needed
 
     if (box_rect.Min.x > box_rect.Max.x)
@@ -849,53 +2331,83 @@ void box_selector_update_selection(EditorContext& editor, ImRect box_rect)
         ImSwap(box_rect.Min.y, box_rect.Max.y);
     }
 
-    // Update node selection
-
-    editor.selected_node_indices.clear();
-
-    // Test for overlap against node rectangles
-
-    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    // The box selection is updated every frame while it's dragged, so the
+    // selection keeps its capacity.
+    editor.selected_node_indices.resize(0);
+    editor.selected_link_indices.resize(0);
+
+    BoxSelectionJobs jobs;
+    jobs.editor = &editor;
+    jobs.link_router =
+        (g->style.flags & StyleFlags_OrthogonalLinks) && !g->zoomed_out
+            ? &editor.link_router
+            : NULL;
+    jobs.straight_links = g->zoomed_out;
+    jobs.box_rect = box_rect;
+    jobs.pin_offset = g->style.pin_offset * editor.zoom;
+    jobs.line_segments_per_length = g->style.link_line_segments_per_length;
+
+    const IO::ParallelFor& parallel_for = g->io.parallel_for;
+    const int num_elements =
+        editor.nodes.pool.size() + editor.links.pool.size();
+    if (parallel_for.run != NULL && num_elements >= parallel_for.min_elements)
     {
-        if (editor.nodes.in_use[node_idx])
+        // The jobs only flag the overlapping elements. The flags are gathered
+        // here in index order, so that the selection is the same as when
+        // running serially.
+        jobs.elements_per_job = ImMax(parallel_for.elements_per_job, 1);
+        jobs.num_node_jobs =
+            num_jobs_for(editor.nodes.pool.size(), jobs.elements_per_job);
+        const int num_link_jobs =
+            num_jobs_for(editor.links.pool.size(), jobs.elements_per_job);
+
+        g->box_selector_node_hits.resize(editor.nodes.pool.size());
+        g->box_selector_link_hits.resize(editor.links.pool.size());
+        jobs.node_hits = g->box_selector_node_hits.Data;
+        jobs.link_hits = g->box_selector_link_hits.Data;
+
+        parallel_for.run(
+            box_selection_job,
+            jobs.num_node_jobs + num_link_jobs,
+            &jobs,
+            parallel_for.user_data);
+
+        for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
         {
-            NodeData& node = editor.nodes.pool[node_idx];
-            if (box_rect.Overlaps(node.rect))
+            if (jobs.node_hits[node_idx])
             {
                 editor.selected_node_indices.push_back(node_idx);
             }
         }
+
+        for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+        {
+            if (jobs.link_hits[link_idx])
+            {
+                editor.selected_link_indices.push_back(link_idx);
+            }
+        }
+
+        return;
     }
 
-    // Update link selection
+    // Test for overlap against node rectangles
 
-    editor.selected_link_indices.clear();
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        if (box_selection_overlaps_node(jobs, node_idx))
+        {
+            editor.selected_node_indices.push_back(node_idx);
+        }
+    }
 
     // Test for overlap against links
 
     for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
     {
-        if (editor.links.in_use[link_idx])
+        if (box_selection_overlaps_link(jobs, link_idx))
         {
-            const LinkData& link = editor.links.pool[link_idx];
-
-            const PinData& pin_start = editor.pins.pool[link.start_pin_idx];
-            const PinData& pin_end = editor.pins.pool[link.end_pin_idx];
-            const ImRect& node_start_rect =
-                editor.nodes.pool[pin_start.parent_node_idx].rect;
-            const ImRect& node_end_rect =
-                editor.nodes.pool[pin_end.parent_node_idx].rect;
-
-            const ImVec2 start = get_screen_space_pin_coordinates(
-                node_start_rect, pin_start.attribute_rect, pin_start.type);
-            const ImVec2 end = get_screen_space_pin_coordinates(
-                node_end_rect, pin_end.attribute_rect, pin_end.type);
-
-            // Test
-            if (rectangle_overlaps_link(box_rect, start, end, pin_start.type))
-            {
-                editor.selected_link_indices.push_back(link_idx);
-            }
+            editor.selected_link_indices.push_back(link_idx);
         }
     }
 }
@@ -911,7 +2423,7 @@ void translate_selected_nodes(EditorContext& editor)
             NodeData& node = editor.nodes.pool[node_idx];
             if (node.draggable)
             {
-                node.origin += io.MouseDelta;
+                node.origin += io.MouseDelta / editor.zoom;
             }
         }
     }
@@ -923,7 +2435,7 @@ bool finish_link_at_hovered_pin(
 {
     if (!maybe_hovered_pin_idx.has_value())
     {
-        g.element_state_change |= ElementStateChange_LinkDropped;
+        g->element_state_change |= ElementStateChange_LinkDropped;
         return false;
     }
 
@@ -951,6 +2463,7 @@ bool finish_link_at_hovered_pin(
 
 void click_interaction_update(EditorContext& editor)
 {
+    const ProfileZone zone("click_interaction_update");
     const bool left_mouse_released = ImGui::IsMouseReleased(0);
 
     switch (editor.click_interaction_type)
@@ -962,12 +2475,13 @@ void click_interaction_update(EditorContext& editor)
 
         box_selector_update_selection(editor, box_rect);
 
-        const ImU32 box_selector_color = g.style.colors[ColorStyle_BoxSelector];
+        const ImU32 box_selector_color =
+            g->style.colors[ColorStyle_BoxSelector];
         const ImU32 box_selector_outline =
-            g.style.colors[ColorStyle_BoxSelectorOutline];
-        g.canvas_draw_list->AddRectFilled(
+            g->style.colors[ColorStyle_BoxSelectorOutline];
+        g->canvas_draw_list->AddRectFilled(
             box_rect.Min, box_rect.Max, box_selector_color);
-        g.canvas_draw_list->AddRect(
+        g->canvas_draw_list->AddRect(
             box_rect.Min, box_rect.Max, box_selector_outline);
 
         if (left_mouse_released)
@@ -1004,33 +2518,33 @@ void click_interaction_update(EditorContext& editor)
         // If we are within the hover radius of a receiving pin, snap the link
         // endpoint to it
         const ImVec2 end_pos =
-            g.hovered_pin_idx.has_value()
+            g->hovered_pin_idx.has_value()
                 ? get_screen_space_pin_coordinates(
-                      editor, editor.pins.pool[g.hovered_pin_idx.value()])
+                      editor, editor.pins.pool[g->hovered_pin_idx.value()])
                 : ImGui::GetIO().MousePos;
 
         const LinkBezierData link_data = get_link_renderable(
             start_pos,
             end_pos,
             pin.type,
-            g.style.link_line_segments_per_length);
-        g.canvas_draw_list->AddBezierCurve(
+            g->style.link_line_segments_per_length);
+        g->canvas_draw_list->AddBezierCurve(
             link_data.bezier.p0,
             link_data.bezier.p1,
             link_data.bezier.p2,
             link_data.bezier.p3,
-            g.style.colors[ColorStyle_Link],
-            g.style.link_thickness,
+            g->style.colors[ColorStyle_Link],
+            g->style.link_thickness * editor.zoom,
             link_data.num_segments);
 
         if (left_mouse_released)
         {
             const bool link_created_succesfully =
-                finish_link_at_hovered_pin(editor, g.hovered_pin_idx);
+                finish_link_at_hovered_pin(editor, g->hovered_pin_idx);
 
             if (link_created_succesfully)
             {
-                g.element_state_change |= ElementStateChange_LinkCreated;
+                g->element_state_change |= ElementStateChange_LinkCreated;
             }
 
             editor.click_interaction_type = ClickInteractionType_None;
@@ -1040,9 +2554,9 @@ void click_interaction_update(EditorContext& editor)
     case ClickInteractionType_Panning:
     {
         const bool dragging =
-            g.io.emulate_three_button_mouse.enabled
+            g->io.emulate_three_button_mouse.enabled
                 ? (ImGui::IsMouseDragging(0, 0.f) &&
-                   (*g.io.emulate_three_button_mouse.modifier))
+                   (*g->io.emulate_three_button_mouse.modifier))
                 : ImGui::IsMouseDragging(2, 0.f);
 
         if (dragging)
@@ -1055,6 +2569,22 @@ void click_interaction_update(EditorContext& editor)
         }
     }
     break;
+    case ClickInteractionType_MiniMap:
+    {
+        // Center the canvas on the grid space point under the mouse for as
+        // long as the button is held down.
+        const MiniMapSummary& minimap = editor.minimap;
+        const ImVec2 grid_pos =
+            (ImGui::GetIO().MousePos - minimap.screen_origin) / minimap.scale;
+        editor.panning = g->canvas_rect_screen_space.GetSize() * 0.5f -
+                         grid_pos * editor.zoom;
+
+        if (!ImGui::IsMouseDown(0))
+        {
+            editor.click_interaction_type = ClickInteractionType_None;
+        }
+    }
+    break;
     case ClickInteractionType_None:
         break;
     default:
@@ -1065,21 +2595,41 @@ void click_interaction_update(EditorContext& editor)
 
 // [SECTION] render helpers
 
+// The grid space is scaled by the zoom factor, and then offset by the panning,
+// which is in screen space units.
+
 inline ImVec2 screen_space_to_grid_space(const ImVec2& v)
 {
     const EditorContext& editor = editor_context_get();
-    return v - g.canvas_origin_screen_space - editor.panning;
+    return (v - g->canvas_origin_screen_space - editor.panning) / editor.zoom;
 }
 
 inline ImVec2 grid_space_to_editor_space(const ImVec2& v)
 {
     const EditorContext& editor = editor_context_get();
-    return v + editor.panning;
+    return v * editor.zoom + editor.panning;
 }
 
 inline ImVec2 editor_space_to_screen_space(const ImVec2& v)
 {
-    return g.canvas_origin_screen_space + v;
+    return g->canvas_origin_screen_space + v;
+}
+
+inline ImVec2 grid_space_to_screen_space(const ImVec2& v)
+{
+    return editor_space_to_screen_space(grid_space_to_editor_space(v));
+}
+
+inline ImRect screen_space_to_grid_space(const ImRect& r)
+{
+    return ImRect(
+        screen_space_to_grid_space(r.Min), screen_space_to_grid_space(r.Max));
+}
+
+inline ImRect grid_space_to_screen_space(const ImRect& r)
+{
+    return ImRect(
+        grid_space_to_screen_space(r.Min), grid_space_to_screen_space(r.Max));
 }
 
 inline ImRect get_item_rect()
@@ -1087,42 +2637,277 @@ inline ImRect get_item_rect()
     return ImRect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax());
 }
 
+// The node's layout style and rects are in screen space units, and are scaled
+// back to the grid space here.
+
 inline ImVec2 get_node_title_bar_origin(const NodeData& node)
 {
-    return node.origin + node.layout_style.padding;
+    const EditorContext& editor = editor_context_get();
+    return node.origin + get_node_style(node).padding / editor.zoom;
 }
 
 inline ImVec2 get_node_content_origin(const NodeData& node)
 {
-
+    const EditorContext& editor = editor_context_get();
+    const ImVec2 padding = get_node_style(node).padding;
     const ImVec2 title_bar_height = ImVec2(
-        0.f,
-        node.title_bar_content_rect.GetHeight() +
-            2.0f * node.layout_style.padding.y);
-    return node.origin + title_bar_height + node.layout_style.padding;
+        0.f, node.title_bar_content_rect.GetHeight() + 2.0f * padding.y);
+    return node.origin + (title_bar_height + padding) / editor.zoom;
 }
 
-void draw_grid(EditorContext& editor, const ImVec2& canvas_size)
+// Reserves room in the canvas draw list for as many vertices and indices as the
+// editor emitted during its last frame, so that the buffers aren't regrown
+// step by step while the elements are drawn. Nothing is allocated once the
+// draw list has grown to the editor's size.
+void reserve_canvas_draw_list(const EditorContext& editor)
 {
-    const ImVec2 offset = editor.panning;
+    ImDrawList& draw_list = *g->canvas_draw_list;
+    g->canvas_vtx_begin = draw_list.VtxBuffer.Size;
+    g->canvas_idx_begin = draw_list.IdxBuffer.Size;
+    draw_list.VtxBuffer.reserve(g->canvas_vtx_begin + editor.canvas_vertices);
+    draw_list.IdxBuffer.reserve(g->canvas_idx_begin + editor.canvas_indices);
+    // Only PrimReserve() updates the write pointers, and the buffers may have
+    // moved.
+    draw_list._VtxWritePtr =
+        draw_list.VtxBuffer.Data + draw_list.VtxBuffer.Size;
+    draw_list._IdxWritePtr =
+        draw_list.IdxBuffer.Data + draw_list.IdxBuffer.Size;
+}
+
+void record_canvas_draw_list_size(EditorContext& editor)
+{
+    const ImDrawList& draw_list = *g->canvas_draw_list;
+    editor.canvas_vertices = draw_list.VtxBuffer.Size - g->canvas_vtx_begin;
+    editor.canvas_indices = draw_list.IdxBuffer.Size - g->canvas_idx_begin;
+}
+
+// Moves the node and pin rects which were loaded with LoadEditorStateFrom* to
+// screen space. This allows the nodes to be culled and hit tested, and the
+// links to be drawn, before the nodes have been submitted for the first time.
+void restore_node_geometry(EditorContext& editor)
+{
+    if (!editor.has_grid_space_geometry)
+    {
+        return;
+    }
+
+    for (int i = 0; i < editor.pins.pool.size(); ++i)
+    {
+        PinData& pin = editor.pins.pool[i];
+        const NodeData& node = editor.nodes.pool[pin.parent_node_idx];
+        if (node.geometry_in_grid_space && pin.type != AttributeType_None)
+        {
+            const ImRect& node_rect = editor.node_rects[pin.parent_node_idx];
+            pin.attribute_rect = grid_space_to_screen_space(pin.attribute_rect);
+            editor.pin_positions[i] = get_screen_space_pin_coordinates(
+                grid_space_to_screen_space(node_rect),
+                pin.attribute_rect,
+                pin.type);
+        }
+    }
+
+    for (int i = 0; i < editor.nodes.pool.size(); ++i)
+    {
+        NodeData& node = editor.nodes.pool[i];
+        if (node.geometry_in_grid_space)
+        {
+            ImRect& node_rect = editor.node_rects[i];
+            node_rect = grid_space_to_screen_space(node_rect);
+            node.title_bar_content_rect =
+                grid_space_to_screen_space(node.title_bar_content_rect);
+            node.geometry_in_grid_space = false;
+        }
+    }
+
+    editor.has_grid_space_geometry = false;
+}
 
-    for (float x = fmodf(offset.x, g.style.grid_spacing); x < canvas_size.x;
-         x += g.style.grid_spacing)
+// Returns the scratch draw list, cleared and set up like the canvas draw list.
+ImDrawList& begin_scratch_draw_list()
+{
+    const ImDrawList& canvas = *g->canvas_draw_list;
+    if (g->scratch_draw_list == NULL)
+    {
+        g->scratch_draw_list = IM_NEW(ImDrawList)(canvas._Data);
+    }
+    ImDrawList& draw_list = *g->scratch_draw_list;
+    draw_list.Clear();
+    draw_list.Flags = canvas.Flags & ~ImDrawListFlags_AllowVtxOffset;
+    draw_list.AddDrawCmd();
+    return draw_list;
+}
+
+template<typename Vector>
+void copy_draw_list_buffer(
+    Vector& dst,
+    const ImVector<typename Vector::value_type>& src)
+{
+    dst.resize(src.size());
+    if (src.size() > 0)
+    {
+        memcpy(
+            static_cast<void*>(dst.Data),
+            src.Data,
+            src.size() * sizeof(typename Vector::value_type));
+    }
+}
+
+// Copies a block of vertices and indices, which was drawn into another draw
+// list, to the canvas draw list. The vertices are moved by offset, and their
+// colors are masked with color_mask. The block's first vertex was vtx_base.
+void copy_vertex_block(
+    const ImDrawVert* const vertices,
+    const int vtx_count,
+    const ImDrawIdx* const indices,
+    const int idx_count,
+    const int vtx_base,
+    const ImVec2& offset,
+    const ImU32 color_mask)
+{
+    if (vtx_count == 0)
+    {
+        return;
+    }
+
+    ImDrawList& draw_list = *g->canvas_draw_list;
+    draw_list.PrimReserve(idx_count, vtx_count);
+    ImDrawVert* const vtx_dst = draw_list._VtxWritePtr;
+    for (int i = 0; i < vtx_count; ++i)
+    {
+        vtx_dst[i].pos = vertices[i].pos + offset;
+        vtx_dst[i].uv = vertices[i].uv;
+        vtx_dst[i].col = vertices[i].col & color_mask;
+    }
+    ImDrawIdx* const idx_dst = draw_list._IdxWritePtr;
+    for (int i = 0; i < idx_count; ++i)
+    {
+        idx_dst[i] = static_cast<ImDrawIdx>(
+            indices[i] - vtx_base + draw_list._VtxCurrentIdx);
+    }
+
+    draw_list._VtxWritePtr += vtx_count;
+    draw_list._IdxWritePtr += idx_count;
+    draw_list._VtxCurrentIdx += vtx_count;
+}
+
+// Draws the lines which can be visible at any panning into the grid cache,
+// unless it was already built for the canvas size, spacing and color.
+void update_grid_cache(
+    GridCache& grid,
+    const ImVec2& canvas_size,
+    const float spacing,
+    const ImU32 color)
+{
+    const ImDrawList& canvas = *g->canvas_draw_list;
+    const ImVec2 uv = canvas._Data->TexUvWhitePixel;
+    if (grid.built && grid.canvas_size.x == canvas_size.x &&
+        grid.canvas_size.y == canvas_size.y && grid.spacing == spacing &&
+        grid.color == color && grid.flags == canvas.Flags &&
+        grid.tex_uv_white_pixel.x == uv.x && grid.tex_uv_white_pixel.y == uv.y)
+    {
+        return;
+    }
+
+    // The first visible line is up to a spacing before the canvas origin.
+    grid.num_vertical_lines =
+        ImMax(static_cast<int>(canvas_size.x / spacing) + 2, 0);
+    grid.num_horizontal_lines =
+        ImMax(static_cast<int>(canvas_size.y / spacing) + 2, 0);
+
+    ImDrawList& draw_list = begin_scratch_draw_list();
+    for (int i = 0; i < grid.num_vertical_lines; ++i)
+    {
+        const float x = static_cast<float>(i) * spacing;
+        draw_list.AddLine(ImVec2(x, 0.f), ImVec2(x, canvas_size.y), color);
+    }
+    for (int i = 0; i < grid.num_horizontal_lines; ++i)
+    {
+        const float y = static_cast<float>(i) * spacing;
+        draw_list.AddLine(ImVec2(0.f, y), ImVec2(canvas_size.x, y), color);
+    }
+
+    const int num_lines = grid.num_vertical_lines + grid.num_horizontal_lines;
+    grid.vtx_per_line =
+        num_lines > 0 ? draw_list.VtxBuffer.size() / num_lines : 0;
+    grid.idx_per_line =
+        num_lines > 0 ? draw_list.IdxBuffer.size() / num_lines : 0;
+    assert(grid.vtx_per_line * num_lines == draw_list.VtxBuffer.size());
+    copy_draw_list_buffer(grid.vertices, draw_list.VtxBuffer);
+    copy_draw_list_buffer(grid.indices, draw_list.IdxBuffer);
+
+    grid.canvas_size = canvas_size;
+    grid.spacing = spacing;
+    grid.color = color;
+    grid.flags = canvas.Flags;
+    grid.tex_uv_white_pixel = uv;
+    grid.built = true;
+}
+
+// Copies num_lines of the cached lines, starting from first_line, to the
+// canvas draw list, moved by offset.
+void copy_grid_lines(
+    const GridCache& grid,
+    const int first_line,
+    const int num_lines,
+    const ImVec2& offset)
+{
+    const int vtx_begin = first_line * grid.vtx_per_line;
+    copy_vertex_block(
+        grid.vertices.Data + vtx_begin,
+        num_lines * grid.vtx_per_line,
+        grid.indices.Data + first_line * grid.idx_per_line,
+        num_lines * grid.idx_per_line,
+        vtx_begin,
+        offset,
+        IM_COL32_WHITE);
+}
+
+// Counts the lines from start which are before end.
+inline int count_grid_lines(
+    const float start,
+    const float end,
+    const float spacing)
+{
+    int count = 0;
+    for (float x = start; x < end; x += spacing)
     {
-        g.canvas_draw_list->AddLine(
-            editor_space_to_screen_space(ImVec2(x, 0.0f)),
-            editor_space_to_screen_space(ImVec2(x, canvas_size.y)),
-            g.style.colors[ColorStyle_GridLine]);
+        ++count;
     }
+    return count;
+}
 
-    for (float y = fmodf(offset.y, g.style.grid_spacing); y < canvas_size.y;
-         y += g.style.grid_spacing)
+void draw_grid(EditorContext& editor, const ImVec2& canvas_size)
+{
+    const ImVec2 offset = editor.panning;
+
+    // When zoomed out, skip every other grid line until the lines are far
+    // enough apart.
+    float spacing = g->style.grid_spacing * editor.zoom;
+    while (spacing < 0.5f * g->style.grid_spacing)
     {
-        g.canvas_draw_list->AddLine(
-            editor_space_to_screen_space(ImVec2(0.0f, y)),
-            editor_space_to_screen_space(ImVec2(canvas_size.x, y)),
-            g.style.colors[ColorStyle_GridLine]);
+        spacing *= 2.f;
     }
+
+    GridCache& grid = editor.grid;
+    update_grid_cache(
+        grid, canvas_size, spacing, g->style.colors[ColorStyle_GridLine]);
+
+    const ImVec2 first_line(fmodf(offset.x, spacing), fmodf(offset.y, spacing));
+    const ImVec2 origin = editor_space_to_screen_space(ImVec2(0.f, 0.f));
+    copy_grid_lines(
+        grid,
+        0,
+        ImMin(
+            count_grid_lines(first_line.x, canvas_size.x, spacing),
+            grid.num_vertical_lines),
+        origin + ImVec2(first_line.x, 0.f));
+    copy_grid_lines(
+        grid,
+        grid.num_vertical_lines,
+        ImMin(
+            count_grid_lines(first_line.y, canvas_size.y, spacing),
+            grid.num_horizontal_lines),
+        origin + ImVec2(0.f, first_line.y));
 }
 
 struct QuadOffsets
@@ -1173,49 +2958,56 @@ TriangleOffsets calculate_triangle_offsets(const float side_length)
     return offset;
 }
 
-void draw_pin_shape(
+// The shape is scaled by the editor's zoom, like the nodes are.
+void add_pin_shape(
+    ImDrawList& draw_list,
     const ImVec2& pin_pos,
-    const PinData& pin,
-    const ImU32 pin_color)
+    const PinShape shape,
+    const ImU32 pin_color,
+    const float zoom)
 {
     static const int circle_num_segments = 8;
+    const float line_thickness = g->style.pin_line_thickness * zoom;
 
-    switch (pin.shape)
+    switch (shape)
     {
     case PinShape_Circle:
     {
-        g.canvas_draw_list->AddCircle(
+        draw_list.AddCircle(
             pin_pos,
-            g.style.pin_circle_radius,
+            g->style.pin_circle_radius * zoom,
             pin_color,
             circle_num_segments,
-            g.style.pin_line_thickness);
+            line_thickness);
     }
     break;
     case PinShape_CircleFilled:
     {
-        g.canvas_draw_list->AddCircleFilled(
-            pin_pos, g.style.pin_circle_radius, pin_color, circle_num_segments);
+        draw_list.AddCircleFilled(
+            pin_pos,
+            g->style.pin_circle_radius * zoom,
+            pin_color,
+            circle_num_segments);
     }
     break;
     case PinShape_Quad:
     {
         const QuadOffsets offset =
-            calculate_quad_offsets(g.style.pin_quad_side_length);
-        g.canvas_draw_list->AddQuad(
+            calculate_quad_offsets(g->style.pin_quad_side_length * zoom);
+        draw_list.AddQuad(
             pin_pos + offset.top_left,
             pin_pos + offset.bottom_left,
             pin_pos + offset.bottom_right,
             pin_pos + offset.top_right,
             pin_color,
-            g.style.pin_line_thickness);
+            line_thickness);
     }
     break;
     case PinShape_QuadFilled:
     {
         const QuadOffsets offset =
-            calculate_quad_offsets(g.style.pin_quad_side_length);
-        g.canvas_draw_list->AddQuadFilled(
+            calculate_quad_offsets(g->style.pin_quad_side_length * zoom);
+        draw_list.AddQuadFilled(
             pin_pos + offset.top_left,
             pin_pos + offset.bottom_left,
             pin_pos + offset.bottom_right,
@@ -1226,8 +3018,9 @@ void draw_pin_shape(
     case PinShape_Triangle:
     {
         const TriangleOffsets offset =
-            calculate_triangle_offsets(g.style.pin_triangle_side_length);
-        g.canvas_draw_list->AddTriangle(
+            calculate_triangle_offsets(
+                g->style.pin_triangle_side_length * zoom);
+        draw_list.AddTriangle(
             pin_pos + offset.top_left,
             pin_pos + offset.bottom_left,
             pin_pos + offset.right,
@@ -1236,14 +3029,15 @@ void draw_pin_shape(
             // much thinner than the lines drawn by AddCircle or AddQuad.
             // Multiplying the line thickness by two seemed to solve the
             // problem at a few different thickness values.
-            2.f * g.style.pin_line_thickness);
+            2.f * line_thickness);
     }
     break;
     case PinShape_TriangleFilled:
     {
         const TriangleOffsets offset =
-            calculate_triangle_offsets(g.style.pin_triangle_side_length);
-        g.canvas_draw_list->AddTriangleFilled(
+            calculate_triangle_offsets(
+                g->style.pin_triangle_side_length * zoom);
+        draw_list.AddTriangleFilled(
             pin_pos + offset.top_left,
             pin_pos + offset.bottom_left,
             pin_pos + offset.right,
@@ -1256,25 +3050,104 @@ void draw_pin_shape(
     }
 }
 
+float get_pin_shape_size(const PinShape shape)
+{
+    switch (shape)
+    {
+    case PinShape_Circle:
+    case PinShape_CircleFilled:
+        return g->style.pin_circle_radius;
+    case PinShape_Triangle:
+    case PinShape_TriangleFilled:
+        return g->style.pin_triangle_side_length;
+    case PinShape_Quad:
+    case PinShape_QuadFilled:
+        return g->style.pin_quad_side_length;
+    default:
+        assert(!"Invalid PinShape value!");
+        return 0.f;
+    }
+}
+
+const PinShapeTemplate& get_pin_shape_template(
+    const PinShape shape,
+    const float zoom)
+{
+    assert(shape >= 0 && shape < num_pin_shapes);
+    PinShapeTemplate& shape_template = g->pin_shape_templates[shape];
+    const ImDrawList& canvas = *g->canvas_draw_list;
+    const float size = get_pin_shape_size(shape);
+    const ImVec2 uv = canvas._Data->TexUvWhitePixel;
+    if (shape_template.built && shape_template.size == size &&
+        shape_template.line_thickness == g->style.pin_line_thickness &&
+        shape_template.zoom == zoom && shape_template.flags == canvas.Flags &&
+        shape_template.tex_uv_white_pixel.x == uv.x &&
+        shape_template.tex_uv_white_pixel.y == uv.y)
+    {
+        return shape_template;
+    }
+
+    ImDrawList& draw_list = begin_scratch_draw_list();
+    add_pin_shape(draw_list, ImVec2(0.f, 0.f), shape, IM_COL32_WHITE, zoom);
+
+    shape_template.size = size;
+    shape_template.line_thickness = g->style.pin_line_thickness;
+    shape_template.zoom = zoom;
+    shape_template.flags = canvas.Flags;
+    shape_template.tex_uv_white_pixel = uv;
+    shape_template.built = true;
+    shape_template.vertices = draw_list.VtxBuffer;
+    shape_template.indices = draw_list.IdxBuffer;
+    return shape_template;
+}
+
+// Copies the pin shape's template to the pin position, instead of tessellating
+// the shape again for each pin.
+void draw_pin_shape(
+    const ImVec2& pin_pos,
+    const PinData& pin,
+    const ImU32 pin_color,
+    const float zoom)
+{
+    // ImGui draws nothing for transparent shapes.
+    if ((pin_color & IM_COL32_A_MASK) == 0)
+    {
+        return;
+    }
+
+    const PinShapeTemplate& shape_template =
+        get_pin_shape_template(pin.shape, zoom);
+    copy_vertex_block(
+        shape_template.vertices.Data,
+        shape_template.vertices.size(),
+        shape_template.indices.Data,
+        shape_template.indices.size(),
+        0,
+        pin_pos,
+        pin_color);
+}
+
 void draw_pin(
     EditorContext& editor,
     const int pin_idx,
     const bool left_mouse_clicked)
 {
-    PinData& pin = editor.pins.pool[pin_idx];
-    const ImRect& parent_node_rect =
-        editor.nodes.pool[pin.parent_node_idx].rect;
-
-    pin.pos = get_screen_space_pin_coordinates(
-        parent_node_rect, pin.attribute_rect, pin.type);
-
-    ImU32 pin_color = pin.color_style.background;
-
-    if (is_mouse_hovering_near_point(pin.pos, g.style.pin_hover_radius))
+    const PinData& pin = editor.pins.pool[pin_idx];
+    const ImVec2 pin_pos = get_screen_space_pin_coordinates(
+        editor.node_rects[pin.parent_node_idx], pin.attribute_rect, pin.type);
+    editor.pin_positions[pin_idx] = pin_pos;
+
+    const PinStyle& pin_style = get_pin_style(pin);
+    ImU32 pin_color = pin_style.background;
+    IMNODES_STAT(++g->stats.pins_drawn);
+
+    if (!g->minimap_hovered &&
+        is_mouse_hovering_near_point(
+            pin_pos, g->style.pin_hover_radius * editor.zoom))
     {
-        g.hovered_pin_idx = pin_idx;
-        g.hovered_pin_flags = pin.flags;
-        pin_color = pin.color_style.hovered;
+        g->hovered_pin_idx = pin_idx;
+        g->hovered_pin_flags = pin.flags;
+        pin_color = pin_style.hovered;
 
         if (left_mouse_clicked)
         {
@@ -1282,111 +3155,468 @@ void draw_pin(
         }
     }
 
-    draw_pin_shape(pin.pos, pin, pin_color);
+    draw_pin_shape(pin_pos, pin, pin_color, editor.zoom);
 }
 
-// TODO: It may be useful to make this an EditorContext method, since this uses
-// a lot of editor state. Currently that is just not clear, since we don't pass
-// the editor as a part of the function signature.
-void draw_node(EditorContext& editor, const int node_idx)
+void add_node_background(
+    ImDrawList& draw_list,
+    const ImVec2& node_min,
+    const NodeGeometryKey& key)
 {
-    const NodeData& node = editor.nodes.pool[node_idx];
-    ImGui::SetCursorPos(node.origin + editor.panning);
-    // InvisibleButton's str_id can be left empty if we push our own
-    // id on the stack.
-    ImGui::PushID(node.id);
-    ImGui::InvisibleButton("", node.rect.GetSize());
-    ImGui::PopID();
-
-    const bool item_hovered = ImGui::IsItemHovered();
-
-    ImU32 node_background = node.color_style.background;
-    ImU32 titlebar_background = node.color_style.titlebar;
+    // node base
+    draw_list.AddRectFilled(
+        node_min, node_min + key.size, key.background, key.corner_rounding);
 
-    if (editor.selected_node_indices.contains(node_idx))
-    {
-        node_background = node.color_style.background_selected;
-        titlebar_background = node.color_style.titlebar_selected;
-    }
-    else if (item_hovered)
+    // title bar:
+    if (key.has_title_bar)
     {
-        node_background = node.color_style.background_hovered;
-        titlebar_background = node.color_style.titlebar_hovered;
+        draw_list.AddRectFilled(
+            node_min + key.title_bar_rect.Min,
+            node_min + key.title_bar_rect.Max,
+            key.titlebar,
+            key.corner_rounding,
+            ImDrawCornerFlags_Top);
     }
 
+    if (key.has_outline)
     {
-        // node base
-        g.canvas_draw_list->AddRectFilled(
-            node.rect.Min,
-            node.rect.Max,
-            node_background,
-            node.layout_style.corner_rounding);
-
-        // title bar:
-        if (node.title_bar_content_rect.GetHeight() > 0.f)
-        {
-            ImRect expanded_title_rect = node.title_bar_content_rect;
-            expanded_title_rect.Expand(node.layout_style.padding);
+        draw_list.AddRect(
+            node_min, node_min + key.size, key.outline, key.corner_rounding);
+    }
+}
 
-            ImRect title_bar_rect = ImRect(
-                expanded_title_rect.Min,
-                expanded_title_rect.Min + ImVec2(node.rect.GetWidth(), 0.f) +
-                    ImVec2(0.f, expanded_title_rect.GetHeight()));
+inline bool node_geometry_keys_equal(
+    const NodeGeometryKey& lhs,
+    const NodeGeometryKey& rhs)
+{
+    return lhs.size.x == rhs.size.x && lhs.size.y == rhs.size.y &&
+           lhs.has_title_bar == rhs.has_title_bar &&
+           (!lhs.has_title_bar ||
+            (lhs.title_bar_rect.Min.x == rhs.title_bar_rect.Min.x &&
+             lhs.title_bar_rect.Min.y == rhs.title_bar_rect.Min.y &&
+             lhs.title_bar_rect.Max.x == rhs.title_bar_rect.Max.x &&
+             lhs.title_bar_rect.Max.y == rhs.title_bar_rect.Max.y &&
+             lhs.titlebar == rhs.titlebar)) &&
+           lhs.background == rhs.background &&
+           lhs.has_outline == rhs.has_outline &&
+           (!lhs.has_outline || lhs.outline == rhs.outline) &&
+           lhs.corner_rounding == rhs.corner_rounding;
+}
 
-            g.canvas_draw_list->AddRectFilled(
-                title_bar_rect.Min,
-                title_bar_rect.Max,
-                titlebar_background,
-                node.layout_style.corner_rounding,
-                ImDrawCornerFlags_Top);
-        }
+void reset_node_geometry_cache(NodeGeometryCache& cache)
+{
+    cache.nodes.clear();
+    cache.vertices.clear();
+    cache.indices.clear();
+    cache.stale_vertices = 0;
+}
 
-        if ((g.style.flags & StyleFlags_NodeOutline) != 0)
-        {
-            g.canvas_draw_list->AddRect(
-                node.rect.Min,
-                node.rect.Max,
-                node.color_style.outline,
-                node.layout_style.corner_rounding);
-        }
+// Drops the cached node geometry if it was drawn with other draw list flags or
+// font atlas, or if too much of it is taken by outgrown blocks.
+void validate_node_geometry_cache(NodeGeometryCache& cache)
+{
+    const ImDrawList& canvas = *g->canvas_draw_list;
+    const ImVec2 uv = canvas._Data->TexUvWhitePixel;
+    if (cache.flags != canvas.Flags || cache.tex_uv_white_pixel.x != uv.x ||
+        cache.tex_uv_white_pixel.y != uv.y ||
+        cache.stale_vertices > cache.vertices.size() / 2)
+    {
+        reset_node_geometry_cache(cache);
+        cache.flags = canvas.Flags;
+        cache.tex_uv_white_pixel = uv;
     }
+}
 
-    // TODO: this could be done at the beginning of BeginNodeEditor and the
-    // value could be stored in the global struct.
-    const bool left_mouse_clicked = ImGui::IsMouseClicked(0);
+// Tessellates the node's background relative to its rect, and stores it in
+// the node's block, which moves to the end of the cache if it doesn't fit.
+void build_node_geometry(
+    NodeGeometryCache& cache,
+    NodeGeometry& geometry,
+    const NodeGeometryKey& key)
+{
+    ImDrawList& draw_list = begin_scratch_draw_list();
+    add_node_background(draw_list, ImVec2(0.f, 0.f), key);
+    const int vtx_count = draw_list.VtxBuffer.size();
+    const int idx_count = draw_list.IdxBuffer.size();
 
-    for (int i = 0; i < node.pin_indices.size(); ++i)
+    if (vtx_count > geometry.vtx_capacity)
     {
-        draw_pin(editor, node.pin_indices[i], left_mouse_clicked);
+        cache.stale_vertices += geometry.vtx_capacity;
+        geometry.vtx_begin = cache.vertices.size();
+        geometry.vtx_capacity = vtx_count;
+        cache.vertices.resize(cache.vertices.size() + vtx_count);
     }
-
-    if (item_hovered)
+    if (idx_count > geometry.idx_capacity)
     {
-        g.hovered_node_idx = node_idx;
-        if (left_mouse_clicked)
-        {
-            begin_node_selection(editor, node_idx);
-        }
+        geometry.idx_begin = cache.indices.size();
+        geometry.idx_capacity = idx_count;
+        cache.indices.resize(cache.indices.size() + idx_count);
     }
-}
 
-void draw_link(EditorContext& editor, const int link_idx)
+    if (vtx_count > 0)
+    {
+        memcpy(
+            static_cast<void*>(cache.vertices.Data + geometry.vtx_begin),
+            draw_list.VtxBuffer.Data,
+            vtx_count * sizeof(ImDrawVert));
+    }
+    if (idx_count > 0)
+    {
+        memcpy(
+            static_cast<void*>(cache.indices.Data + geometry.idx_begin),
+            draw_list.IdxBuffer.Data,
+            idx_count * sizeof(ImDrawIdx));
+    }
+
+    geometry.key = key;
+    geometry.built = true;
+    geometry.vtx_count = vtx_count;
+    geometry.idx_count = idx_count;
+}
+
+void draw_node_background(
+    EditorContext& editor,
+    const int node_idx,
+    const NodeGeometryKey& key)
+{
+    NodeGeometryCache& cache = editor.node_geometry;
+    while (cache.nodes.size() <= node_idx)
+    {
+        cache.nodes.push_back(NodeGeometry());
+    }
+
+    NodeGeometry& geometry = cache.nodes[node_idx];
+    if (!geometry.built || !node_geometry_keys_equal(geometry.key, key))
+    {
+        build_node_geometry(cache, geometry, key);
+    }
+
+    copy_vertex_block(
+        cache.vertices.Data + geometry.vtx_begin,
+        geometry.vtx_count,
+        cache.indices.Data + geometry.idx_begin,
+        geometry.idx_count,
+        0,
+        editor.node_rects[node_idx].Min,
+        IM_COL32_WHITE);
+}
+
+// TODO: It may be useful to make this an EditorContext method, since this uses
+// a lot of editor state. Currently that is just not clear, since we don't pass
+// the editor as a part of the function signature.
+void draw_node(EditorContext& editor, const int node_idx)
+{
+    const ProfileZone zone("draw_node");
+    const NodeData& node = editor.nodes.pool[node_idx];
+    const ImRect& node_rect = editor.node_rects[node_idx];
+    ImGui::SetCursorPos(grid_space_to_editor_space(node.origin));
+    // InvisibleButton's str_id can be left empty if we push our own
+    // id on the stack.
+    ImGui::PushID(node.id);
+    ImGui::InvisibleButton("", node_rect.GetSize());
+    ImGui::PopID();
+
+    const bool item_hovered = ImGui::IsItemHovered() && !g->minimap_hovered;
+    IMNODES_STAT(++g->stats.nodes_drawn);
+
+    const NodeStyle& node_style = get_node_style(node);
+    ImU32 node_background = node_style.background;
+    ImU32 titlebar_background = node_style.titlebar;
+
+    if (editor.selected_node_indices.contains(node_idx))
+    {
+        node_background = node_style.background_selected;
+        titlebar_background = node_style.titlebar_selected;
+    }
+    else if (item_hovered)
+    {
+        node_background = node_style.background_hovered;
+        titlebar_background = node_style.titlebar_hovered;
+    }
+
+    {
+        NodeGeometryKey key;
+        key.size = node_rect.GetSize();
+        key.background = node_background;
+        key.titlebar = titlebar_background;
+        key.outline = node_style.outline;
+        key.corner_rounding = node_style.corner_rounding;
+        key.has_outline = (g->style.flags & StyleFlags_NodeOutline) != 0;
+
+        if (node.title_bar_content_rect.GetHeight() > 0.f)
+        {
+            ImRect expanded_title_rect = node.title_bar_content_rect;
+            expanded_title_rect.Expand(node_style.padding);
+
+            key.has_title_bar = true;
+            key.title_bar_rect = ImRect(
+                expanded_title_rect.Min - node_rect.Min,
+                expanded_title_rect.Min - node_rect.Min +
+                    ImVec2(node_rect.GetWidth(), 0.f) +
+                    ImVec2(0.f, expanded_title_rect.GetHeight()));
+        }
+
+        draw_node_background(editor, node_idx, key);
+    }
+
+    // TODO: this could be done at the beginning of BeginNodeEditor and the
+    // value could be stored in the global struct.
+    const bool left_mouse_clicked = ImGui::IsMouseClicked(0);
+
+    for (int i = node.pin_index_begin; i < node.pin_index_end; ++i)
+    {
+        draw_pin(editor, g->pin_indices[i], left_mouse_clicked);
+    }
+
+    if (item_hovered)
+    {
+        g->hovered_node_idx = node_idx;
+        if (left_mouse_clicked)
+        {
+            begin_node_selection(editor, node_idx);
+        }
+    }
+}
+
+// The size of a node which is drawn zoomed out before its contents have ever
+// been measured, in grid space units.
+const ImVec2 unmeasured_node_size(100.f, 50.f);
+
+// Nodes which haven't been measured yet have the size they are drawn with
+// while zoomed out.
+inline ImRect get_node_grid_space_rect(const NodeData& node)
+{
+    const ImVec2 size =
+        node.grid_space_size.x > 0.f && node.grid_space_size.y > 0.f
+            ? node.grid_space_size
+            : unmeasured_node_size;
+    return ImRect(node.origin, node.origin + size);
+}
+
+// The content bounds are gathered as the nodes are submitted, and the
+// selection bounds from the selection once the interactions are done, so that
+// neither has to look at every node when the view is moved to them.
+void update_view_bounds(EditorContext& editor)
+{
+    editor.selection_bounds = ImRect(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+    {
+        editor.selection_bounds.Add(get_node_grid_space_rect(
+            editor.nodes.pool[editor.selected_node_indices[i]]));
+    }
+
+    for (int i = 0; i < editor.selected_link_indices.size(); ++i)
+    {
+        const LinkData& link =
+            editor.links.pool[editor.selected_link_indices[i]];
+        const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
+        const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
+        editor.selection_bounds.Add(get_node_grid_space_rect(
+            editor.nodes.pool[start_pin.parent_node_idx]));
+        editor.selection_bounds.Add(get_node_grid_space_rect(
+            editor.nodes.pool[end_pin.parent_node_idx]));
+    }
+
+    // Dragging the selected nodes moves them after they were submitted.
+    editor.content_bounds = g->content_bounds;
+    editor.content_bounds.Add(editor.selection_bounds);
+}
+
+// Centers the view on the grid space rect, and zooms out until all of it is
+// visible. Doesn't zoom in past a zoom of 1.
+void frame_grid_space_rect(EditorContext& editor, const ImRect& rect)
+{
+    if (rect.Min.x > rect.Max.x)
+    {
+        return;
+    }
+
+    // Leave a margin around the rect.
+    const ImVec2 canvas_size = g->canvas_rect_screen_space.GetSize();
+    const ImVec2 size = rect.GetSize() * 1.1f;
+    if (canvas_size.x > 0.f && canvas_size.y > 0.f && size.x > 0.f &&
+        size.y > 0.f)
+    {
+        editor.zoom = ImMin(
+            ImMin(canvas_size.x / size.x, canvas_size.y / size.y), 1.f);
+    }
+    editor.panning = canvas_size * 0.5f - rect.GetCenter() * editor.zoom;
+}
+
+inline ImRect remap_rect(
+    const ImRect& rect,
+    const ImVec2& old_min,
+    const ImVec2& new_min,
+    const ImVec2& scale)
+{
+    return ImRect(
+        new_min + (rect.Min - old_min) * scale,
+        new_min + (rect.Max - old_min) * scale);
+}
+
+// Moves the node to its current position while zoomed out, using the size
+// measured during the last frame which drew its contents. The title bar and the
+// attribute rects are scaled along with the node, so that the pins, and the
+// layouts which use the rects, stay where they were.
+void update_zoomed_out_node(EditorContext& editor, const int node_idx)
+{
+    NodeData& node = editor.nodes.pool[node_idx];
+    const ImVec2 grid_space_size =
+        node.grid_space_size.x > 0.f && node.grid_space_size.y > 0.f
+            ? node.grid_space_size
+            : unmeasured_node_size;
+
+    ImRect& node_rect = editor.node_rects[node_idx];
+    const ImRect old_rect = node_rect;
+    const ImVec2 min = grid_space_to_screen_space(node.origin);
+    node_rect = ImRect(min, min + grid_space_size * editor.zoom);
+
+    const ImVec2 old_size = old_rect.GetSize();
+    const ImVec2 new_size = node_rect.GetSize();
+    const ImVec2 scale(
+        old_size.x > 0.f ? new_size.x / old_size.x : 0.f,
+        old_size.y > 0.f ? new_size.y / old_size.y : 0.f);
+
+    node.title_bar_content_rect =
+        remap_rect(node.title_bar_content_rect, old_rect.Min, min, scale);
+    for (int i = node.pin_index_begin; i < node.pin_index_end; ++i)
+    {
+        const int pin_idx = g->pin_indices[i];
+        PinData& pin = editor.pins.pool[pin_idx];
+        pin.attribute_rect =
+            remap_rect(pin.attribute_rect, old_rect.Min, min, scale);
+        editor.pin_positions[pin_idx] = get_screen_space_pin_coordinates(
+            node_rect, pin.attribute_rect, pin.type);
+    }
+}
+
+// Draws the node as a plain rectangle with a title bar band, without the pins.
+// Nodes outside of the canvas are culled.
+void draw_zoomed_out_node(EditorContext& editor, const int node_idx)
+{
+    const ProfileZone zone("draw_zoomed_out_node");
+    const ImRect& node_rect = editor.node_rects[node_idx];
+    if (!g->canvas_rect_screen_space.Overlaps(node_rect))
+    {
+        return;
+    }
+    IMNODES_STAT(++g->stats.nodes_drawn);
+
+    const NodeData& node = editor.nodes.pool[node_idx];
+    const bool is_hovered = node_rect.Contains(ImGui::GetMousePos()) &&
+                            ImGui::IsWindowHovered() && !g->minimap_hovered;
+
+    const NodeStyle& node_style = get_node_style(node);
+    ImU32 node_background = node_style.background;
+    ImU32 titlebar_background = node_style.titlebar;
+
+    if (editor.selected_node_indices.contains(node_idx))
+    {
+        node_background = node_style.background_selected;
+        titlebar_background = node_style.titlebar_selected;
+    }
+    else if (is_hovered)
+    {
+        node_background = node_style.background_hovered;
+        titlebar_background = node_style.titlebar_hovered;
+    }
+
+    g->canvas_draw_list->AddRectFilled(
+        node_rect.Min, node_rect.Max, node_background);
+
+    if (node.title_bar_content_rect.GetHeight() > 0.f)
+    {
+        const float title_bar_max_y = ImMin(
+            node.title_bar_content_rect.Max.y + node_style.padding.y,
+            node_rect.Max.y);
+        g->canvas_draw_list->AddRectFilled(
+            node_rect.Min,
+            ImVec2(node_rect.Max.x, title_bar_max_y),
+            titlebar_background);
+    }
+
+    if (is_hovered)
+    {
+        g->hovered_node_idx = node_idx;
+        if (ImGui::IsMouseClicked(0))
+        {
+            begin_node_selection(editor, node_idx);
+        }
+    }
+}
+
+// Updates the link's hover and click state, and computes the curve or the
+// route and the color to draw the link with. Returns false if the link
+// shouldn't be drawn.
+bool update_link(
+    EditorContext& editor,
+    const int link_idx,
+    LinkDrawCommand& command)
 {
     const LinkData& link = editor.links.pool[link_idx];
-    const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
-    const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
+    const ImVec2& start_pos = editor.pin_positions[link.start_pin_idx];
+    const ImVec2& end_pos = editor.pin_positions[link.end_pin_idx];
+    const float hover_distance = g->style.link_hover_distance * editor.zoom;
+
+    bool is_hovered;
+    if (g->zoomed_out)
+    {
+        // The link is a straight line between the pins, drawn as a curve with
+        // a single segment. Links outside of the canvas are culled.
+        const ImRect bounds(
+            ImMin(start_pos, end_pos), ImMax(start_pos, end_pos));
+        if (!g->canvas_rect_screen_space.Overlaps(bounds))
+        {
+            return false;
+        }
+
+        command.link_data.bezier.p0 = start_pos;
+        command.link_data.bezier.p1 = start_pos;
+        command.link_data.bezier.p2 = end_pos;
+        command.link_data.bezier.p3 = end_pos;
+        command.link_data.num_segments = 1;
+        command.route_points = NULL;
+        command.num_route_points = 0;
 
-    const LinkBezierData link_data = get_link_renderable(
-        start_pin.pos,
-        end_pin.pos,
-        start_pin.type,
-        g.style.link_line_segments_per_length);
+        is_hovered = is_mouse_hovering_near_link(
+            command.link_data.bezier, 1, hover_distance);
+    }
+    else if (g->style.flags & StyleFlags_OrthogonalLinks)
+    {
+        const LinkRouter& router = editor.link_router;
+        const LinkRoute& route = router.routes[link_idx];
+        command.route_points = router.screen_points.Data + route.point_begin;
+        command.num_route_points = route.num_points;
+        // Used to bound the size of the tessellated route.
+        command.link_data.num_segments = route.num_points - 1;
+
+        is_hovered = is_mouse_hovering_near_route(
+            command.route_points,
+            command.num_route_points,
+            grid_space_to_screen_space(route.bounds),
+            hover_distance);
+    }
+    else
+    {
+        command.link_data = get_link_renderable(
+            start_pos,
+            end_pos,
+            editor.pins.pool[link.start_pin_idx].type,
+            g->style.link_line_segments_per_length);
+        command.route_points = NULL;
+        command.num_route_points = 0;
+
+        is_hovered = is_mouse_hovering_near_link(
+            command.link_data.bezier,
+            command.link_data.num_segments,
+            hover_distance);
+    }
 
-    const bool is_hovered =
-        is_mouse_hovering_near_link(link_data.bezier, link_data.num_segments);
+    // The minimap is drawn over the links.
+    is_hovered = is_hovered && !g->minimap_hovered;
     if (is_hovered)
     {
-        g.hovered_link_idx = link_idx;
+        g->hovered_link_idx = link_idx;
         if (ImGui::IsMouseClicked(0))
         {
             begin_link_interaction(editor, link_idx);
@@ -1398,29 +3628,223 @@ void draw_link(EditorContext& editor, const int link_idx)
     // position.
     //
     // In other words, skip rendering the link if it was deleted.
-    if (g.deleted_link_idx == link_idx)
+    if (g->deleted_link_idx == link_idx)
     {
-        return;
+        return false;
     }
 
-    ImU32 link_color = link.color_style.base;
+    const LinkStyle& link_style = get_link_style(link);
+    command.color = link_style.base;
     if (editor.selected_link_indices.contains(link_idx))
     {
-        link_color = link.color_style.selected;
+        command.color = link_style.selected;
     }
     else if (is_hovered)
     {
-        link_color = link.color_style.hovered;
+        command.color = link_style.hovered;
+    }
+
+#ifdef IMNODES_ENABLE_STATS
+    ++g->stats.links_drawn;
+    if (command.num_route_points == 0)
+    {
+        g->stats.render_bezier_segments += command.link_data.num_segments;
+    }
+#endif
+    return true;
+}
+
+void add_link_to_draw_list(
+    ImDrawList& draw_list,
+    const LinkDrawCommand& command,
+    const float thickness)
+{
+    if (command.num_route_points > 0)
+    {
+        draw_list.AddPolyline(
+            command.route_points,
+            command.num_route_points,
+            command.color,
+            false,
+            thickness);
+    }
+    else
+    {
+        draw_list.AddBezierCurve(
+            command.link_data.bezier.p0,
+            command.link_data.bezier.p1,
+            command.link_data.bezier.p2,
+            command.link_data.bezier.p3,
+            command.color,
+            thickness,
+            command.link_data.num_segments);
+    }
+}
+
+void draw_link(EditorContext& editor, const int link_idx)
+{
+    LinkDrawCommand command;
+    if (update_link(editor, link_idx, command))
+    {
+        add_link_to_draw_list(
+            *g->canvas_draw_list,
+            command,
+            g->style.link_thickness * editor.zoom);
+    }
+}
+
+void tessellate_links_job(const int job_idx, void* const job_data)
+{
+    const LinkTessellationJobs& jobs =
+        *static_cast<LinkTessellationJobs*>(job_data);
+    const LinkTessellationJobs::Range& range = jobs.ranges[job_idx];
+    ImDrawList& draw_list = *jobs.staging_draw_lists[job_idx];
+
+    for (int i = range.begin; i < range.end; ++i)
+    {
+        LinkDrawCommand& command = jobs.commands[i];
+        const int vtx_begin = draw_list.VtxBuffer.Size;
+        const int idx_begin = draw_list.IdxBuffer.Size;
+        add_link_to_draw_list(draw_list, command, jobs.thickness);
+        command.vtx_count = draw_list.VtxBuffer.Size - vtx_begin;
+        command.idx_count = draw_list.IdxBuffer.Size - idx_begin;
+    }
+}
+
+// Draws the links like draw_link() does, but the curves and routes are
+// tessellated in parallel into per-job staging draw lists. The hover and click
+// state is still updated serially, as it mutates the editor.
+//
+// The staging draw lists are fully allocated on this thread before the jobs
+// run, so the jobs don't allocate any memory. The staged vertices and indices
+// are then copied into the canvas draw list link by link, in index order, so
+// the output is identical to calling draw_link() for each link.
+void draw_links_parallel(EditorContext& editor)
+{
+    ImVector<LinkDrawCommand>& commands = g->link_draw_commands;
+    commands.resize(0);
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        if (editor.links.in_use[link_idx])
+        {
+            LinkDrawCommand command;
+            if (update_link(editor, link_idx, command))
+            {
+                commands.push_back(command);
+            }
+        }
+    }
+
+    ImDrawList& canvas = *g->canvas_draw_list;
+    const IO::ParallelFor& parallel_for = g->io.parallel_for;
+    const int links_per_job = ImMax(parallel_for.elements_per_job, 1);
+    // Keeps each staging draw list within the range of 16-bit indices, so
+    // that the staging lists never need to split their draw commands.
+    const int max_vtx_per_job = (1 << 16) - 1;
+
+    LinkTessellationJobs jobs;
+    jobs.commands = commands.Data;
+    jobs.thickness = g->style.link_thickness * editor.zoom;
+
+    ImVector<LinkTessellationJobs::Range>& ranges = g->link_tessellation_ranges;
+    ranges.resize(0);
+
+    int total_max_vtx = 0, total_max_idx = 0;
+    for (int i = 0; i < commands.size();)
+    {
+        LinkTessellationJobs::Range range;
+        range.begin = i;
+        range.max_vtx = 0;
+        range.max_idx = 0;
+        range.max_path_size = 0;
+        while (i < commands.size() && i - range.begin < links_per_job)
+        {
+            // An upper bound on what AddPolyline emits for any combination of
+            // anti-aliasing and line thickness.
+            const int num_segments = commands[i].link_data.num_segments;
+            const int vtx_count = 4 * (num_segments + 1);
+            if (i > range.begin && range.max_vtx + vtx_count > max_vtx_per_job)
+            {
+                break;
+            }
+            range.max_vtx += vtx_count;
+            range.max_idx += 18 * num_segments;
+            range.max_path_size = ImMax(range.max_path_size, num_segments + 1);
+            ++i;
+        }
+        range.end = i;
+        total_max_vtx += range.max_vtx;
+        total_max_idx += range.max_idx;
+        ranges.push_back(range);
+    }
+    jobs.ranges = ranges.Data;
+
+    ImVector<ImDrawList*>& staging_draw_lists = g->link_staging_draw_lists;
+    while (staging_draw_lists.size() < ranges.size())
+    {
+        staging_draw_lists.push_back(IM_NEW(ImDrawList)(canvas._Data));
+    }
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        ImDrawList& draw_list = *staging_draw_lists[i];
+        draw_list.Clear();
+        draw_list.Flags = canvas.Flags & ~ImDrawListFlags_AllowVtxOffset;
+        draw_list.AddDrawCmd();
+        draw_list.VtxBuffer.reserve(ranges[i].max_vtx);
+        draw_list.IdxBuffer.reserve(ranges[i].max_idx);
+        draw_list._Path.reserve(ranges[i].max_path_size);
     }
+    jobs.staging_draw_lists = staging_draw_lists.Data;
+
+    parallel_for.run(
+        tessellate_links_job, ranges.size(), &jobs, parallel_for.user_data);
+
+    // Reserve once, so that the canvas buffers aren't reallocated while
+    // splicing. Reserving may move the buffers, and the write pointers must
+    // stay valid even if none of the links emit any vertices.
+    canvas.VtxBuffer.reserve(canvas.VtxBuffer.Size + total_max_vtx);
+    canvas.IdxBuffer.reserve(canvas.IdxBuffer.Size + total_max_idx);
+    canvas._VtxWritePtr = canvas.VtxBuffer.Data + canvas.VtxBuffer.Size;
+    canvas._IdxWritePtr = canvas.IdxBuffer.Data + canvas.IdxBuffer.Size;
+
+    for (int job_idx = 0; job_idx < ranges.size(); ++job_idx)
+    {
+        const LinkTessellationJobs::Range& range = ranges[job_idx];
+        const ImDrawList& draw_list = *staging_draw_lists[job_idx];
+        const ImDrawVert* vtx_src = draw_list.VtxBuffer.Data;
+        const ImDrawIdx* idx_src = draw_list.IdxBuffer.Data;
+        unsigned int staged_vtx_idx = 0u;
+
+        for (int i = range.begin; i < range.end; ++i)
+        {
+            const LinkDrawCommand& command = commands[i];
+            if (command.vtx_count == 0)
+            {
+                continue;
+            }
+
+            // PrimReserve starts a new draw command at the same links as the
+            // serial path does, when the 16-bit index range runs out.
+            canvas.PrimReserve(command.idx_count, command.vtx_count);
+            memcpy(
+                canvas._VtxWritePtr,
+                vtx_src,
+                command.vtx_count * sizeof(ImDrawVert));
+            for (int idx = 0; idx < command.idx_count; ++idx)
+            {
+                canvas._IdxWritePtr[idx] = static_cast<ImDrawIdx>(
+                    idx_src[idx] - staged_vtx_idx + canvas._VtxCurrentIdx);
+            }
+
+            canvas._VtxWritePtr += command.vtx_count;
+            canvas._IdxWritePtr += command.idx_count;
+            canvas._VtxCurrentIdx += command.vtx_count;
 
-    g.canvas_draw_list->AddBezierCurve(
-        link_data.bezier.p0,
-        link_data.bezier.p1,
-        link_data.bezier.p2,
-        link_data.bezier.p3,
-        link_color,
-        g.style.link_thickness,
-        link_data.num_segments);
+            vtx_src += command.vtx_count;
+            idx_src += command.idx_count;
+            staged_vtx_idx += command.vtx_count;
+        }
+    }
 }
 
 void begin_attribute(
@@ -1431,65 +3855,3778 @@ void begin_attribute(
 {
     // Make sure to call BeginNode() before calling
     // BeginAttribute()
-    assert(g.current_scope == Scope_Node);
-    g.current_scope = Scope_Attribute;
+    assert(g->current_scope == Scope_Node);
+    g->current_scope = Scope_Attribute;
 
-    ImGui::BeginGroup();
+    // Zoomed out, nothing is laid out inside of the node.
+    if (!g->zoomed_out)
+    {
+        ImGui::BeginGroup();
+    }
     ImGui::PushID(id);
 
     EditorContext& editor = editor_context_get();
 
-    const int pin_idx = editor.pins.find_or_create_index_for(id);
-    g.current_pin_idx = pin_idx;
+    const int pin_idx = find_or_create_pin_index(editor, id);
+    g->current_pin_idx = pin_idx;
     PinData& pin = editor.pins.pool[pin_idx];
     pin.id = id;
     pin.parent_node_idx = node_idx;
     pin.type = type;
     pin.shape = shape;
-    pin.flags = g.current_attribute_flags;
-    pin.color_style.background = g.style.colors[ColorStyle_Pin];
-    pin.color_style.hovered = g.style.colors[ColorStyle_PinHovered];
+    pin.flags = g->current_attribute_flags;
+    PinStyle style;
+    style.background = g->style.colors[ColorStyle_Pin];
+    style.hovered = g->style.colors[ColorStyle_PinHovered];
+    pin.style_idx = g->pin_styles.intern(style);
 }
-} // namespace
 
-// [SECTION] API implementation
+// [SECTION] link routing
 
-IO::EmulateThreeButtonMouse::EmulateThreeButtonMouse()
-    : enabled(false), modifier(NULL)
+// With StyleFlags_OrthogonalLinks, the links are routed around the nodes with
+// horizontal and vertical segments. The routes are cached in grid space, and a
+// route is only recomputed when one of its pins moves, or when a node appears,
+// disappears, moves or resizes on top of the route.
+//
+// A route is found with an A* search over a sparse grid. The grid lines run
+// along the edges of the nearby nodes, expanded by the route spacing, and
+// through the ends of the route. The search keeps track of the direction of
+// travel, and each bend adds to the cost, which keeps the routes simple.
+
+// The cost of a bend, in grid space units.
+const float route_bend_cost = 40.f;
+// How far around the ends of a route the first search looks for a way around
+// the nodes. A second search looks four times as far.
+const float route_search_margin = 100.f;
+// Routes with more nodes than this in the way fall back to a plain route
+// which ignores the nodes, which bounds the cost of a search.
+const int max_route_obstacles = 128;
+// Rerouting every link is cheaper than testing each route against this many
+// changed node rects.
+const int max_dirty_rects = 64;
+
+// A binary min-heap of items ordered by their cost member, in an ImVector or
+// an EditorVector.
+template<typename Vector>
+void heap_push(Vector& heap, const typename Vector::value_type& item)
+{
+    heap.push_back(item);
+    for (int i = heap.size() - 1; i > 0;)
+    {
+        const int parent = (i - 1) / 2;
+        if (heap[parent].cost <= heap[i].cost)
+        {
+            break;
+        }
+        ImSwap(heap[parent], heap[i]);
+        i = parent;
+    }
+}
+
+template<typename Vector>
+typename Vector::value_type heap_pop(Vector& heap)
 {
+    const typename Vector::value_type top = heap[0];
+    heap[0] = heap.back();
+    heap.pop_back();
+    for (int i = 0;;)
+    {
+        const int left = 2 * i + 1, right = left + 1;
+        int smallest = i;
+        if (left < heap.size() && heap[left].cost < heap[smallest].cost)
+        {
+            smallest = left;
+        }
+        if (right < heap.size() && heap[right].cost < heap[smallest].cost)
+        {
+            smallest = right;
+        }
+        if (smallest == i)
+        {
+            break;
+        }
+        ImSwap(heap[smallest], heap[i]);
+        i = smallest;
+    }
+    return top;
 }
 
-IO::LinkDetachWithModifierClick::LinkDetachWithModifierClick() : modifier(NULL)
+inline int cell_coordinate(const float x, const float cell_size)
 {
+    return int(ImFloor(x / cell_size));
 }
 
-IO::IO() : emulate_three_button_mouse(), link_detach_with_modifier_click() {}
+inline int cell_bucket(const int x, const int y, const int num_buckets)
+{
+    const unsigned hash = unsigned(x) * 73856093u ^ unsigned(y) * 19349663u;
+    return int(hash & unsigned(num_buckets - 1));
+}
 
-Style::Style()
-    : grid_spacing(32.f), node_corner_rounding(4.f),
-      node_padding_horizontal(8.f), node_padding_vertical(8.f),
-      link_thickness(3.f), link_line_segments_per_length(0.1f),
-      link_hover_distance(10.f), pin_circle_radius(4.f),
-      pin_quad_side_length(7.f), pin_triangle_side_length(9.5),
-      pin_line_thickness(1.f), pin_hover_radius(10.f), pin_offset(0.f),
-      flags(StyleFlags(StyleFlags_NodeOutline | StyleFlags_GridLines)), colors()
+inline ImRect empty_rect()
 {
+    return ImRect(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
 }
 
-EditorContext* EditorContextCreate()
+inline bool is_empty_rect(const ImRect& rect)
 {
-    void* mem = ImGui::MemAlloc(sizeof(EditorContext));
-    new (mem) EditorContext();
-    return (EditorContext*)mem;
+    return rect.Min.x > rect.Max.x;
 }
 
-void EditorContextFree(EditorContext* ctx)
+inline bool rects_equal(const ImRect& lhs, const ImRect& rhs)
 {
-    ctx->~EditorContext();
-    ImGui::MemFree(ctx);
+    return lhs.Min.x == rhs.Min.x && lhs.Min.y == rhs.Min.y &&
+           lhs.Max.x == rhs.Max.x && lhs.Max.y == rhs.Max.y;
+}
+
+inline bool points_equal(const ImVec2& lhs, const ImVec2& rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+// The node rects and pin positions which the routes are computed for come from
+// screen space, where ImGui floors the item positions to whole pixels, so
+// panning by a fraction of a pixel moves them by less than a pixel. Only
+// changes of at least a pixel reroute the links, so the ends of a route may be
+// less than a pixel away from its pins. Returns the tolerance in grid space.
+inline float route_tolerance(const EditorContext& editor)
+{
+    return 1.f / editor.zoom;
+}
+
+inline bool points_near(
+    const ImVec2& lhs,
+    const ImVec2& rhs,
+    const float tolerance)
+{
+    return ImFabs(lhs.x - rhs.x) < tolerance &&
+           ImFabs(lhs.y - rhs.y) < tolerance;
+}
+
+inline bool rects_near(
+    const ImRect& lhs,
+    const ImRect& rhs,
+    const float tolerance)
+{
+    return points_near(lhs.Min, rhs.Min, tolerance) &&
+           points_near(lhs.Max, rhs.Max, tolerance);
+}
+
+// Like ImRect::Overlaps(), but rects which only touch also overlap.
+inline bool rects_touch(const ImRect& lhs, const ImRect& rhs)
+{
+    return lhs.Min.x <= rhs.Max.x && rhs.Min.x <= lhs.Max.x &&
+           lhs.Min.y <= rhs.Max.y && rhs.Min.y <= lhs.Max.y;
+}
+
+// Returns true if the route runs along or through any of the changed node
+// rects, expanded by the route spacing.
+bool route_touches_dirty_rects(const LinkRouter& router, const LinkRoute& route)
+{
+    for (int i = 0; i < router.dirty_rects.size(); ++i)
+    {
+        ImRect rect = router.dirty_rects[i];
+        rect.Expand(router.spacing);
+        if (!rects_touch(route.bounds, rect))
+        {
+            continue;
+        }
+
+        const ImVec2* const points = router.points.Data + route.point_begin;
+        for (int p = 1; p < route.num_points; ++p)
+        {
+            const ImRect segment(
+                ImMin(points[p - 1], points[p]),
+                ImMax(points[p - 1], points[p]));
+            if (rects_touch(segment, rect))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Records the old and new rects of the nodes whose rects changed since the
+// last update.
+void update_route_node_rects(EditorContext& editor, LinkRouter& router)
+{
+    router.dirty_rects.resize(0);
+    const float tolerance = route_tolerance(editor);
+    while (router.node_rects.size() < editor.nodes.pool.size())
+    {
+        router.node_rects.push_back(empty_rect());
+    }
+
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        ImRect rect = empty_rect();
+        if (editor.nodes.in_use[node_idx])
+        {
+            rect = screen_space_to_grid_space(editor.node_rects[node_idx]);
+        }
+
+        ImRect& last_rect = router.node_rects[node_idx];
+        if (!rects_near(rect, last_rect, tolerance))
+        {
+            if (!is_empty_rect(last_rect))
+            {
+                router.dirty_rects.push_back(last_rect);
+            }
+            if (!is_empty_rect(rect))
+            {
+                router.dirty_rects.push_back(rect);
+            }
+            last_rect = rect;
+        }
+    }
+}
+
+void build_route_spatial_hash(LinkRouter& router)
+{
+    float size_sum = 0.f;
+    int num_rects = 0;
+    for (int i = 0; i < router.node_rects.size(); ++i)
+    {
+        const ImRect& rect = router.node_rects[i];
+        if (!is_empty_rect(rect))
+        {
+            size_sum += rect.GetWidth() + rect.GetHeight();
+            ++num_rects;
+        }
+    }
+    router.cell_size =
+        num_rects > 0 ? ImMax(size_sum / num_rects, 1.f) : 1.f;
+
+    int num_buckets = 1;
+    while (num_buckets < 4 * num_rects)
+    {
+        num_buckets <<= 1;
+    }
+    router.bucket_heads.resize(num_buckets);
+    for (int i = 0; i < num_buckets; ++i)
+    {
+        router.bucket_heads[i] = -1;
+    }
+    router.entry_nodes.resize(0);
+    router.entry_next.resize(0);
+
+    for (int node_idx = 0; node_idx < router.node_rects.size(); ++node_idx)
+    {
+        const ImRect& rect = router.node_rects[node_idx];
+        if (is_empty_rect(rect))
+        {
+            continue;
+        }
+        const int x0 = cell_coordinate(rect.Min.x, router.cell_size);
+        const int x1 = cell_coordinate(rect.Max.x, router.cell_size);
+        const int y0 = cell_coordinate(rect.Min.y, router.cell_size);
+        const int y1 = cell_coordinate(rect.Max.y, router.cell_size);
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                const int bucket = cell_bucket(x, y, num_buckets);
+                router.entry_nodes.push_back(node_idx);
+                router.entry_next.push_back(router.bucket_heads[bucket]);
+                router.bucket_heads[bucket] = router.entry_nodes.size() - 1;
+            }
+        }
+    }
+
+    router.node_query_stamps.resize(router.node_rects.size());
+    for (int i = 0; i < router.node_query_stamps.size(); ++i)
+    {
+        router.node_query_stamps[i] = 0;
+    }
+    router.query_stamp = 0;
+}
+
+// Collects the expanded rects of the nodes in the region into
+// router.obstacles. Nodes which contain either end of the search are left out,
+// as the search couldn't start or finish otherwise. Returns false if there are
+// too many nodes in the region.
+bool collect_route_obstacles(
+    LinkRouter& router,
+    const ImRect& region,
+    const ImVec2& start,
+    const ImVec2& end)
+{
+    router.obstacles.resize(0);
+    ++router.query_stamp;
+
+    const int x0 = cell_coordinate(region.Min.x, router.cell_size);
+    const int x1 = cell_coordinate(region.Max.x, router.cell_size);
+    const int y0 = cell_coordinate(region.Min.y, router.cell_size);
+    const int y1 = cell_coordinate(region.Max.y, router.cell_size);
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const int bucket = cell_bucket(x, y, router.bucket_heads.size());
+            for (int entry = router.bucket_heads[bucket]; entry != -1;
+                 entry = router.entry_next[entry])
+            {
+                const int node_idx = router.entry_nodes[entry];
+                if (router.node_query_stamps[node_idx] == router.query_stamp)
+                {
+                    continue;
+                }
+                router.node_query_stamps[node_idx] = router.query_stamp;
+
+                ImRect rect = router.node_rects[node_idx];
+                rect.Expand(router.spacing);
+                if (!rect.Overlaps(region))
+                {
+                    continue;
+                }
+                // Contains() includes the edges, which the search may use.
+                if ((rect.Min.x < start.x && start.x < rect.Max.x &&
+                     rect.Min.y < start.y && start.y < rect.Max.y) ||
+                    (rect.Min.x < end.x && end.x < rect.Max.x &&
+                     rect.Min.y < end.y && end.y < rect.Max.y))
+                {
+                    continue;
+                }
+                if (router.obstacles.size() == max_route_obstacles)
+                {
+                    return false;
+                }
+                router.obstacles.push_back(rect);
+            }
+        }
+    }
+    return true;
+}
+
+int compare_floats(const void* lhs, const void* rhs)
+{
+    const float a = *static_cast<const float*>(lhs);
+    const float b = *static_cast<const float*>(rhs);
+    return int(a > b) - int(a < b);
+}
+
+void sort_unique(EditorVector<float>& values)
+{
+    ImQsort(values.Data, values.size(), sizeof(float), compare_floats);
+    int size = 0;
+    for (int i = 0; i < values.size(); ++i)
+    {
+        if (size == 0 || values[size - 1] != values[i])
+        {
+            values[size++] = values[i];
+        }
+    }
+    values.resize(size);
+}
+
+// Returns the index of the value, which must be in the sorted values.
+int find_sorted(const EditorVector<float>& values, const float value)
+{
+    int begin = 0, end = values.size();
+    while (end - begin > 1)
+    {
+        const int middle = (begin + end) / 2;
+        if (values[middle] <= value)
+        {
+            begin = middle;
+        }
+        else
+        {
+            end = middle;
+        }
+    }
+    IM_ASSERT(values[begin] == value);
+    return begin;
+}
+
+inline bool is_cell_blocked(const LinkRouter& router, const int x, const int y)
+{
+    const int num_cells_x = router.xs.size() - 1;
+    const int num_cells_y = router.ys.size() - 1;
+    return x >= 0 && x < num_cells_x && y >= 0 && y < num_cells_y &&
+           router.blocked_cells[y * num_cells_x + x];
+}
+
+// A lower bound on the cost from the state to the end, which is reached
+// horizontally: the distance, plus the bends needed to line up with the end.
+inline float route_heuristic(
+    const LinkRouter& router,
+    const int state,
+    const ImVec2& end)
+{
+    const int num_x = router.xs.size();
+    const int point = state >> 1;
+    const ImVec2 pos(router.xs[point % num_x], router.ys[point / num_x]);
+    const int num_bends = (state & 1) ? 1 : (pos.y != end.y ? 2 : 0);
+    return ImFabs(pos.x - end.x) + ImFabs(pos.y - end.y) +
+           num_bends * route_bend_cost;
+}
+
+inline void relax_route_state(
+    LinkRouter& router,
+    const int state,
+    const int parent,
+    const float cost,
+    const ImVec2& end)
+{
+    if (cost < router.costs[state])
+    {
+        router.costs[state] = cost;
+        router.parents[state] = parent;
+        // Many routes cost the same, so the ties are broken in favour of the
+        // states closer to the end, which are expanded first.
+        const float heuristic = route_heuristic(router, state, end);
+        RouteSearchItem item;
+        item.cost = cost + heuristic * (1.f + 1e-3f);
+        item.state = state;
+        heap_push(router.open_states, item);
+    }
+}
+
+// Searches for a route from start to end within the region, around the
+// obstacles. The corners of the route are stored in router.path, from end to
+// start. Returns false if there is no route.
+bool search_route(
+    LinkRouter& router,
+    const ImRect& region,
+    const ImVec2& start,
+    const ImVec2& end)
+{
+    EditorVector<float>& xs = router.xs;
+    EditorVector<float>& ys = router.ys;
+    xs.resize(0);
+    ys.resize(0);
+    xs.push_back(region.Min.x);
+    xs.push_back(region.Max.x);
+    xs.push_back(start.x);
+    xs.push_back(end.x);
+    xs.push_back(0.5f * (start.x + end.x));
+    ys.push_back(region.Min.y);
+    ys.push_back(region.Max.y);
+    ys.push_back(start.y);
+    ys.push_back(end.y);
+    ys.push_back(0.5f * (start.y + end.y));
+    for (int i = 0; i < router.obstacles.size(); ++i)
+    {
+        ImRect& obstacle = router.obstacles[i];
+        obstacle.ClipWith(region);
+        xs.push_back(obstacle.Min.x);
+        xs.push_back(obstacle.Max.x);
+        ys.push_back(obstacle.Min.y);
+        ys.push_back(obstacle.Max.y);
+    }
+    sort_unique(xs);
+    sort_unique(ys);
+
+    // A cell lies between two neighbouring grid lines on each axis, and is
+    // blocked if it lies within an obstacle. A grid edge can be followed if
+    // either of the cells on its sides is free.
+    const int num_cells_x = xs.size() - 1;
+    const int num_cells_y = ys.size() - 1;
+    router.blocked_cells.resize(num_cells_x * num_cells_y);
+    for (int i = 0; i < router.blocked_cells.size(); ++i)
+    {
+        router.blocked_cells[i] = false;
+    }
+    for (int i = 0; i < router.obstacles.size(); ++i)
+    {
+        const ImRect& obstacle = router.obstacles[i];
+        const int x0 = find_sorted(xs, obstacle.Min.x);
+        const int x1 = find_sorted(xs, obstacle.Max.x);
+        const int y0 = find_sorted(ys, obstacle.Min.y);
+        const int y1 = find_sorted(ys, obstacle.Max.y);
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int x = x0; x < x1; ++x)
+            {
+                router.blocked_cells[y * num_cells_x + x] = true;
+            }
+        }
+    }
+
+    // Each state is a grid point and an axis of travel: state = 2 * point for
+    // horizontal travel, and 2 * point + 1 for vertical travel.
+    const int num_x = xs.size();
+    const int num_states = 2 * num_x * ys.size();
+    router.costs.resize(num_states);
+    router.parents.resize(num_states);
+    for (int i = 0; i < num_states; ++i)
+    {
+        router.costs[i] = FLT_MAX;
+    }
+    router.open_states.resize(0);
+
+    const int start_point =
+        find_sorted(ys, start.y) * num_x + find_sorted(xs, start.x);
+    const int end_point =
+        find_sorted(ys, end.y) * num_x + find_sorted(xs, end.x);
+    // Both ends of the route leave their pins horizontally.
+    const int start_state = 2 * start_point, end_state = 2 * end_point;
+    relax_route_state(router, start_state, -1, 0.f, end);
+
+    while (!router.open_states.empty())
+    {
+        const RouteSearchItem item = heap_pop(router.open_states);
+        const int state = item.state;
+        const float cost = router.costs[state];
+        if (item.cost >
+            cost + route_heuristic(router, state, end) * (1.f + 1e-3f))
+        {
+            // A cheaper way to this state was found after this one.
+            continue;
+        }
+        if (state == end_state)
+        {
+            break;
+        }
+
+        const int point = state >> 1;
+        const int x = point % num_x, y = point / num_x;
+        // Turn to the other axis.
+        relax_route_state(
+            router, state ^ 1, state, cost + route_bend_cost, end);
+        if ((state & 1) == 0)
+        {
+            if (x > 0 && !(is_cell_blocked(router, x - 1, y - 1) &&
+                           is_cell_blocked(router, x - 1, y)))
+            {
+                relax_route_state(
+                    router, state - 2, state, cost + xs[x] - xs[x - 1], end);
+            }
+            if (x < num_x - 1 && !(is_cell_blocked(router, x, y - 1) &&
+                                   is_cell_blocked(router, x, y)))
+            {
+                relax_route_state(
+                    router, state + 2, state, cost + xs[x + 1] - xs[x], end);
+            }
+        }
+        else
+        {
+            if (y > 0 && !(is_cell_blocked(router, x - 1, y - 1) &&
+                           is_cell_blocked(router, x, y - 1)))
+            {
+                relax_route_state(
+                    router,
+                    state - 2 * num_x,
+                    state,
+                    cost + ys[y] - ys[y - 1],
+                    end);
+            }
+            if (y < ys.size() - 1 && !(is_cell_blocked(router, x - 1, y) &&
+                                       is_cell_blocked(router, x, y)))
+            {
+                relax_route_state(
+                    router,
+                    state + 2 * num_x,
+                    state,
+                    cost + ys[y + 1] - ys[y],
+                    end);
+            }
+        }
+    }
+
+    if (router.costs[end_state] == FLT_MAX)
+    {
+        return false;
+    }
+
+    router.path.resize(0);
+    for (int state = end_state; state != -1; state = router.parents[state])
+    {
+        const int point = state >> 1;
+        const ImVec2 pos(xs[point % num_x], ys[point / num_x]);
+        // Turns stay on the same point.
+        if (router.path.empty() || !points_equal(router.path.back(), pos))
+        {
+            router.path.push_back(pos);
+        }
+    }
+    return true;
+}
+
+// Appends the point to the route, dropping the points in between collinear
+// segments.
+void add_route_point(LinkRouter& router, const int begin, const ImVec2& point)
+{
+    EditorVector<ImVec2>& points = router.points;
+    const int size = points.size() - begin;
+    if (size > 0 && points_equal(points.back(), point))
+    {
+        return;
+    }
+    if (size > 1)
+    {
+        const ImVec2& a = points[points.size() - 2];
+        const ImVec2& b = points.back();
+        if ((a.x == b.x && b.x == point.x) || (a.y == b.y && b.y == point.y))
+        {
+            points.back() = point;
+            return;
+        }
+    }
+    points.push_back(point);
+}
+
+// Computes the route from the output pin at start to the input pin at end,
+// and appends its points to router.points.
+void route_link(
+    LinkRouter& router,
+    const ImVec2& start,
+    const ImVec2& end,
+    LinkRoute& route)
+{
+    const float stub_length = 2.f * router.spacing;
+    const ImVec2 start_stub(start.x + stub_length, start.y);
+    const ImVec2 end_stub(end.x - stub_length, end.y);
+
+    route.point_begin = router.points.size();
+    route.start = start;
+    route.end = end;
+    add_route_point(router, route.point_begin, start);
+    add_route_point(router, route.point_begin, start_stub);
+
+    bool found = false;
+    for (int attempt = 0; attempt < 2 && !found; ++attempt)
+    {
+        ImRect region(ImMin(start_stub, end_stub), ImMax(start_stub, end_stub));
+        region.Expand(route_search_margin * (attempt == 0 ? 1.f : 4.f));
+        if (!collect_route_obstacles(router, region, start_stub, end_stub))
+        {
+            break;
+        }
+        found = search_route(router, region, start_stub, end_stub);
+    }
+
+    if (found)
+    {
+        for (int i = router.path.size() - 1; i >= 0; --i)
+        {
+            add_route_point(router, route.point_begin, router.path[i]);
+        }
+    }
+    else if (start_stub.x <= end_stub.x)
+    {
+        const float middle_x = 0.5f * (start_stub.x + end_stub.x);
+        add_route_point(
+            router, route.point_begin, ImVec2(middle_x, start_stub.y));
+        add_route_point(
+            router, route.point_begin, ImVec2(middle_x, end_stub.y));
+    }
+    else
+    {
+        const float middle_y = 0.5f * (start_stub.y + end_stub.y);
+        add_route_point(
+            router, route.point_begin, ImVec2(start_stub.x, middle_y));
+        add_route_point(
+            router, route.point_begin, ImVec2(end_stub.x, middle_y));
+    }
+
+    add_route_point(router, route.point_begin, end_stub);
+    add_route_point(router, route.point_begin, end);
+
+    route.num_points = router.points.size() - route.point_begin;
+    router.num_used_points += route.num_points;
+
+    route.bounds = empty_rect();
+    for (int i = route.point_begin; i < router.points.size(); ++i)
+    {
+        route.bounds.Add(router.points[i]);
+    }
+    route.bounds.Expand(router.spacing);
+}
+
+void release_route(LinkRouter& router, LinkRoute& route)
+{
+    router.num_used_points -= route.num_points;
+    route.num_points = 0;
+}
+
+// Moves the points of the routes to the front of router.points, in link
+// order.
+void compact_route_points(LinkRouter& router)
+{
+    EditorVector<ImVec2>& compacted = router.screen_points;
+    compacted.resize(0);
+    compacted.reserve(router.num_used_points);
+    for (int link_idx = 0; link_idx < router.routes.size(); ++link_idx)
+    {
+        LinkRoute& route = router.routes[link_idx];
+        const int begin = compacted.size();
+        for (int i = 0; i < route.num_points; ++i)
+        {
+            compacted.push_back(router.points[route.point_begin + i]);
+        }
+        route.point_begin = begin;
+    }
+    router.points.swap(compacted);
+}
+
+// Reroutes the links whose routes may have changed, and updates the screen
+// space points of all routes.
+void update_link_routes(EditorContext& editor)
+{
+    LinkRouter& router = editor.link_router;
+    update_route_node_rects(editor, router);
+
+    const bool reroute_all = router.spacing != g->style.link_route_spacing ||
+                             router.dirty_rects.size() > max_dirty_rects;
+    router.spacing = g->style.link_route_spacing;
+    const float tolerance = route_tolerance(editor);
+
+    while (router.routes.size() < editor.links.pool.size())
+    {
+        router.routes.push_back(LinkRoute());
+    }
+
+    router.dirty_link_indices.resize(0);
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        LinkRoute& route = router.routes[link_idx];
+        if (!editor.links.in_use[link_idx])
+        {
+            release_route(router, route);
+            continue;
+        }
+
+        const LinkData& link = editor.links.pool[link_idx];
+        const ImVec2* const pin_positions = editor.pin_positions.Data;
+        ImVec2 start =
+            screen_space_to_grid_space(pin_positions[link.start_pin_idx]);
+        ImVec2 end =
+            screen_space_to_grid_space(pin_positions[link.end_pin_idx]);
+        if (editor.pins.pool[link.start_pin_idx].type == AttributeType_Input)
+        {
+            ImSwap(start, end);
+        }
+
+        if (reroute_all || route.num_points == 0 ||
+            !points_near(start, route.start, tolerance) ||
+            !points_near(end, route.end, tolerance) ||
+            route_touches_dirty_rects(router, route))
+        {
+            release_route(router, route);
+            route.start = start;
+            route.end = end;
+            router.dirty_link_indices.push_back(link_idx);
+        }
+    }
+
+    if (!router.dirty_link_indices.empty())
+    {
+        build_route_spatial_hash(router);
+        for (int i = 0; i < router.dirty_link_indices.size(); ++i)
+        {
+            LinkRoute& route = router.routes[router.dirty_link_indices[i]];
+            route_link(router, route.start, route.end, route);
+        }
+    }
+
+    if (router.points.size() > 2 * router.num_used_points + 1024)
+    {
+        compact_route_points(router);
+    }
+
+    router.screen_points.resize(router.points.size());
+    for (int i = 0; i < router.points.size(); ++i)
+    {
+        router.screen_points[i] = grid_space_to_screen_space(router.points[i]);
+    }
+}
+
+// [SECTION] minimap
+
+// The minimap is drawn from MiniMapSummary, so that the cost of drawing it
+// doesn't depend on the size of the graph. Each node and link remembers what it
+// added to the bins, and is only binned again when it moves, resizes, or goes
+// away. The bins are rebuilt from scratch when a node leaves their bounds, or
+// when the nodes only cover a small part of the bounds.
+
+// The number of bins along the longer side of the bounds.
+const int minimap_bins = 32;
+// The node coverage of a fully covered bin.
+const int minimap_full_coverage = 256;
+// The number of links passing through a bin which draws it fully opaque.
+const int minimap_full_link_count = 8;
+
+inline int minimap_column(const MiniMapSummary& minimap, const float x)
+{
+    return ImClamp(
+        int((x - minimap.bounds.Min.x) / minimap.bin_size.x),
+        0,
+        minimap.columns - 1);
+}
+
+inline int minimap_row(const MiniMapSummary& minimap, const float y)
+{
+    return ImClamp(
+        int((y - minimap.bounds.Min.y) / minimap.bin_size.y),
+        0,
+        minimap.rows - 1);
+}
+
+// Adds the rect's coverage of each bin, or removes it if sign is -1. The
+// coverage is rounded the same way each time, so removing it is exact.
+void add_minimap_node_coverage(
+    MiniMapSummary& minimap,
+    const ImRect& rect,
+    const int sign)
+{
+    const float bin_area = minimap.bin_size.x * minimap.bin_size.y;
+    const int min_column = minimap_column(minimap, rect.Min.x);
+    const int max_column = minimap_column(minimap, rect.Max.x);
+    const int min_row = minimap_row(minimap, rect.Min.y);
+    const int max_row = minimap_row(minimap, rect.Max.y);
+
+    for (int row = min_row; row <= max_row; ++row)
+    {
+        const float bin_min_y = minimap.bounds.Min.y + row * minimap.bin_size.y;
+        const float height =
+            ImMin(rect.Max.y, bin_min_y + minimap.bin_size.y) -
+            ImMax(rect.Min.y, bin_min_y);
+        for (int column = min_column; column <= max_column; ++column)
+        {
+            const float bin_min_x =
+                minimap.bounds.Min.x + column * minimap.bin_size.x;
+            const float width =
+                ImMin(rect.Max.x, bin_min_x + minimap.bin_size.x) -
+                ImMax(rect.Min.x, bin_min_x);
+            if (width > 0.f && height > 0.f)
+            {
+                const int coverage = int(
+                    width * height / bin_area * minimap_full_coverage + 0.5f);
+                minimap.node_coverage[row * minimap.columns + column] +=
+                    sign * coverage;
+            }
+        }
+    }
+}
+
+// Counts the link in each bin along the line between its end bins, or removes
+// it if sign is -1.
+void add_minimap_link_counts(
+    MiniMapSummary& minimap,
+    const MiniMapLink& link,
+    const int sign)
+{
+    if (link.start_bin == -1)
+    {
+        return;
+    }
+
+    const int start_column = link.start_bin % minimap.columns;
+    const int start_row = link.start_bin / minimap.columns;
+    const int columns = link.end_bin % minimap.columns - start_column;
+    const int rows = link.end_bin / minimap.columns - start_row;
+    const int steps =
+        ImMax(columns < 0 ? -columns : columns, rows < 0 ? -rows : rows);
+
+    for (int i = 0; i <= steps; ++i)
+    {
+        const float t = steps > 0 ? float(i) / float(steps) : 0.f;
+        const int column = start_column + int(ImFloor(columns * t + 0.5f));
+        const int row = start_row + int(ImFloor(rows * t + 0.5f));
+        minimap.link_counts[row * minimap.columns + column] += sign;
+    }
+}
+
+// Bins the node again if its rect changed since it was last binned. Pass an
+// empty rect to remove the node.
+void update_minimap_node(
+    MiniMapSummary& minimap,
+    const int node_idx,
+    const ImRect& rect)
+{
+    while (minimap.node_rects.size() <= node_idx)
+    {
+        minimap.node_rects.push_back(empty_rect());
+    }
+
+    ImRect& binned_rect = minimap.node_rects[node_idx];
+    if (rects_equal(rect, binned_rect))
+    {
+        return;
+    }
+
+    if (!is_empty_rect(rect) && !minimap.bounds.Contains(rect))
+    {
+        minimap.dirty = true;
+        return;
+    }
+
+    if (!is_empty_rect(binned_rect))
+    {
+        add_minimap_node_coverage(minimap, binned_rect, -1);
+    }
+    if (!is_empty_rect(rect))
+    {
+        add_minimap_node_coverage(minimap, rect, 1);
+    }
+    binned_rect = rect;
+}
+
+inline int get_minimap_node_bin(
+    const MiniMapSummary& minimap,
+    const int node_idx)
+{
+    if (node_idx >= minimap.node_rects.size() ||
+        is_empty_rect(minimap.node_rects[node_idx]))
+    {
+        return -1;
+    }
+
+    const ImVec2 center = minimap.node_rects[node_idx].GetCenter();
+    return minimap_row(minimap, center.y) * minimap.columns +
+           minimap_column(minimap, center.x);
+}
+
+// Bins the link again if either of its nodes moved to another bin. Links
+// whose nodes aren't binned are removed.
+void update_minimap_link(EditorContext& editor, const int link_idx)
+{
+    MiniMapSummary& minimap = editor.minimap;
+    while (minimap.links.size() <= link_idx)
+    {
+        minimap.links.push_back(MiniMapLink());
+    }
+
+    MiniMapLink new_link;
+    if (editor.links.in_use[link_idx])
+    {
+        const LinkData& link = editor.links.pool[link_idx];
+        new_link.start_bin = get_minimap_node_bin(
+            minimap, editor.pins.pool[link.start_pin_idx].parent_node_idx);
+        new_link.end_bin = get_minimap_node_bin(
+            minimap, editor.pins.pool[link.end_pin_idx].parent_node_idx);
+        if (new_link.start_bin == -1 || new_link.end_bin == -1)
+        {
+            new_link = MiniMapLink();
+        }
+    }
+
+    MiniMapLink& binned_link = minimap.links[link_idx];
+    if (new_link.start_bin != binned_link.start_bin ||
+        new_link.end_bin != binned_link.end_bin)
+    {
+        add_minimap_link_counts(minimap, binned_link, -1);
+        add_minimap_link_counts(minimap, new_link, 1);
+        binned_link = new_link;
+    }
+}
+
+inline void update_current_minimap_node(
+    EditorContext& editor,
+    const ImRect& grid_space_rect)
+{
+    if (!editor.minimap.dirty)
+    {
+        update_minimap_node(
+            editor.minimap, g->current_node_idx, grid_space_rect);
+    }
+}
+
+// Adds the node which was just submitted to the content bounds and the minimap.
+void end_node_bounds(EditorContext& editor)
+{
+    const ImRect rect =
+        get_node_grid_space_rect(editor.nodes.pool[g->current_node_idx]);
+    g->content_bounds.Add(rect);
+    update_current_minimap_node(editor, rect);
+}
+
+// Removes the nodes and links which were freed at the start of the frame.
+void remove_freed_minimap_elements(EditorContext& editor)
+{
+    MiniMapSummary& minimap = editor.minimap;
+    for (int i = 0; i < editor.nodes.free_list.size(); ++i)
+    {
+        const int node_idx = editor.nodes.free_list[i];
+        if (node_idx < minimap.node_rects.size())
+        {
+            update_minimap_node(minimap, node_idx, empty_rect());
+        }
+    }
+
+    for (int i = 0; i < editor.links.free_list.size(); ++i)
+    {
+        const int link_idx = editor.links.free_list[i];
+        if (link_idx < minimap.links.size())
+        {
+            update_minimap_link(editor, link_idx);
+        }
+    }
+}
+
+// Drops the bins while the minimap isn't shown. They are rebuilt when it's
+// shown again.
+void reset_minimap(MiniMapSummary& minimap)
+{
+    minimap.dirty = true;
+    minimap.node_coverage.clear();
+    minimap.link_counts.clear();
+    minimap.node_rects.clear();
+    minimap.links.clear();
+    minimap.screen_rect = empty_rect();
+}
+
+// Fits the bins to the nodes in use, with some room for them to move, and bins
+// every node and link.
+void rebuild_minimap(EditorContext& editor)
+{
+    MiniMapSummary& minimap = editor.minimap;
+    minimap.dirty = false;
+
+    ImRect bounds = empty_rect();
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        if (editor.nodes.in_use[node_idx])
+        {
+            bounds.Add(get_node_grid_space_rect(editor.nodes.pool[node_idx]));
+        }
+    }
+
+    minimap.node_rects.resize(0);
+    minimap.links.resize(0);
+    if (is_empty_rect(bounds))
+    {
+        minimap.bounds = bounds;
+        minimap.columns = 0;
+        minimap.rows = 0;
+        return;
+    }
+
+    const ImVec2 size = bounds.GetSize();
+    bounds.Expand(0.1f * ImMax(size.x, size.y));
+    minimap.bounds = bounds;
+
+    const float aspect_ratio = bounds.GetWidth() / bounds.GetHeight();
+    minimap.columns = aspect_ratio >= 1.f
+                          ? minimap_bins
+                          : ImMax(int(minimap_bins * aspect_ratio + 0.5f), 1);
+    minimap.rows = aspect_ratio >= 1.f
+                       ? ImMax(int(minimap_bins / aspect_ratio + 0.5f), 1)
+                       : minimap_bins;
+    minimap.bin_size = ImVec2(
+        bounds.GetWidth() / minimap.columns,
+        bounds.GetHeight() / minimap.rows);
+
+    const int num_bins = minimap.columns * minimap.rows;
+    minimap.node_coverage.resize(num_bins);
+    minimap.link_counts.resize(num_bins);
+    memset(minimap.node_coverage.Data, 0, sizeof(int) * num_bins);
+    memset(minimap.link_counts.Data, 0, sizeof(int) * num_bins);
+
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        if (editor.nodes.in_use[node_idx])
+        {
+            update_minimap_node(
+                minimap,
+                node_idx,
+                get_node_grid_space_rect(editor.nodes.pool[node_idx]));
+        }
+    }
+
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        update_minimap_link(editor, link_idx);
+    }
+}
+
+// Returns true if the nodes cover less than half of the bins along both axes.
+bool minimap_needs_shrinking(const MiniMapSummary& minimap)
+{
+    int min_column = minimap.columns, max_column = -1;
+    int min_row = minimap.rows, max_row = -1;
+    for (int row = 0; row < minimap.rows; ++row)
+    {
+        for (int column = 0; column < minimap.columns; ++column)
+        {
+            if (minimap.node_coverage[row * minimap.columns + column] > 0)
+            {
+                min_column = ImMin(min_column, column);
+                max_column = ImMax(max_column, column);
+                min_row = ImMin(min_row, row);
+                max_row = ImMax(max_row, row);
+            }
+        }
+    }
+
+    return 2 * (max_column - min_column + 1) < minimap.columns &&
+           2 * (max_row - min_row + 1) < minimap.rows;
+}
+
+inline ImU32 scale_alpha(const ImU32 color, const float factor)
+{
+    const ImU32 alpha = (color >> IM_COL32_A_SHIFT) & 0xFF;
+    return (color & ~IM_COL32_A_MASK) |
+           (ImU32(float(alpha) * factor + 0.5f) << IM_COL32_A_SHIFT);
+}
+
+// The density of a bin is shown with its opacity. Bins with anything in them
+// are always visible.
+inline float get_minimap_bin_opacity(const int count, const int full_count)
+{
+    return 0.25f + 0.75f * ImMin(float(count) / float(full_count), 1.f);
+}
+
+void draw_minimap(EditorContext& editor)
+{
+    MiniMapSummary& minimap = editor.minimap;
+    if (minimap.dirty || minimap_needs_shrinking(minimap))
+    {
+        rebuild_minimap(editor);
+    }
+
+    const ImRect& canvas_rect = g->canvas_rect_screen_space;
+    const ImVec2 size = canvas_rect.GetSize() * minimap.size_fraction;
+    const bool left = minimap.location == MiniMapLocation_TopLeft ||
+                      minimap.location == MiniMapLocation_BottomLeft;
+    const bool top = minimap.location == MiniMapLocation_TopLeft ||
+                     minimap.location == MiniMapLocation_TopRight;
+    const ImVec2 min(
+        left ? canvas_rect.Min.x : canvas_rect.Max.x - size.x,
+        top ? canvas_rect.Min.y : canvas_rect.Max.y - size.y);
+    minimap.screen_rect = ImRect(min, min + size);
+
+    ImDrawList* const draw_list = g->canvas_draw_list;
+    draw_list->AddRectFilled(
+        minimap.screen_rect.Min,
+        minimap.screen_rect.Max,
+        g->style.colors[ColorStyle_MiniMapBackground]);
+
+    // Without any nodes, there is nothing to show.
+    if (minimap.columns == 0)
+    {
+        draw_list->AddRect(
+            minimap.screen_rect.Min,
+            minimap.screen_rect.Max,
+            g->style.colors[ColorStyle_MiniMapOutline]);
+        return;
+    }
+
+    // Fit the bounds to the minimap, and center them.
+    const ImVec2 bounds_size = minimap.bounds.GetSize();
+    minimap.scale = ImMin(size.x / bounds_size.x, size.y / bounds_size.y);
+    minimap.screen_origin =
+        min + (size - bounds_size * minimap.scale) * 0.5f -
+        minimap.bounds.Min * minimap.scale;
+
+    draw_list->PushClipRect(
+        minimap.screen_rect.Min, minimap.screen_rect.Max, true);
+
+    const ImVec2 bin_size = minimap.bin_size * minimap.scale;
+    for (int row = 0; row < minimap.rows; ++row)
+    {
+        for (int column = 0; column < minimap.columns; ++column)
+        {
+            const int bin = row * minimap.columns + column;
+            const ImVec2 bin_min =
+                minimap.screen_origin +
+                (minimap.bounds.Min + ImVec2(column, row) * minimap.bin_size) *
+                    minimap.scale;
+
+            if (minimap.node_coverage[bin] > 0)
+            {
+                draw_list->AddRectFilled(
+                    bin_min,
+                    bin_min + bin_size,
+                    scale_alpha(
+                        g->style.colors[ColorStyle_MiniMapNode],
+                        get_minimap_bin_opacity(
+                            minimap.node_coverage[bin],
+                            minimap_full_coverage)));
+            }
+
+            if (minimap.link_counts[bin] > 0)
+            {
+                draw_list->AddRectFilled(
+                    bin_min,
+                    bin_min + bin_size,
+                    scale_alpha(
+                        g->style.colors[ColorStyle_MiniMapLink],
+                        get_minimap_bin_opacity(
+                            minimap.link_counts[bin],
+                            minimap_full_link_count)));
+            }
+        }
+    }
+
+    // The visible part of the editor.
+    const ImRect viewport = screen_space_to_grid_space(canvas_rect);
+    const ImVec2 viewport_min =
+        minimap.screen_origin + viewport.Min * minimap.scale;
+    const ImVec2 viewport_max =
+        minimap.screen_origin + viewport.Max * minimap.scale;
+    draw_list->AddRectFilled(
+        viewport_min,
+        viewport_max,
+        g->style.colors[ColorStyle_MiniMapViewport]);
+    draw_list->AddRect(
+        viewport_min, viewport_max, g->style.colors[ColorStyle_MiniMapOutline]);
+
+    draw_list->PopClipRect();
+    draw_list->AddRect(
+        minimap.screen_rect.Min,
+        minimap.screen_rect.Max,
+        g->style.colors[ColorStyle_MiniMapOutline]);
+}
+
+// [SECTION] layered layout
+
+// The layered layout follows the Sugiyama framework:
+//
+// 1. Cycles are broken by reversing the back edges found by a depth-first
+//    search.
+// 2. Each node is assigned to a layer, so that every link points from a lower
+//    layer to a higher layer. Links which span several layers are split by
+//    dummy vertices, one per layer crossed.
+// 3. Link crossings are reduced by sorting the vertices of each layer by the
+//    barycenter of their neighbours' positions, sweeping down and up the
+//    layers.
+// 4. The layers are placed from left to right. Within each layer, the vertices
+//    are placed as close to the pins they are linked to as they can be without
+//    overlapping.
+//
+// Each step is linear in the number of vertices and edges, except for the
+// sorting in step 3.
+
+struct LayoutEdge
+{
+    int source, target;
+    // The y offsets of the source and target pins from the top of their nodes.
+    float source_offset, target_offset;
+};
+
+struct LayoutSortItem
+{
+    float key;
+    int tiebreak;
+    int vertex;
+};
+
+struct LayoutGraph
+{
+    // Vertices [0, num_nodes) are the editor's nodes, the rest are dummy
+    // vertices.
+    int num_nodes;
+    ImVector<int> node_indices;
+    ImVector<int> layers;
+    ImVector<ImVec2> sizes;
+    ImVector<float> ys;
+
+    ImVector<LayoutEdge> edges;
+    // The incoming and outgoing edges of vertex v are
+    // in_edges[in_begin[v]..in_begin[v + 1]) and
+    // out_edges[out_begin[v]..out_begin[v + 1]).
+    ImVector<int> in_begin, in_edges;
+    ImVector<int> out_begin, out_edges;
+
+    // The vertices of layer l in order are
+    // layer_vertices[layer_begin[l]..layer_begin[l + 1]), and positions[v] is
+    // the index of vertex v within its layer.
+    int num_layers;
+    ImVector<int> layer_begin, layer_vertices;
+    ImVector<int> positions;
+    ImVector<bool> affected_layers;
+
+    // Scratch buffers.
+    ImVector<int> keys;
+    ImVector<LayoutSortItem> sort_items;
+    ImVector<float> desired_ys, offsets;
+    ImVector<ImVec2> blocks;
+
+    LayoutGraph()
+        : num_nodes(0), node_indices(), layers(), sizes(), ys(), edges(),
+          in_begin(), in_edges(), out_begin(), out_edges(), num_layers(0),
+          layer_begin(), layer_vertices(), positions(), affected_layers(),
+          keys(), sort_items(), desired_ys(), offsets(), blocks()
+    {
+    }
+
+    inline int num_vertices() const { return layers.size(); }
+};
+
+// Groups the items [0, keys.size()) by key with a stable counting sort. The
+// items with key k end up in sorted[begin[k]..begin[k + 1]).
+void counting_sort(
+    const ImVector<int>& keys,
+    const int num_keys,
+    ImVector<int>& begin,
+    ImVector<int>& sorted)
+{
+    begin.resize(num_keys + 1);
+    memset(begin.Data, 0, sizeof(int) * begin.size());
+    for (int i = 0; i < keys.size(); ++i)
+    {
+        ++begin[keys[i] + 1];
+    }
+    for (int k = 0; k < num_keys; ++k)
+    {
+        begin[k + 1] += begin[k];
+    }
+
+    sorted.resize(keys.size());
+    for (int i = 0; i < keys.size(); ++i)
+    {
+        sorted[begin[keys[i]]++] = i;
+    }
+    // Each begin[k] now points to the end of bucket k, shift them back.
+    for (int k = num_keys; k > 0; --k)
+    {
+        begin[k] = begin[k - 1];
+    }
+    begin[0] = 0;
+}
+
+void build_adjacency(LayoutGraph& graph)
+{
+    const int num_vertices = graph.num_vertices();
+    graph.keys.resize(graph.edges.size());
+    for (int i = 0; i < graph.edges.size(); ++i)
+    {
+        graph.keys[i] = graph.edges[i].target;
+    }
+    counting_sort(graph.keys, num_vertices, graph.in_begin, graph.in_edges);
+    for (int i = 0; i < graph.edges.size(); ++i)
+    {
+        graph.keys[i] = graph.edges[i].source;
+    }
+    counting_sort(graph.keys, num_vertices, graph.out_begin, graph.out_edges);
+}
+
+inline void reverse_edge(LayoutEdge& edge)
+{
+    ImSwap(edge.source, edge.target);
+    ImSwap(edge.source_offset, edge.target_offset);
+}
+
+// Adds a vertex for each node in use, and an edge for each link between two
+// different nodes. The edges point from the output pin to the input pin.
+void layout_collect_graph(const EditorContext& editor, LayoutGraph& graph)
+{
+    ImVector<int>& vertex_of_node = graph.keys;
+    vertex_of_node.resize(editor.nodes.pool.size());
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        vertex_of_node[node_idx] = -1;
+        if (editor.nodes.in_use[node_idx])
+        {
+            const NodeData& node = editor.nodes.pool[node_idx];
+            vertex_of_node[node_idx] = graph.node_indices.size();
+            graph.node_indices.push_back(node_idx);
+            graph.layers.push_back(0);
+            graph.sizes.push_back(node.grid_space_size);
+            graph.ys.push_back(node.origin.y);
+        }
+    }
+    graph.num_nodes = graph.node_indices.size();
+
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        if (!editor.links.in_use[link_idx])
+        {
+            continue;
+        }
+
+        const LinkData& link = editor.links.pool[link_idx];
+        const PinData& start_pin = editor.pins.pool[link.start_pin_idx];
+        const PinData& end_pin = editor.pins.pool[link.end_pin_idx];
+        const ImRect& start_node_rect =
+            editor.node_rects[start_pin.parent_node_idx];
+        const ImRect& end_node_rect =
+            editor.node_rects[end_pin.parent_node_idx];
+
+        LayoutEdge edge;
+        edge.source = vertex_of_node[start_pin.parent_node_idx];
+        edge.target = vertex_of_node[end_pin.parent_node_idx];
+        if (edge.source == -1 || edge.target == -1 ||
+            edge.source == edge.target)
+        {
+            continue;
+        }
+        edge.source_offset =
+            (start_pin.attribute_rect.GetCenter().y - start_node_rect.Min.y) /
+            editor.zoom;
+        edge.target_offset =
+            (end_pin.attribute_rect.GetCenter().y - end_node_rect.Min.y) /
+            editor.zoom;
+
+        if (start_pin.type == AttributeType_Input &&
+            end_pin.type == AttributeType_Output)
+        {
+            reverse_edge(edge);
+        }
+        graph.edges.push_back(edge);
+    }
+}
+
+// Reverses the back edges found by an iterative depth-first search, which
+// makes the graph acyclic. The search starts from the source vertices, so
+// that the links of an acyclic graph are never reversed.
+void layout_break_cycles(LayoutGraph& graph)
+{
+    enum
+    {
+        Unvisited = 0,
+        OnStack,
+        Done
+    };
+
+    const int num_vertices = graph.num_vertices();
+    build_adjacency(graph);
+
+    ImVector<int> state, stack, cursors;
+    state.resize(num_vertices);
+    memset(state.Data, 0, sizeof(int) * num_vertices);
+    cursors.resize(num_vertices);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int root = 0; root < num_vertices; ++root)
+        {
+            const bool is_source =
+                graph.in_begin[root] == graph.in_begin[root + 1];
+            if (state[root] != Unvisited || (pass == 0 && !is_source))
+            {
+                continue;
+            }
+
+            state[root] = OnStack;
+            cursors[root] = graph.out_begin[root];
+            stack.push_back(root);
+            while (!stack.empty())
+            {
+                const int v = stack.back();
+                if (cursors[v] == graph.out_begin[v + 1])
+                {
+                    state[v] = Done;
+                    stack.pop_back();
+                    continue;
+                }
+
+                const int edge_idx = graph.out_edges[cursors[v]++];
+                LayoutEdge& edge = graph.edges[edge_idx];
+                if (state[edge.target] == Unvisited)
+                {
+                    state[edge.target] = OnStack;
+                    cursors[edge.target] = graph.out_begin[edge.target];
+                    stack.push_back(edge.target);
+                }
+                else if (state[edge.target] == OnStack)
+                {
+                    // The adjacency lists are stale after this, but the edge
+                    // has already been visited.
+                    reverse_edge(edge);
+                }
+            }
+        }
+    }
+}
+
+// Assigns the longest path layering to the vertices whose layer isn't fixed.
+// Vertices without incoming edges are then moved as close to their
+// successors as possible, which keeps the links short.
+void layout_assign_layers(LayoutGraph& graph, const ImVector<bool>& fixed)
+{
+    const int num_vertices = graph.num_vertices();
+    build_adjacency(graph);
+
+    // Kahn's algorithm.
+    ImVector<int> in_degrees, order;
+    in_degrees.resize(num_vertices);
+    order.reserve(num_vertices);
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        in_degrees[v] = graph.in_begin[v + 1] - graph.in_begin[v];
+        if (in_degrees[v] == 0)
+        {
+            order.push_back(v);
+        }
+    }
+
+    for (int i = 0; i < order.size(); ++i)
+    {
+        const int v = order[i];
+        for (int j = graph.out_begin[v]; j < graph.out_begin[v + 1]; ++j)
+        {
+            const int target = graph.edges[graph.out_edges[j]].target;
+            if (!fixed[target])
+            {
+                graph.layers[target] =
+                    ImMax(graph.layers[target], graph.layers[v] + 1);
+            }
+            if (--in_degrees[target] == 0)
+            {
+                order.push_back(target);
+            }
+        }
+    }
+    assert(order.size() == num_vertices);
+
+    for (int i = order.size() - 1; i >= 0; --i)
+    {
+        const int v = order[i];
+        if (fixed[v] || graph.in_begin[v] != graph.in_begin[v + 1] ||
+            graph.out_begin[v] == graph.out_begin[v + 1])
+        {
+            continue;
+        }
+
+        int layer = INT_MAX;
+        for (int j = graph.out_begin[v]; j < graph.out_begin[v + 1]; ++j)
+        {
+            const int target = graph.edges[graph.out_edges[j]].target;
+            layer = ImMin(layer, graph.layers[target] - 1);
+        }
+        graph.layers[v] = ImMax(graph.layers[v], layer);
+    }
+
+    graph.num_layers = 0;
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        graph.num_layers = ImMax(graph.num_layers, graph.layers[v] + 1);
+    }
+}
+
+// Makes every edge span exactly one layer. Edges within a layer are dropped,
+// edges pointing to a lower layer are reversed, and longer edges are split by
+// dummy vertices. The dummy vertices start out on the straight line between
+// the pins of the edge, and are fixed if both ends of the edge are.
+void layout_insert_dummy_vertices(LayoutGraph& graph, ImVector<bool>& fixed)
+{
+    const int num_edges = graph.edges.size();
+    int num_kept = 0;
+    for (int i = 0; i < num_edges; ++i)
+    {
+        LayoutEdge edge = graph.edges[i];
+        if (graph.layers[edge.source] == graph.layers[edge.target])
+        {
+            continue;
+        }
+        if (graph.layers[edge.source] > graph.layers[edge.target])
+        {
+            reverse_edge(edge);
+        }
+
+        const int source_layer = graph.layers[edge.source];
+        const int span = graph.layers[edge.target] - source_layer;
+        const float source_y = graph.ys[edge.source] + edge.source_offset;
+        const float target_y = graph.ys[edge.target] + edge.target_offset;
+
+        LayoutEdge segment = edge;
+        for (int k = 1; k < span; ++k)
+        {
+            const int dummy = graph.num_vertices();
+            graph.layers.push_back(source_layer + k);
+            graph.sizes.push_back(ImVec2(0.f, 0.f));
+            graph.ys.push_back(ImLerp(source_y, target_y, float(k) / span));
+            fixed.push_back(fixed[edge.source] && fixed[edge.target]);
+
+            segment.target = dummy;
+            segment.target_offset = 0.f;
+            graph.edges.push_back(segment);
+
+            segment.source = dummy;
+            segment.source_offset = 0.f;
+        }
+        segment.target = edge.target;
+        segment.target_offset = edge.target_offset;
+        graph.edges[num_kept++] = segment;
+    }
+
+    // Move the dummy edges down to fill the gap left by the dropped edges.
+    const int num_dropped = num_edges - num_kept;
+    for (int i = num_edges; i < graph.edges.size(); ++i)
+    {
+        graph.edges[i - num_dropped] = graph.edges[i];
+    }
+    graph.edges.resize(graph.edges.size() - num_dropped);
+
+    build_adjacency(graph);
+}
+
+int compare_layout_sort_items(const void* lhs, const void* rhs)
+{
+    const LayoutSortItem& a = *static_cast<const LayoutSortItem*>(lhs);
+    const LayoutSortItem& b = *static_cast<const LayoutSortItem*>(rhs);
+    if (a.key != b.key)
+    {
+        return a.key < b.key ? -1 : 1;
+    }
+    return a.tiebreak - b.tiebreak;
+}
+
+// Sorts the vertices of the layer by graph.sort_items, which holds one item
+// per vertex of the layer.
+void sort_layer(LayoutGraph& graph, const int layer)
+{
+    ImVector<LayoutSortItem>& items = graph.sort_items;
+    ImQsort(
+        items.Data,
+        items.size(),
+        sizeof(LayoutSortItem),
+        compare_layout_sort_items);
+
+    const int begin = graph.layer_begin[layer];
+    for (int i = 0; i < items.size(); ++i)
+    {
+        graph.layer_vertices[begin + i] = items[i].vertex;
+        graph.positions[items[i].vertex] = i;
+    }
+}
+
+// Groups the vertices by layer, ordered by their current y coordinate.
+void layout_init_order(LayoutGraph& graph)
+{
+    counting_sort(
+        graph.layers,
+        graph.num_layers,
+        graph.layer_begin,
+        graph.layer_vertices);
+    graph.positions.resize(graph.num_vertices());
+
+    for (int layer = 0; layer < graph.num_layers; ++layer)
+    {
+        graph.sort_items.resize(0);
+        for (int i = graph.layer_begin[layer]; i < graph.layer_begin[layer + 1];
+             ++i)
+        {
+            const int v = graph.layer_vertices[i];
+            LayoutSortItem item;
+            item.key = graph.ys[v];
+            item.tiebreak = v;
+            item.vertex = v;
+            graph.sort_items.push_back(item);
+        }
+        sort_layer(graph, layer);
+    }
+}
+
+// Sorts the vertices of the layer by the barycenter of their neighbours in
+// the previous layer (or the next layer, if use_in_edges is false). Vertices
+// without such neighbours keep their position.
+void order_layer_by_barycenter(
+    LayoutGraph& graph,
+    const int layer,
+    const bool use_in_edges)
+{
+    const ImVector<int>& begin =
+        use_in_edges ? graph.in_begin : graph.out_begin;
+    const ImVector<int>& adjacency =
+        use_in_edges ? graph.in_edges : graph.out_edges;
+
+    graph.sort_items.resize(0);
+    for (int i = graph.layer_begin[layer]; i < graph.layer_begin[layer + 1];
+         ++i)
+    {
+        const int v = graph.layer_vertices[i];
+        LayoutSortItem item;
+        item.key = float(graph.positions[v]);
+        item.tiebreak = graph.positions[v];
+        item.vertex = v;
+
+        if (begin[v] != begin[v + 1])
+        {
+            float sum = 0.f;
+            for (int j = begin[v]; j < begin[v + 1]; ++j)
+            {
+                const LayoutEdge& edge = graph.edges[adjacency[j]];
+                sum += graph.positions[use_in_edges ? edge.source
+                                                    : edge.target];
+            }
+            item.key = sum / (begin[v + 1] - begin[v]);
+        }
+        graph.sort_items.push_back(item);
+    }
+    sort_layer(graph, layer);
+}
+
+void layout_minimize_crossings(LayoutGraph& graph, const int iterations)
+{
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (int layer = 1; layer < graph.num_layers; ++layer)
+        {
+            if (graph.affected_layers[layer])
+            {
+                order_layer_by_barycenter(graph, layer, true);
+            }
+        }
+        for (int layer = graph.num_layers - 2; layer >= 0; --layer)
+        {
+            if (graph.affected_layers[layer])
+            {
+                order_layer_by_barycenter(graph, layer, false);
+            }
+        }
+    }
+}
+
+// Places the vertices of the layer in order, as close to graph.desired_ys as
+// possible in the least squares sense, while keeping them spaced apart. This
+// is an isotonic regression, which the pool adjacent violators algorithm
+// solves in linear time.
+void place_layer(
+    LayoutGraph& graph,
+    const int layer,
+    const float node_spacing)
+{
+    const int begin = graph.layer_begin[layer];
+    const int count = graph.layer_begin[layer + 1] - begin;
+
+    // Each block holds the sum of its targets in x, and its size in y.
+    ImVector<ImVec2>& blocks = graph.blocks;
+    ImVector<float>& offsets = graph.offsets;
+    blocks.resize(0);
+    offsets.resize(count);
+
+    float offset = 0.f;
+    for (int i = 0; i < count; ++i)
+    {
+        const int v = graph.layer_vertices[begin + i];
+        if (i > 0)
+        {
+            const int prev = graph.layer_vertices[begin + i - 1];
+            // The links passing through a layer get half the space of a node.
+            const bool both_nodes =
+                v < graph.num_nodes && prev < graph.num_nodes;
+            offset += graph.sizes[prev].y +
+                      (both_nodes ? node_spacing : 0.5f * node_spacing);
+        }
+        offsets[i] = offset;
+
+        blocks.push_back(ImVec2(graph.desired_ys[i] - offset, 1.f));
+        while (blocks.size() >= 2)
+        {
+            const ImVec2& last = blocks[blocks.size() - 1];
+            ImVec2& prev = blocks[blocks.size() - 2];
+            if (prev.x * last.y <= last.x * prev.y)
+            {
+                break;
+            }
+            prev += last;
+            blocks.pop_back();
+        }
+    }
+
+    int i = 0;
+    for (int b = 0; b < blocks.size(); ++b)
+    {
+        const float mean = blocks[b].x / blocks[b].y;
+        for (int j = 0; j < int(blocks[b].y); ++j, ++i)
+        {
+            graph.ys[graph.layer_vertices[begin + i]] = mean + offsets[i];
+        }
+    }
+}
+
+// The desired y coordinate of a vertex lines up its pins with the pins of
+// its neighbours, on average.
+float desired_y(const LayoutGraph& graph, const int v)
+{
+    float sum = 0.f;
+    int count = 0;
+    for (int j = graph.in_begin[v]; j < graph.in_begin[v + 1]; ++j)
+    {
+        const LayoutEdge& edge = graph.edges[graph.in_edges[j]];
+        sum += graph.ys[edge.source] + edge.source_offset - edge.target_offset;
+        ++count;
+    }
+    for (int j = graph.out_begin[v]; j < graph.out_begin[v + 1]; ++j)
+    {
+        const LayoutEdge& edge = graph.edges[graph.out_edges[j]];
+        sum += graph.ys[edge.target] + edge.target_offset - edge.source_offset;
+        ++count;
+    }
+    return count > 0 ? sum / count : graph.ys[v];
+}
+
+void place_layer_at_desired_ys(
+    LayoutGraph& graph,
+    const int layer,
+    const float node_spacing)
+{
+    graph.desired_ys.resize(0);
+    for (int i = graph.layer_begin[layer]; i < graph.layer_begin[layer + 1];
+         ++i)
+    {
+        graph.desired_ys.push_back(desired_y(graph, graph.layer_vertices[i]));
+    }
+    place_layer(graph, layer, node_spacing);
+}
+
+// Assigns the y coordinates of the vertices in the affected layers. The
+// layers are first stacked around y = 0 (or projected from the current
+// coordinates, when other layers stay fixed), and then moved towards their
+// neighbours, sweeping down and up the layers.
+void layout_assign_ys(
+    LayoutGraph& graph,
+    const bool keep_current_ys,
+    const LayoutOptions& options)
+{
+    for (int layer = 0; layer < graph.num_layers; ++layer)
+    {
+        if (!graph.affected_layers[layer])
+        {
+            continue;
+        }
+
+        graph.desired_ys.resize(0);
+        for (int i = graph.layer_begin[layer]; i < graph.layer_begin[layer + 1];
+             ++i)
+        {
+            graph.desired_ys.push_back(
+                keep_current_ys ? graph.ys[graph.layer_vertices[i]] : 0.f);
+        }
+        place_layer(graph, layer, options.node_spacing);
+    }
+
+    for (int iteration = 0; iteration < options.iterations; ++iteration)
+    {
+        for (int layer = 1; layer < graph.num_layers; ++layer)
+        {
+            if (graph.affected_layers[layer])
+            {
+                place_layer_at_desired_ys(graph, layer, options.node_spacing);
+            }
+        }
+        for (int layer = graph.num_layers - 2; layer >= 0; --layer)
+        {
+            if (graph.affected_layers[layer])
+            {
+                place_layer_at_desired_ys(graph, layer, options.node_spacing);
+            }
+        }
+    }
+}
+
+// Lays out the editor's nodes. If incremental is true, and the editor has
+// been laid out before, nodes from the previous layout keep their layers, and
+// only the layers which gained or lost nodes are laid out again.
+void layout_editor(
+    EditorContext& editor,
+    const LayoutOptions& options,
+    bool incremental)
+{
+    LayoutState& state = editor.layout;
+    incremental = incremental && !state.layer_xs.empty();
+
+    LayoutGraph graph;
+    layout_collect_graph(editor, graph);
+    if (graph.num_nodes == 0)
+    {
+        state.node_layers.Clear();
+        state.layer_xs.clear();
+        return;
+    }
+
+    ImVector<bool> fixed;
+    fixed.resize(graph.num_nodes);
+    for (int v = 0; v < graph.num_nodes; ++v)
+    {
+        const NodeData& node = editor.nodes.pool[graph.node_indices[v]];
+        const int layer = state.node_layers.GetInt(node.id, 0) - 1;
+        fixed[v] = incremental && layer >= 0;
+        graph.layers[v] = fixed[v] ? layer : 0;
+    }
+
+    layout_break_cycles(graph);
+    layout_assign_layers(graph, fixed);
+    layout_insert_dummy_vertices(graph, fixed);
+
+    // Without a previous layout, every layer is laid out. Otherwise, the
+    // layers which contain new nodes, the links of new nodes, or nodes which
+    // have been removed since the previous layout are.
+    graph.affected_layers.resize(graph.num_layers);
+    memset(graph.affected_layers.Data, !incremental, graph.num_layers);
+    if (incremental)
+    {
+        for (int v = 0; v < graph.num_vertices(); ++v)
+        {
+            if (!fixed[v])
+            {
+                graph.affected_layers[graph.layers[v]] = true;
+            }
+        }
+        for (int i = 0; i < state.node_layers.pairs.size(); ++i)
+        {
+            const IdMap::Pair& pair = state.node_layers.pairs[i];
+            const int node_idx = editor.nodes.id_map.GetInt(pair.key, -1);
+            const int layer = pair.val_i - 1;
+            if ((node_idx == -1 || !editor.nodes.in_use[node_idx]) &&
+                layer < graph.num_layers)
+            {
+                graph.affected_layers[layer] = true;
+            }
+        }
+    }
+
+    layout_init_order(graph);
+    layout_minimize_crossings(graph, options.iterations);
+    layout_assign_ys(graph, incremental, options);
+
+    ImVec2 origin(FLT_MAX, FLT_MAX);
+    for (int v = 0; v < graph.num_nodes; ++v)
+    {
+        origin = ImMin(origin, editor.nodes.pool[graph.node_indices[v]].origin);
+    }
+
+    // The layers are placed after the widest node of the previous layer. An
+    // incremental layout only places the new layers.
+    ImVector<float> layer_widths;
+    layer_widths.resize(graph.num_layers);
+    memset(layer_widths.Data, 0, sizeof(float) * graph.num_layers);
+    for (int v = 0; v < graph.num_nodes; ++v)
+    {
+        layer_widths[graph.layers[v]] =
+            ImMax(layer_widths[graph.layers[v]], graph.sizes[v].x);
+    }
+    if (!incremental)
+    {
+        state.layer_xs.resize(0);
+        state.layer_xs.push_back(origin.x);
+    }
+    while (state.layer_xs.size() < graph.num_layers)
+    {
+        const int prev = state.layer_xs.size() - 1;
+        state.layer_xs.push_back(
+            state.layer_xs[prev] + layer_widths[prev] + options.layer_spacing);
+    }
+
+    // A full layout keeps the top left corner of the nodes in place.
+    float offset_y = 0.f;
+    if (!incremental)
+    {
+        float min_y = FLT_MAX;
+        for (int v = 0; v < graph.num_nodes; ++v)
+        {
+            min_y = ImMin(min_y, graph.ys[v]);
+        }
+        offset_y = origin.y - min_y;
+    }
+
+    state.node_layers.Clear();
+    for (int v = 0; v < graph.num_nodes; ++v)
+    {
+        NodeData& node = editor.nodes.pool[graph.node_indices[v]];
+        const int layer = graph.layers[v];
+        if (graph.affected_layers[layer])
+        {
+            node.origin = ImVec2(state.layer_xs[layer], graph.ys[v] + offset_y);
+        }
+        state.node_layers.SetInt(node.id, layer + 1);
+    }
+}
+
+// [SECTION] force layout
+
+// The force-directed layout (Fruchterman-Reingold) runs on a worker thread
+// through IO::task_runner. The links pull the nodes together, and all nodes
+// push each other apart. The repulsion is approximated with a Barnes-Hut
+// quadtree, which makes each iteration O(n log n).
+//
+// The worker and the UI thread only share the ForceLayout object, which is
+// allocated on the UI thread up front, so that the worker never allocates.
+// The positions are handed over through a double buffer: the worker copies
+// its positions into the back buffer whenever the UI thread has picked up
+// the previous ones, and BeginNodeEditor() swaps the buffers and moves the
+// nodes once per frame. In the other direction, BeginNodeEditor() sends the
+// positions of the pinned nodes, which the simulation doesn't move.
+
+struct QuadTreeNode
+{
+    ImVec2 center;
+    float half_size;
+    // The sum of the positions of the vertices in the node, and their count.
+    ImVec2 position_sum;
+    float mass;
+    // The index of the first of four children, or -1 for leaves.
+    int first_child;
+    // Leaves hold a list of vertices, linked through ForceLayout::next_vertex.
+    int first_vertex;
+};
+
+struct ForceLayout
+{
+    ForceLayoutOptions options;
+    // The ideal distance between the centers of linked nodes.
+    float ideal_length;
+
+    // The vertices are the nodes which were in use when the layout started.
+    ImVector<int> node_ids;
+    ImVector<ImVec2> half_sizes;
+    // Pairs of linked vertices.
+    ImVector<int> edges;
+
+    // Owned by the worker.
+    ImVector<ImVec2> positions; // The node centers, in grid space.
+    ImVector<ImVec2> displacements;
+    ImVector<bool> pinned;
+    ImVector<QuadTreeNode> quadtree;
+    ImVector<int> next_vertex;
+
+    // Worker to UI thread. The worker writes to published[1 - front] while
+    // positions_ready is zero, and then sets it. The UI thread flips front
+    // while positions_ready is set, and then resets it.
+    ImVector<ImVec2> published[2];
+    int front;
+    volatile int positions_ready;
+
+    // UI thread to worker. The UI thread writes the requested pins while
+    // pins_ready is zero, and then sets it. The worker copies them while
+    // pins_ready is set, and then resets it.
+    ImVector<bool> requested_pinned;
+    ImVector<ImVec2> requested_positions;
+    volatile int pins_ready;
+
+    volatile int cancel_requested;
+    volatile int finished;
+
+    // Owned by the UI thread.
+    ImVector<int> vertex_of_node;
+    ImVector<bool> pinned_this_frame;
+
+    ForceLayout()
+        : options(), ideal_length(0.f), node_ids(), half_sizes(), edges(),
+          positions(), displacements(), pinned(), quadtree(), next_vertex(),
+          front(0), positions_ready(0), requested_pinned(),
+          requested_positions(), pins_ready(0), cancel_requested(0),
+          finished(0), vertex_of_node(), pinned_this_frame()
+    {
+        published[0] = ImVector<ImVec2>();
+        published[1] = ImVector<ImVec2>();
+    }
+};
+
+const int quadtree_max_depth = 24;
+
+void build_quadtree(ForceLayout& layout)
+{
+    const ImVector<ImVec2>& positions = layout.positions;
+    ImVec2 min = positions[0], max = positions[0];
+    for (int v = 1; v < positions.size(); ++v)
+    {
+        min = ImMin(min, positions[v]);
+        max = ImMax(max, positions[v]);
+    }
+
+    // The capacity was reserved when the layout started. Leaves which can't be
+    // split without reallocating hold several vertices instead.
+    ImVector<QuadTreeNode>& quadtree = layout.quadtree;
+    quadtree.resize(0);
+    QuadTreeNode root;
+    root.center = (min + max) * 0.5f;
+    root.half_size = 0.5f * ImMax(max.x - min.x, max.y - min.y) + 1.f;
+    root.position_sum = ImVec2(0.f, 0.f);
+    root.mass = 0.f;
+    root.first_child = -1;
+    root.first_vertex = -1;
+    quadtree.push_back(root);
+
+    for (int v = 0; v < positions.size(); ++v)
+    {
+        const ImVec2 p = positions[v];
+        int node_idx = 0;
+        for (int depth = 0;; ++depth)
+        {
+            QuadTreeNode& node = quadtree[node_idx];
+            node.position_sum += p;
+            node.mass += 1.f;
+
+            if (node.first_child == -1)
+            {
+                if (node.first_vertex == -1 || depth == quadtree_max_depth ||
+                    quadtree.size() + 4 > quadtree.Capacity)
+                {
+                    layout.next_vertex[v] = node.first_vertex;
+                    node.first_vertex = v;
+                    break;
+                }
+
+                // Split the leaf, and move its vertex to one of the children.
+                node.first_child = quadtree.size();
+                for (int child_idx = 0; child_idx < 4; ++child_idx)
+                {
+                    const float offset = 0.5f * node.half_size;
+                    QuadTreeNode child;
+                    child.center = node.center +
+                                   ImVec2(
+                                       child_idx & 1 ? offset : -offset,
+                                       child_idx & 2 ? offset : -offset);
+                    child.half_size = offset;
+                    child.position_sum = ImVec2(0.f, 0.f);
+                    child.mass = 0.f;
+                    child.first_child = -1;
+                    child.first_vertex = -1;
+                    quadtree.push_back(child);
+                }
+
+                const int u = node.first_vertex;
+                const ImVec2 q = positions[u];
+                QuadTreeNode& child = quadtree
+                    [node.first_child + (q.x >= node.center.x ? 1 : 0) +
+                     (q.y >= node.center.y ? 2 : 0)];
+                child.position_sum = q;
+                child.mass = 1.f;
+                child.first_vertex = u;
+                node.first_vertex = -1;
+            }
+
+            node_idx = node.first_child + (p.x >= node.center.x ? 1 : 0) +
+                       (p.y >= node.center.y ? 2 : 0);
+        }
+    }
+}
+
+// The repulsive force k^2 / d, pointing away from the other vertices.
+inline ImVec2 repulsion(
+    const ImVec2& delta,
+    const float mass,
+    const float ideal_length)
+{
+    const float distance_sqr = ImMax(ImLengthSqr(delta), 0.01f);
+    return delta * (mass * ideal_length * ideal_length / distance_sqr);
+}
+
+ImVec2 compute_repulsion(const ForceLayout& layout, const int v)
+{
+    const ImVec2 p = layout.positions[v];
+    const float theta_sqr = layout.options.theta * layout.options.theta;
+    ImVec2 force(0.f, 0.f);
+
+    int stack[3 * quadtree_max_depth + 4];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const QuadTreeNode& node = layout.quadtree[stack[--stack_size]];
+        if (node.mass == 0.f)
+        {
+            continue;
+        }
+
+        if (node.first_child == -1)
+        {
+            for (int u = node.first_vertex; u != -1; u = layout.next_vertex[u])
+            {
+                if (u != v)
+                {
+                    // Push coincident vertices apart in a consistent
+                    // direction.
+                    const ImVec2 delta = p - layout.positions[u];
+                    force += repulsion(
+                        delta.x == 0.f && delta.y == 0.f
+                            ? ImVec2(u < v ? 0.1f : -0.1f, 0.f)
+                            : delta,
+                        1.f,
+                        layout.ideal_length);
+                }
+            }
+            continue;
+        }
+
+        // Far away nodes are approximated by their center of mass.
+        const ImVec2 delta = p - node.position_sum / node.mass;
+        const float width = 2.f * node.half_size;
+        if (width * width < theta_sqr * ImLengthSqr(delta))
+        {
+            force += repulsion(delta, node.mass, layout.ideal_length);
+        }
+        else
+        {
+            for (int child_idx = 0; child_idx < 4; ++child_idx)
+            {
+                stack[stack_size++] = node.first_child + child_idx;
+            }
+        }
+    }
+
+    return force;
+}
+
+// Runs one iteration, in which no vertex moves further than temperature.
+// Returns the largest distance moved.
+float force_layout_step(ForceLayout& layout, const float temperature)
+{
+    const int num_vertices = layout.positions.size();
+    build_quadtree(layout);
+
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        layout.displacements[v] = layout.pinned[v]
+                                      ? ImVec2(0.f, 0.f)
+                                      : compute_repulsion(layout, v);
+    }
+
+    // The attractive force d^2 / k, pulling linked vertices together.
+    for (int i = 0; i < layout.edges.size(); i += 2)
+    {
+        const int source = layout.edges[i], target = layout.edges[i + 1];
+        const ImVec2 delta =
+            layout.positions[target] - layout.positions[source];
+        const ImVec2 force =
+            delta * (ImSqrt(ImLengthSqr(delta)) / layout.ideal_length);
+        layout.displacements[source] += force;
+        layout.displacements[target] -= force;
+    }
+
+    float max_distance = 0.f;
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        if (layout.pinned[v])
+        {
+            continue;
+        }
+
+        const ImVec2 displacement = layout.displacements[v];
+        const float length = ImSqrt(ImLengthSqr(displacement));
+        if (length > 0.f)
+        {
+            const float distance = ImMin(length, temperature);
+            layout.positions[v] += displacement * (distance / length);
+            max_distance = ImMax(max_distance, distance);
+        }
+    }
+    return max_distance;
+}
+
+void force_layout_task(void* const data)
+{
+    ForceLayout& layout = *static_cast<ForceLayout*>(data);
+    const int num_vertices = layout.positions.size();
+    const int max_iterations = layout.options.max_iterations;
+    const float initial_temperature =
+        layout.ideal_length * ImMax(1.f, 0.1f * ImSqrt(float(num_vertices)));
+
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        if (atomic_load_acquire(&layout.cancel_requested) != 0)
+        {
+            break;
+        }
+
+        if (atomic_load_acquire(&layout.pins_ready) != 0)
+        {
+            for (int v = 0; v < num_vertices; ++v)
+            {
+                layout.pinned[v] = layout.requested_pinned[v];
+                if (layout.pinned[v])
+                {
+                    layout.positions[v] = layout.requested_positions[v];
+                }
+            }
+            atomic_store_release(&layout.pins_ready, 0);
+        }
+
+        // Cool down linearly, so that the layout settles.
+        const float temperature =
+            initial_temperature * (1.f - float(iteration) / max_iterations);
+        const float max_distance = force_layout_step(layout, temperature);
+
+        if (atomic_load_acquire(&layout.positions_ready) == 0)
+        {
+            memcpy(
+                layout.published[1 - layout.front].Data,
+                layout.positions.Data,
+                sizeof(ImVec2) * num_vertices);
+            atomic_store_release(&layout.positions_ready, 1);
+        }
+
+        if (max_distance < 0.1f)
+        {
+            break;
+        }
+    }
+
+    atomic_store_release(&layout.finished, 1);
+}
+
+// Nodes which can't be dragged, and the selected nodes while they are being
+// dragged, stay in place. If send is true, the pins are also copied for the
+// worker.
+void update_pinned_nodes(
+    const EditorContext& editor,
+    ForceLayout& layout,
+    const bool send)
+{
+    for (int v = 0; v < layout.node_ids.size(); ++v)
+    {
+        // Removed nodes stay where they were.
+        const int node_idx = editor.nodes.id_map.GetInt(layout.node_ids[v], -1);
+        layout.pinned_this_frame[v] =
+            node_idx == -1 || !editor.nodes.pool[node_idx].draggable;
+    }
+
+    if (editor.click_interaction_type == ClickInteractionType_Node)
+    {
+        for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+        {
+            const int node_idx = editor.selected_node_indices[i];
+            if (node_idx < layout.vertex_of_node.size() &&
+                layout.vertex_of_node[node_idx] != -1)
+            {
+                layout.pinned_this_frame[layout.vertex_of_node[node_idx]] =
+                    true;
+            }
+        }
+    }
+
+    if (!send)
+    {
+        return;
+    }
+
+    for (int v = 0; v < layout.node_ids.size(); ++v)
+    {
+        layout.requested_pinned[v] = layout.pinned_this_frame[v];
+        const int node_idx = editor.nodes.id_map.GetInt(layout.node_ids[v], -1);
+        if (node_idx != -1)
+        {
+            layout.requested_positions[v] =
+                editor.nodes.pool[node_idx].origin + layout.half_sizes[v];
+        }
+    }
+}
+
+void apply_force_layout_positions(
+    EditorContext& editor,
+    const ForceLayout& layout,
+    const ImVector<ImVec2>& positions)
+{
+    for (int v = 0; v < layout.node_ids.size(); ++v)
+    {
+        if (layout.pinned_this_frame[v])
+        {
+            continue;
+        }
+
+        const int node_idx = editor.nodes.id_map.GetInt(layout.node_ids[v], -1);
+        if (node_idx != -1)
+        {
+            editor.nodes.pool[node_idx].origin =
+                positions[v] - layout.half_sizes[v];
+        }
+    }
+}
+
+// Waits for the worker to finish, if it is still running. This only happens
+// when the editor is freed. The worker checks cancel_requested before every
+// iteration, so a running task finishes within one iteration, and a task which
+// the task runner hasn't started yet returns as soon as it starts. The wait
+// only ends once the task has run, which IO::TaskRunner requires of every
+// task, so the thread yields and then sleeps while it waits.
+void force_layout_free(ForceLayout* const layout)
+{
+    atomic_store_release(&layout->cancel_requested, 1);
+    int num_waits = 0;
+    while (atomic_load_acquire(&layout->finished) == 0)
+    {
+        wait_for_worker(num_waits);
+    }
+    IM_DELETE(layout);
+}
+
+void force_layout_stop(EditorContext& editor)
+{
+    if (editor.force_layout != NULL)
+    {
+        atomic_store_release(&editor.force_layout->cancel_requested, 1);
+        editor.stopped_force_layouts.push_back(editor.force_layout);
+        editor.force_layout = NULL;
+    }
+}
+
+void force_layout_start(
+    EditorContext& editor,
+    const ForceLayoutOptions& options)
+{
+    force_layout_stop(editor);
+
+    ForceLayout* const layout = IM_NEW(ForceLayout);
+    layout->options = options;
+
+    layout->vertex_of_node.resize(editor.nodes.pool.size());
+    float mean_size = 0.f;
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        layout->vertex_of_node[node_idx] = -1;
+        if (!editor.nodes.in_use[node_idx])
+        {
+            continue;
+        }
+
+        const NodeData& node = editor.nodes.pool[node_idx];
+        const ImVec2 half_size = node.grid_space_size * 0.5f;
+        layout->vertex_of_node[node_idx] = layout->node_ids.size();
+        layout->node_ids.push_back(node.id);
+        layout->half_sizes.push_back(half_size);
+        layout->positions.push_back(node.origin + half_size);
+        mean_size += half_size.x + half_size.y;
+    }
+
+    const int num_vertices = layout->node_ids.size();
+    if (num_vertices == 0)
+    {
+        IM_DELETE(layout);
+        return;
+    }
+    layout->ideal_length = options.link_length + mean_size / num_vertices;
+
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        if (!editor.links.in_use[link_idx])
+        {
+            continue;
+        }
+
+        const LinkData& link = editor.links.pool[link_idx];
+        const int source = layout->vertex_of_node
+                               [editor.pins.pool[link.start_pin_idx]
+                                    .parent_node_idx];
+        const int target = layout->vertex_of_node
+                               [editor.pins.pool[link.end_pin_idx]
+                                    .parent_node_idx];
+        if (source != -1 && target != -1 && source != target)
+        {
+            layout->edges.push_back(source);
+            layout->edges.push_back(target);
+        }
+    }
+
+    // Spread out nodes which sit on top of each other, such as freshly
+    // created nodes, on a sunflower spiral. The forces can't separate them
+    // otherwise.
+    ImGuiStorage duplicates;
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        const ImGuiID key = ImHashData(&layout->positions[v], sizeof(ImVec2));
+        int* const count = duplicates.GetIntRef(key, 0);
+        if (*count > 0)
+        {
+            const float radius = 0.5f * layout->ideal_length * ImSqrt(*count);
+            const float angle = 2.39996323f * *count;
+            layout->positions[v] +=
+                ImVec2(radius * ImCos(angle), radius * ImSin(angle));
+        }
+        ++*count;
+    }
+
+    layout->displacements.resize(num_vertices);
+    layout->pinned.resize(num_vertices);
+    layout->next_vertex.resize(num_vertices);
+    layout->quadtree.reserve(8 * num_vertices + 1);
+    layout->published[0].resize(num_vertices);
+    layout->published[1].resize(num_vertices);
+    layout->requested_pinned.resize(num_vertices);
+    // Removed nodes are pinned where they were last sent from. A node which
+    // is removed before the first pins are sent stays at its start position.
+    layout->requested_positions = layout->positions;
+    layout->pinned_this_frame.resize(num_vertices);
+
+    update_pinned_nodes(editor, *layout, false);
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        layout->pinned[v] = layout->pinned_this_frame[v];
+    }
+
+    editor.force_layout = layout;
+    run_task(g->io, force_layout_task, layout);
+}
+
+// Called once per frame from BeginNodeEditor().
+void force_layout_update(EditorContext& editor)
+{
+    for (int i = 0; i < editor.stopped_force_layouts.size();)
+    {
+        ForceLayout* const layout = editor.stopped_force_layouts[i];
+        if (atomic_load_acquire(&layout->finished) != 0)
+        {
+            IM_DELETE(layout);
+            editor.stopped_force_layouts.erase(
+                editor.stopped_force_layouts.Data + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    ForceLayout* const layout = editor.force_layout;
+    if (layout == NULL)
+    {
+        return;
+    }
+
+    // The pins can only be sent once the worker has picked up the previous
+    // ones.
+    const bool send_pins = atomic_load_acquire(&layout->pins_ready) == 0;
+    update_pinned_nodes(editor, *layout, send_pins);
+
+    if (atomic_load_acquire(&layout->finished) != 0)
+    {
+        apply_force_layout_positions(editor, *layout, layout->positions);
+        IM_DELETE(layout);
+        editor.force_layout = NULL;
+        return;
+    }
+
+    if (atomic_load_acquire(&layout->positions_ready) != 0)
+    {
+        layout->front = 1 - layout->front;
+        atomic_store_release(&layout->positions_ready, 0);
+        apply_force_layout_positions(
+            editor, *layout, layout->published[layout->front]);
+    }
+
+    if (send_pins)
+    {
+        atomic_store_release(&layout->pins_ready, 1);
+    }
+}
+
+void force_layout_free_all(EditorContext& editor)
+{
+    force_layout_stop(editor);
+    for (int i = 0; i < editor.stopped_force_layouts.size(); ++i)
+    {
+        force_layout_free(editor.stopped_force_layouts[i]);
+    }
+    editor.stopped_force_layouts.clear();
+}
+
+// [SECTION] overlap removal
+
+// The movable nodes are placed one at a time. A node which overlaps any of the
+// fixed or already placed nodes is moved to the nearest free position found
+// by a best-first search. The search starts from the positions just next to
+// each node in the way, and moves on to the positions next to the nodes in
+// the way of those, in order of increasing distance. A spatial hash keeps
+// the overlap tests local, so the cost mostly depends on how crowded the
+// nodes are, rather than on the total number of nodes.
+
+// The minimum gap left between the nodes, on top of the spacing. The contents
+// of a node are snapped to whole pixels, so its size may change by a fraction
+// of a pixel once it has moved.
+const float overlap_clearance = 1.f;
+// Keeps the rounding errors from leaving the rects overlapping by a hair.
+const float overlap_epsilon = 0.01f;
+
+struct PlacementCandidate
+{
+    float cost;
+    ImVec2 min;
+};
+
+struct OverlapRemoval
+{
+    // All nodes in use, and their rects expanded by half of the gap to leave
+    // between them.
+    ImVector<int> vertex_of_node;
+    ImVector<int> node_indices;
+    ImVector<ImRect> rects;
+    ImVector<bool> movable;
+    ImVector<ImVec2> displacements;
+
+    // The spatial hash of the placed rects. The rects overlapping the cells
+    // which hash to a bucket are linked through entry_next, starting from
+    // bucket_heads.
+    float cell_size;
+    ImVector<int> bucket_heads;
+    ImVector<int> entry_nodes, entry_next;
+    // The bottom of the lowest placed rect.
+    float max_y;
+
+    // Scratch buffers.
+    ImVector<LayoutSortItem> sort_items;
+    ImVector<int> overlapping;
+    ImVector<PlacementCandidate> candidates;
+    ImGuiStorage visited;
+
+    OverlapRemoval()
+        : vertex_of_node(), node_indices(), rects(), movable(),
+          displacements(), cell_size(1.f), bucket_heads(), entry_nodes(),
+          entry_next(), max_y(-FLT_MAX), sort_items(), overlapping(),
+          candidates(), visited()
+    {
+    }
+};
+
+void spatial_hash_insert(OverlapRemoval& state, const int v)
+{
+    const ImRect& rect = state.rects[v];
+    const int x0 = cell_coordinate(rect.Min.x, state.cell_size);
+    const int x1 = cell_coordinate(rect.Max.x, state.cell_size);
+    const int y0 = cell_coordinate(rect.Min.y, state.cell_size);
+    const int y1 = cell_coordinate(rect.Max.y, state.cell_size);
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const int bucket = cell_bucket(x, y, state.bucket_heads.size());
+            state.entry_nodes.push_back(v);
+            state.entry_next.push_back(state.bucket_heads[bucket]);
+            state.bucket_heads[bucket] = state.entry_nodes.size() - 1;
+        }
+    }
+    state.max_y = ImMax(state.max_y, rect.Max.y);
+}
+
+// Returns true if the rect overlaps any of the placed rects. The overlapped
+// rects are added to state.overlapping, possibly more than once.
+bool find_overlaps(OverlapRemoval& state, const ImRect& rect)
+{
+    state.overlapping.resize(0);
+    const int x0 = cell_coordinate(rect.Min.x, state.cell_size);
+    const int x1 = cell_coordinate(rect.Max.x, state.cell_size);
+    const int y0 = cell_coordinate(rect.Min.y, state.cell_size);
+    const int y1 = cell_coordinate(rect.Max.y, state.cell_size);
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const int bucket = cell_bucket(x, y, state.bucket_heads.size());
+            for (int entry = state.bucket_heads[bucket]; entry != -1;
+                 entry = state.entry_next[entry])
+            {
+                const int u = state.entry_nodes[entry];
+                if (rect.Overlaps(state.rects[u]))
+                {
+                    state.overlapping.push_back(u);
+                }
+            }
+        }
+    }
+    return !state.overlapping.empty();
+}
+
+void add_candidate(
+    OverlapRemoval& state,
+    const ImVec2& min,
+    const ImVec2& original_min)
+{
+    int* const visited = state.visited.GetIntRef(ImHashData(&min, sizeof(min)));
+    if (*visited == 0)
+    {
+        *visited = 1;
+        PlacementCandidate candidate;
+        candidate.cost = ImLengthSqr(min - original_min);
+        candidate.min = min;
+        heap_push(state.candidates, candidate);
+    }
+}
+
+// Adds the positions which move the rect at min just clear of each of the
+// overlapped rects, along one axis.
+void add_candidates_around_overlaps(
+    OverlapRemoval& state,
+    const ImVec2& min,
+    const ImVec2& size,
+    const ImVec2& original_min)
+{
+    for (int i = 0; i < state.overlapping.size(); ++i)
+    {
+        const ImRect& other = state.rects[state.overlapping[i]];
+        add_candidate(
+            state,
+            ImVec2(other.Min.x - size.x - overlap_epsilon, min.y),
+            original_min);
+        add_candidate(
+            state, ImVec2(other.Max.x + overlap_epsilon, min.y), original_min);
+        add_candidate(
+            state,
+            ImVec2(min.x, other.Min.y - size.y - overlap_epsilon),
+            original_min);
+        add_candidate(
+            state, ImVec2(min.x, other.Max.y + overlap_epsilon), original_min);
+    }
+}
+
+void place_node(OverlapRemoval& state, const int v)
+{
+    // Bounds the search in the unlikely case that the node is surrounded by a
+    // large crowd of nodes. The node then goes below all of the placed nodes.
+    const int max_candidates = 4096;
+
+    const ImRect rect = state.rects[v];
+    const ImVec2 size = rect.GetSize();
+    ImVec2 min = rect.Min;
+
+    if (find_overlaps(state, rect))
+    {
+        state.visited.Clear();
+        state.candidates.resize(0);
+        add_candidates_around_overlaps(state, rect.Min, size, rect.Min);
+
+        min = ImVec2(rect.Min.x, state.max_y + overlap_epsilon);
+        for (int i = 0; i < max_candidates && !state.candidates.empty(); ++i)
+        {
+            const PlacementCandidate candidate = heap_pop(state.candidates);
+            if (!find_overlaps(
+                    state, ImRect(candidate.min, candidate.min + size)))
+            {
+                min = candidate.min;
+                break;
+            }
+            add_candidates_around_overlaps(
+                state, candidate.min, size, rect.Min);
+        }
+
+        state.rects[v] = ImRect(min, min + size);
+        state.displacements[v] += min - rect.Min;
+    }
+
+    spatial_hash_insert(state, v);
+}
+
+// Nodes which sit exactly on top of each other, such as pasted nodes without
+// positions, are spread out on a grid around their pile instead. The grid
+// cells are visited ring by ring, and the cells which are already taken are
+// skipped. This is much faster than searching for a free position for each
+// node, as the search would have to find its way out of the other nodes of
+// the pile.
+void place_pile(OverlapRemoval& state, const int begin, const int end)
+{
+    const ImVector<LayoutSortItem>& items = state.sort_items;
+    const ImVec2 pile_min = state.rects[items[begin].vertex].Min;
+    ImVec2 cell_size(0.f, 0.f);
+    for (int i = begin; i < end; ++i)
+    {
+        cell_size = ImMax(cell_size, state.rects[items[i].vertex].GetSize());
+    }
+    cell_size += ImVec2(overlap_epsilon, overlap_epsilon);
+
+    int next = begin;
+    for (int ring = 0; next < end; ++ring)
+    {
+        // Walk around the ring, one side at a time.
+        const int ring_cells = ring == 0 ? 1 : 8 * ring;
+        for (int cell = 0; cell < ring_cells && next < end; ++cell)
+        {
+            int x = 0, y = 0;
+            if (ring > 0)
+            {
+                const int side = cell / (2 * ring), step = cell % (2 * ring);
+                x = side == 0 ? -ring + step : side == 1 ? ring
+                    : side == 2 ? ring - step : -ring;
+                y = side == 0 ? -ring : side == 1 ? -ring + step
+                    : side == 2 ? ring : ring - step;
+            }
+
+            const int v = items[next].vertex;
+            const ImVec2 min(
+                pile_min.x + x * cell_size.x, pile_min.y + y * cell_size.y);
+            const ImRect rect(min, min + state.rects[v].GetSize());
+            if (!find_overlaps(state, rect))
+            {
+                state.displacements[v] += min - state.rects[v].Min;
+                state.rects[v] = rect;
+                spatial_hash_insert(state, v);
+                ++next;
+            }
+        }
+    }
+}
+
+// Places the movable nodes. Nodes on their own are placed first, one by one,
+// and the piles of nodes at the same position are spread out afterwards.
+void place_movable_nodes(OverlapRemoval& state)
+{
+    ImVector<LayoutSortItem>& items = state.sort_items;
+    items.resize(0);
+    for (int v = 0; v < state.rects.size(); ++v)
+    {
+        if (state.movable[v])
+        {
+            LayoutSortItem item;
+            item.key = state.rects[v].Min.x;
+            item.tiebreak = v;
+            item.vertex = v;
+            items.push_back(item);
+        }
+    }
+    ImQsort(
+        items.Data,
+        items.size(),
+        sizeof(LayoutSortItem),
+        compare_layout_sort_items);
+
+    // The begin and end of each pile in the sorted items.
+    ImVector<int> piles;
+    for (int begin = 0; begin < items.size();)
+    {
+        // Find the nodes with the same x coordinate, and then split them
+        // further by their y coordinate.
+        int end = begin + 1;
+        while (end < items.size() && items[end].key == items[begin].key)
+        {
+            ++end;
+        }
+        for (int i = begin; i < end; ++i)
+        {
+            items[i].key = state.rects[items[i].vertex].Min.y;
+        }
+        ImQsort(
+            items.Data + begin,
+            end - begin,
+            sizeof(LayoutSortItem),
+            compare_layout_sort_items);
+
+        for (int pile_begin = begin; pile_begin < end;)
+        {
+            int pile_end = pile_begin + 1;
+            while (pile_end < end &&
+                   items[pile_end].key == items[pile_begin].key)
+            {
+                ++pile_end;
+            }
+            if (pile_end - pile_begin == 1)
+            {
+                place_node(state, items[pile_begin].vertex);
+            }
+            else
+            {
+                piles.push_back(pile_begin);
+                piles.push_back(pile_end);
+            }
+            pile_begin = pile_end;
+        }
+        begin = end;
+    }
+
+    for (int i = 0; i < piles.size(); i += 2)
+    {
+        place_pile(state, piles[i], piles[i + 1]);
+    }
+}
+
+void remove_overlaps(
+    EditorContext& editor,
+    OverlapRemoval& state,
+    const float spacing)
+{
+    const int num_vertices = state.rects.size();
+    if (num_vertices == 0)
+    {
+        return;
+    }
+
+    float size_sum = 0.f;
+    int num_cells = 0;
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        ImRect& rect = state.rects[v];
+        rect.Expand(0.5f * (spacing + overlap_clearance));
+        size_sum += rect.GetWidth() + rect.GetHeight();
+    }
+    // Cells of about the average node size keep both the number of cells per
+    // node and the number of nodes per cell low.
+    state.cell_size = ImMax(size_sum / (2 * num_vertices), 1.f);
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        const ImRect& rect = state.rects[v];
+        num_cells += (int(rect.GetWidth() / state.cell_size) + 2) *
+                     (int(rect.GetHeight() / state.cell_size) + 2);
+    }
+
+    int num_buckets = 1;
+    while (num_buckets < num_cells)
+    {
+        num_buckets <<= 1;
+    }
+    state.bucket_heads.resize(num_buckets);
+    for (int i = 0; i < num_buckets; ++i)
+    {
+        state.bucket_heads[i] = -1;
+    }
+    state.entry_nodes.reserve(num_cells);
+    state.entry_next.reserve(num_cells);
+
+    state.displacements.resize(num_vertices);
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        state.displacements[v] = ImVec2(0.f, 0.f);
+    }
+
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        if (!state.movable[v])
+        {
+            spatial_hash_insert(state, v);
+        }
+    }
+    place_movable_nodes(state);
+
+    for (int v = 0; v < num_vertices; ++v)
+    {
+        editor.nodes.pool[state.node_indices[v]].origin +=
+            state.displacements[v];
+    }
+}
+
+// Collects the nodes in use. Nodes with no size haven't been measured yet,
+// and are left out.
+void init_overlap_removal(const EditorContext& editor, OverlapRemoval& state)
+{
+    state.vertex_of_node.resize(editor.nodes.pool.size());
+    for (int node_idx = 0; node_idx < editor.nodes.pool.size(); ++node_idx)
+    {
+        const NodeData& node = editor.nodes.pool[node_idx];
+        state.vertex_of_node[node_idx] = -1;
+        if (editor.nodes.in_use[node_idx] && node.grid_space_size.x > 0.f &&
+            node.grid_space_size.y > 0.f)
+        {
+            state.vertex_of_node[node_idx] = state.node_indices.size();
+            state.node_indices.push_back(node_idx);
+            state.rects.push_back(
+                ImRect(node.origin, node.origin + node.grid_space_size));
+            state.movable.push_back(false);
+        }
+    }
+}
+
+// [SECTION] node groups
+
+// The members of a collapsed group aren't submitted, so they're dropped from
+// the pools like any other node which isn't submitted. The group keeps what's
+// needed to restore them, and the pins which are linked outside of the group
+// move to the group node. A proxy pin is the member's own pin, so the links
+// to it, the hovered pin and the created links keep using the member pin's id.
+
+// Orders the pairs of an IdMap by key, and the pairs with the same key by
+// value.
+int compare_id_map_pairs_and_values(const void* lhs, const void* rhs)
+{
+    const IdMap::Pair& lhs_pair = *static_cast<const IdMap::Pair*>(lhs);
+    const IdMap::Pair& rhs_pair = *static_cast<const IdMap::Pair*>(rhs);
+    if (lhs_pair.key != rhs_pair.key)
+    {
+        return int(lhs_pair.key > rhs_pair.key) -
+               int(lhs_pair.key < rhs_pair.key);
+    }
+    return int(lhs_pair.val_i > rhs_pair.val_i) -
+           int(lhs_pair.val_i < rhs_pair.val_i);
+}
+
+// Sorts the pairs which were pushed in the order of their values, keeping the
+// pair with the largest value for each key.
+void sort_id_map_keeping_last(IdMap& map)
+{
+    EditorVector<IdMap::Pair>& pairs = map.pairs;
+    qsort(
+        pairs.Data,
+        pairs.size(),
+        sizeof(IdMap::Pair),
+        compare_id_map_pairs_and_values);
+
+    int num_kept = 0;
+    for (int i = 0; i < pairs.size(); ++i)
+    {
+        if (i + 1 < pairs.size() && pairs[i + 1].key == pairs[i].key)
+        {
+            continue;
+        }
+        pairs[num_kept++] = pairs[i];
+    }
+    pairs.resize(num_kept);
+}
+
+// Adds the pairs, sorted by key, to the map. A pair replaces the map's pair
+// with the same key.
+void merge_id_map_pairs(IdMap& map, const EditorVector<IdMap::Pair>& pairs)
+{
+    EditorVector<IdMap::Pair> merged(map.pairs.allocator);
+    merged.reserve(map.pairs.size() + pairs.size());
+    int i = 0;
+    int j = 0;
+    while (i < map.pairs.size() || j < pairs.size())
+    {
+        if (j == pairs.size() ||
+            (i < map.pairs.size() && map.pairs[i].key < pairs[j].key))
+        {
+            merged.push_back(map.pairs[i++]);
+        }
+        else
+        {
+            if (i < map.pairs.size() && map.pairs[i].key == pairs[j].key)
+            {
+                ++i;
+            }
+            merged.push_back(pairs[j++]);
+        }
+    }
+    map.pairs.swap(merged);
+}
+
+void update_outermost_node_groups(NodeGroups& groups)
+{
+    for (int i = 0; i < groups.groups.size(); ++i)
+    {
+        int group_idx = i;
+        int member_idx = -1;
+        while ((member_idx = groups.member_ids.GetInt(
+                    groups.groups[group_idx].id, -1)) != -1)
+        {
+            group_idx = groups.members[member_idx].group_idx;
+        }
+        groups.groups[i].outermost_idx = group_idx;
+    }
+}
+
+// Adds the ids of the group which was collapsed last to the maps. The group's
+// own ids are merged in, since a group may have many members.
+void add_node_group_ids(NodeGroups& groups, EditorVector<IdMap::Pair>& pairs)
+{
+    const int group_idx = groups.groups.size() - 1;
+    const NodeGroup& group = groups.groups[group_idx];
+
+    pairs.resize(0);
+    pairs.push_back(IdMap::Pair(static_cast<ImGuiID>(group.id), group_idx));
+    merge_id_map_pairs(groups.group_ids, pairs);
+
+    pairs.resize(0);
+    for (int i = group.member_begin; i < group.member_end; ++i)
+    {
+        pairs.push_back(
+            IdMap::Pair(static_cast<ImGuiID>(groups.members[i].node_id), i));
+    }
+    qsort(pairs.Data, pairs.size(), sizeof(IdMap::Pair), compare_id_map_pairs);
+    merge_id_map_pairs(groups.member_ids, pairs);
+
+    // The pins of the nested group nodes now map to this group's records.
+    pairs.resize(0);
+    for (int i = group.pin_begin; i < group.pin_end; ++i)
+    {
+        pairs.push_back(
+            IdMap::Pair(static_cast<ImGuiID>(groups.pins[i].pin_id), i));
+    }
+    qsort(pairs.Data, pairs.size(), sizeof(IdMap::Pair), compare_id_map_pairs);
+    merge_id_map_pairs(groups.pin_ids, pairs);
+
+    update_outermost_node_groups(groups);
+}
+
+// Rebuilds the maps from all of the groups, once a group has been expanded.
+void rebuild_node_group_ids(NodeGroups& groups)
+{
+    groups.group_ids.pairs.resize(0);
+    for (int i = 0; i < groups.groups.size(); ++i)
+    {
+        groups.group_ids.pairs.push_back(
+            IdMap::Pair(static_cast<ImGuiID>(groups.groups[i].id), i));
+    }
+    sort_id_map_keeping_last(groups.group_ids);
+
+    groups.member_ids.pairs.resize(0);
+    for (int i = 0; i < groups.members.size(); ++i)
+    {
+        groups.member_ids.pairs.push_back(
+            IdMap::Pair(static_cast<ImGuiID>(groups.members[i].node_id), i));
+    }
+    sort_id_map_keeping_last(groups.member_ids);
+
+    // The outer groups come after the groups nested in them, so their records
+    // of the nested group nodes' pins are kept.
+    groups.pin_ids.pairs.resize(0);
+    for (int i = 0; i < groups.pins.size(); ++i)
+    {
+        groups.pin_ids.pairs.push_back(
+            IdMap::Pair(static_cast<ImGuiID>(groups.pins[i].pin_id), i));
+    }
+    sort_id_map_keeping_last(groups.pin_ids);
+
+    update_outermost_node_groups(groups);
+}
+
+// Returns the outermost collapsed group of the pin's node, or -1 if the pin's
+// node isn't collapsed.
+int find_pin_node_group(const NodeGroups& groups, const int pin_id)
+{
+    const int pin_record_idx = groups.pin_ids.GetInt(pin_id, -1);
+    return pin_record_idx == -1
+               ? -1
+               : groups.groups[groups.pins[pin_record_idx].group_idx]
+                     .outermost_idx;
+}
+
+// Returns true if the pin is one of the group's proxy pins. Otherwise the pin
+// becomes one from the next frame on, unless it belongs to a group nested in
+// the group, whose pins the group doesn't have.
+bool expose_node_group_pin(
+    NodeGroups& groups,
+    const int group_idx,
+    const int pin_id)
+{
+    const int pin_record_idx = groups.pin_ids.GetInt(pin_id, -1);
+    NodeGroup& group = groups.groups[group_idx];
+    if (groups.pins[pin_record_idx].group_idx != group_idx)
+    {
+        return false;
+    }
+    if (pin_record_idx < group.proxy_end)
+    {
+        return true;
+    }
+
+    const int proxy_record_idx = group.proxy_end++;
+    ImSwap(groups.pins[pin_record_idx], groups.pins[proxy_record_idx]);
+    groups.pin_ids.SetInt(
+        static_cast<ImGuiID>(groups.pins[pin_record_idx].pin_id),
+        pin_record_idx);
+    groups.pin_ids.SetInt(
+        static_cast<ImGuiID>(groups.pins[proxy_record_idx].pin_id),
+        proxy_record_idx);
+    return false;
+}
+
+// Returns false if the link shouldn't be submitted, as it runs between the
+// members of a group, or to a member pin which isn't a proxy pin yet.
+bool is_node_group_link_shown(
+    NodeGroups& groups,
+    const int start_pin_id,
+    const int end_pin_id)
+{
+    const int start_group_idx = find_pin_node_group(groups, start_pin_id);
+    const int end_group_idx = find_pin_node_group(groups, end_pin_id);
+    if (start_group_idx == end_group_idx)
+    {
+        return start_group_idx == -1;
+    }
+
+    const bool start_shown =
+        start_group_idx == -1 ||
+        expose_node_group_pin(groups, start_group_idx, start_pin_id);
+    const bool end_shown =
+        end_group_idx == -1 ||
+        expose_node_group_pin(groups, end_group_idx, end_pin_id);
+    return start_shown && end_shown;
+}
+
+inline int find_node_group(const EditorContext& editor, const int node_id)
+{
+    return editor.node_groups.groups.empty()
+               ? -1
+               : editor.node_groups.group_ids.GetInt(node_id, -1);
+}
+
+// The proxy pins are laid out in rows below the group node's contents, with
+// the inputs and the outputs side by side.
+int count_node_group_proxy_rows(const NodeGroups& groups, const int group_idx)
+{
+    const NodeGroup& group = groups.groups[group_idx];
+    int num_inputs = 0;
+    for (int i = group.pin_begin; i < group.proxy_end; ++i)
+    {
+        num_inputs += groups.pins[i].type == AttributeType_Input ? 1 : 0;
+    }
+    const int num_outputs = group.proxy_end - group.pin_begin - num_inputs;
+    return ImMax(num_inputs, num_outputs);
+}
+
+// Submits the group's proxy pins as the pins of the current node, once the
+// node's rect is known. Zoomed out, the rows are squeezed to fit a node which
+// hasn't been measured with them.
+void submit_node_group_proxy_pins(EditorContext& editor, const int group_idx)
+{
+    const NodeGroups& groups = editor.node_groups;
+    const NodeGroup& group = groups.groups[group_idx];
+    const int node_idx = g->current_node_idx;
+    NodeData& node = editor.nodes.pool[node_idx];
+    const ImRect& node_rect = editor.node_rects[node_idx];
+    const ImVec2 padding = get_node_style(node).padding;
+
+    const int num_rows = count_node_group_proxy_rows(groups, group_idx);
+    const float rows_height = ImClamp(
+        ImGui::GetTextLineHeightWithSpacing() * static_cast<float>(num_rows),
+        0.f,
+        node_rect.GetHeight() - 2.f * padding.y);
+    const float row_height =
+        num_rows > 0 ? rows_height / static_cast<float>(num_rows) : 0.f;
+    const float rows_min_y = node_rect.Max.y - padding.y - rows_height;
+
+    PinStyle style;
+    style.background = g->style.colors[ColorStyle_Pin];
+    style.hovered = g->style.colors[ColorStyle_PinHovered];
+    const ImU16 style_idx = g->pin_styles.intern(style);
+
+    int num_inputs = 0;
+    int num_outputs = 0;
+    for (int i = group.pin_begin; i < group.proxy_end; ++i)
+    {
+        const NodeGroupPin& proxy = groups.pins[i];
+        const int pin_idx = find_or_create_pin_index(editor, proxy.pin_id);
+        PinData& pin = editor.pins.pool[pin_idx];
+        pin.id = proxy.pin_id;
+        pin.parent_node_idx = node_idx;
+        pin.type = proxy.type;
+        pin.shape = proxy.shape;
+        pin.flags = proxy.flags;
+        pin.style_idx = style_idx;
+
+        const int row =
+            proxy.type == AttributeType_Input ? num_inputs++ : num_outputs++;
+        const float min_y = rows_min_y + row_height * static_cast<float>(row);
+        pin.attribute_rect = ImRect(
+            node_rect.Min.x + padding.x,
+            min_y,
+            node_rect.Max.x - padding.x,
+            min_y + row_height);
+        editor.pin_positions[pin_idx] = get_screen_space_pin_coordinates(
+            node_rect, pin.attribute_rect, pin.type);
+
+        g->pin_indices.push_back(pin_idx);
+        IMNODES_STAT(++g->stats.pins_submitted);
+    }
+    node.pin_index_end = g->pin_indices.size();
+}
+
+// The grid space origin of a collapsed node, as if its group, and the groups
+// which the group is nested in, were expanded.
+ImVec2 get_collapsed_node_origin(const EditorContext& editor, int member_idx)
+{
+    const NodeGroups& groups = editor.node_groups;
+    ImVec2 origin(0.f, 0.f);
+    for (;;)
+    {
+        const NodeGroupMember& member = groups.members[member_idx];
+        origin += member.offset;
+        const int group_id = groups.groups[member.group_idx].id;
+        member_idx = groups.member_ids.GetInt(group_id, -1);
+        if (member_idx == -1)
+        {
+            const int node_idx = editor.nodes.id_map.GetInt(group_id, -1);
+            return node_idx == -1 ? origin
+                                  : origin + editor.nodes.pool[node_idx].origin;
+        }
+    }
+}
+
+void collapse_node_group(
+    EditorContext& editor,
+    const int group_id,
+    const int* const node_ids,
+    const int num_node_ids)
+{
+    NodeGroups& groups = editor.node_groups;
+    // The group is already collapsed.
+    assert(groups.group_ids.GetInt(group_id, -1) == -1);
+
+    ImVector<bool> is_member;
+    is_member.resize(editor.nodes.pool.size(), false);
+    ImRect bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (int i = 0; i < num_node_ids; ++i)
+    {
+        const int node_idx = editor.nodes.id_map.GetInt(node_ids[i], -1);
+        // The members have to have been submitted during the last frame, and
+        // the group node can't be one of them.
+        assert(node_idx != -1 && editor.nodes.in_use[node_idx]);
+        assert(node_ids[i] != group_id);
+        is_member[node_idx] = true;
+        bounds.Add(get_node_grid_space_rect(editor.nodes.pool[node_idx]));
+    }
+
+    const int group_idx = groups.groups.size();
+    NodeGroup group;
+    group.id = group_id;
+
+    group.member_begin = groups.members.size();
+    for (int node_idx = 0; node_idx < is_member.size(); ++node_idx)
+    {
+        if (is_member[node_idx])
+        {
+            const NodeData& node = editor.nodes.pool[node_idx];
+            NodeGroupMember member;
+            member.node_id = node.id;
+            member.group_idx = group_idx;
+            member.offset = node.origin - bounds.Min;
+            member.grid_space_size = node.grid_space_size;
+            member.draggable = node.draggable;
+            groups.members.push_back(member);
+        }
+    }
+    group.member_end = groups.members.size();
+
+    // The member pins which are linked to the pins of other nodes become proxy
+    // pins.
+    ImVector<bool> is_proxy;
+    is_proxy.resize(editor.pins.pool.size(), false);
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        if (!editor.links.in_use[link_idx])
+        {
+            continue;
+        }
+        const LinkData& link = editor.links.pool[link_idx];
+        const bool start_is_member =
+            is_member[editor.pins.pool[link.start_pin_idx].parent_node_idx];
+        const bool end_is_member =
+            is_member[editor.pins.pool[link.end_pin_idx].parent_node_idx];
+        if (start_is_member != end_is_member)
+        {
+            is_proxy[start_is_member ? link.start_pin_idx : link.end_pin_idx] =
+                true;
+        }
+    }
+
+    group.pin_begin = groups.pins.size();
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        const bool proxies = pass == 0;
+        for (int pin_idx = 0; pin_idx < editor.pins.pool.size(); ++pin_idx)
+        {
+            const PinData& pin = editor.pins.pool[pin_idx];
+            if (editor.pins.in_use[pin_idx] &&
+                is_member[pin.parent_node_idx] && is_proxy[pin_idx] == proxies)
+            {
+                NodeGroupPin group_pin;
+                group_pin.pin_id = pin.id;
+                group_pin.group_idx = group_idx;
+                group_pin.type = pin.type;
+                group_pin.shape = pin.shape;
+                group_pin.flags = pin.flags;
+                groups.pins.push_back(group_pin);
+            }
+        }
+        if (proxies)
+        {
+            group.proxy_end = groups.pins.size();
+        }
+    }
+    group.pin_end = groups.pins.size();
+    group.outermost_idx = group_idx;
+    groups.groups.push_back(group);
+    EditorVector<IdMap::Pair> pairs(&editor.allocator);
+    add_node_group_ids(groups, pairs);
+
+    // The group node is created, or moved, like SetNodeGridSpacePos() does.
+    editor.nodes.pool[find_or_create_node_index(editor, group_id)].origin =
+        bounds.Min;
+
+    // The members aren't selected anymore, and neither are the links between
+    // them.
+    int num_kept = 0;
+    for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+    {
+        const int node_idx = editor.selected_node_indices[i];
+        if (node_idx >= is_member.size() || !is_member[node_idx])
+        {
+            editor.selected_node_indices[num_kept++] = node_idx;
+        }
+    }
+    editor.selected_node_indices.resize(num_kept);
+
+    num_kept = 0;
+    for (int i = 0; i < editor.selected_link_indices.size(); ++i)
+    {
+        const int link_idx = editor.selected_link_indices[i];
+        const LinkData& link = editor.links.pool[link_idx];
+        if (!is_member[editor.pins.pool[link.start_pin_idx].parent_node_idx] ||
+            !is_member[editor.pins.pool[link.end_pin_idx].parent_node_idx])
+        {
+            editor.selected_link_indices[num_kept++] = link_idx;
+        }
+    }
+    editor.selected_link_indices.resize(num_kept);
+}
+
+// Drops the records of the group, and moves the records of the groups after
+// it into their place.
+template<typename Record>
+void erase_node_group_records(
+    EditorVector<Record>& records,
+    const int group_idx)
+{
+    int num_kept = 0;
+    for (int i = 0; i < records.size(); ++i)
+    {
+        if (records[i].group_idx != group_idx)
+        {
+            Record record = records[i];
+            record.group_idx -= record.group_idx > group_idx ? 1 : 0;
+            records[num_kept++] = record;
+        }
+    }
+    records.resize(num_kept);
+}
+
+void expand_node_group(EditorContext& editor, const int group_idx)
+{
+    NodeGroups& groups = editor.node_groups;
+    const NodeGroup group = groups.groups[group_idx];
+    // The group is nested in a group which is still collapsed.
+    assert(groups.member_ids.GetInt(group.id, -1) == -1);
+
+    const int group_node_idx = editor.nodes.id_map.GetInt(group.id, -1);
+    const ImVec2 group_origin = group_node_idx != -1
+                                    ? editor.nodes.pool[group_node_idx].origin
+                                    : ImVec2(0.f, 0.f);
+    for (int i = group.member_begin; i < group.member_end; ++i)
+    {
+        const NodeGroupMember& member = groups.members[i];
+        NodeData& node = editor.nodes.pool[find_or_create_node_index(
+            editor, member.node_id)];
+        node.origin = group_origin + member.offset;
+        node.grid_space_size = member.grid_space_size;
+        node.draggable = member.draggable;
+    }
+
+    erase_node_group_records(groups.members, group_idx);
+    erase_node_group_records(groups.pins, group_idx);
+    const int num_members = group.member_end - group.member_begin;
+    const int num_pins = group.pin_end - group.pin_begin;
+    for (int i = group_idx + 1; i < groups.groups.size(); ++i)
+    {
+        NodeGroup& later_group = groups.groups[i];
+        later_group.member_begin -= num_members;
+        later_group.member_end -= num_members;
+        later_group.pin_begin -= num_pins;
+        later_group.proxy_end -= num_pins;
+        later_group.pin_end -= num_pins;
+    }
+    groups.groups.erase(groups.groups.begin() + group_idx);
+    rebuild_node_group_ids(groups);
+}
+
+// [SECTION] memory
+
+template<typename Vector>
+inline size_t vector_bytes(const Vector& v)
+{
+    return static_cast<size_t>(v.Capacity) *
+           sizeof(typename Vector::value_type);
+}
+
+template<typename T>
+PoolMemoryStats get_pool_memory_stats(const ObjectPool<T>& objects)
+{
+    PoolMemoryStats stats;
+    stats.live = objects.num_in_use();
+    stats.slots = objects.pool.size();
+    stats.capacity = objects.pool.Capacity;
+    stats.high_water_mark = ImMax(objects.max_live, stats.live);
+    stats.live_bytes = static_cast<size_t>(stats.live) * sizeof(T);
+    stats.capacity_bytes = vector_bytes(objects.pool) +
+                           vector_bytes(objects.in_use) +
+                           vector_bytes(objects.free_list) +
+                           vector_bytes(objects.id_map.pairs);
+    return stats;
+}
+
+size_t link_router_bytes(const LinkRouter& router)
+{
+    return vector_bytes(router.routes) + vector_bytes(router.points) +
+           vector_bytes(router.screen_points) +
+           vector_bytes(router.node_rects) + vector_bytes(router.dirty_rects) +
+           vector_bytes(router.dirty_link_indices) +
+           vector_bytes(router.bucket_heads) +
+           vector_bytes(router.entry_nodes) + vector_bytes(router.entry_next) +
+           vector_bytes(router.node_query_stamps) +
+           vector_bytes(router.obstacles) + vector_bytes(router.xs) +
+           vector_bytes(router.ys) + vector_bytes(router.blocked_cells) +
+           vector_bytes(router.costs) + vector_bytes(router.parents) +
+           vector_bytes(router.open_states) + vector_bytes(router.path);
+}
+
+size_t minimap_bytes(const MiniMapSummary& minimap)
+{
+    return vector_bytes(minimap.node_coverage) +
+           vector_bytes(minimap.link_counts) +
+           vector_bytes(minimap.node_rects) + vector_bytes(minimap.links);
+}
+
+size_t node_groups_bytes(const NodeGroups& groups)
+{
+    return vector_bytes(groups.groups) + vector_bytes(groups.members) +
+           vector_bytes(groups.pins) + vector_bytes(groups.group_ids.pairs) +
+           vector_bytes(groups.member_ids.pairs) +
+           vector_bytes(groups.pin_ids.pairs);
+}
+
+inline int remap_index(const ImVector<int>& new_indices, const int idx)
+{
+    return idx >= 0 && idx < new_indices.size() ? new_indices[idx] : -1;
+}
+
+inline void remap_optional_index(
+    const ImVector<int>& new_indices,
+    OptionalIndex& idx)
+{
+    if (idx.has_value())
+    {
+        const int new_idx = remap_index(new_indices, idx.value());
+        if (new_idx == -1)
+        {
+            idx.reset();
+        }
+        else
+        {
+            idx = new_idx;
+        }
+    }
+}
+
+// Drops the indices of the freed objects, and the spare capacity.
+void remap_selection(
+    const ImVector<int>& new_indices,
+    EditorVector<int>& indices)
+{
+    int num_kept = 0;
+    for (int i = 0; i < indices.size(); ++i)
+    {
+        num_kept += remap_index(new_indices, indices[i]) != -1 ? 1 : 0;
+    }
+
+    EditorVector<int> remapped(indices.allocator);
+    remapped.reserve(num_kept);
+    for (int i = 0; i < indices.size(); ++i)
+    {
+        const int new_idx = remap_index(new_indices, indices[i]);
+        if (new_idx != -1)
+        {
+            remapped.push_back(new_idx);
+        }
+    }
+    indices.swap(remapped);
+}
+
+// Moves the elements of an array indexed like a pool along with the objects,
+// and frees the spare capacity.
+template<typename T>
+void compact_parallel_array(
+    EditorVector<T>& values,
+    const ImVector<int>& new_indices,
+    const int num_live)
+{
+    EditorVector<T> compacted(values.allocator);
+    compacted.reserve(num_live);
+    compacted.resize(num_live);
+    for (int i = 0; i < values.size(); ++i)
+    {
+        const int new_idx = remap_index(new_indices, i);
+        if (new_idx != -1)
+        {
+            compacted[new_idx] = values[i];
+        }
+    }
+    values.swap(compacted);
+}
+
+// Keeps the routes of the links in use, and frees the rest of the router's
+// memory. The scratch buffers are rebuilt by the next route update.
+void compact_link_router(
+    LinkRouter& router,
+    const ImVector<int>& new_node_indices,
+    const int num_nodes,
+    const ImVector<int>& new_link_indices,
+    const int num_links)
+{
+    EditorVector<LinkRoute> routes(router.routes.allocator);
+    routes.reserve(num_links);
+    routes.resize(num_links, LinkRoute());
+    for (int link_idx = 0; link_idx < router.routes.size(); ++link_idx)
+    {
+        const int new_idx = remap_index(new_link_indices, link_idx);
+        if (new_idx == -1)
+        {
+            release_route(router, router.routes[link_idx]);
+        }
+        else
+        {
+            routes[new_idx] = router.routes[link_idx];
+        }
+    }
+    router.routes.swap(routes);
+
+    EditorVector<ImRect> node_rects(router.node_rects.allocator);
+    node_rects.reserve(num_nodes);
+    node_rects.resize(num_nodes, empty_rect());
+    for (int node_idx = 0; node_idx < router.node_rects.size(); ++node_idx)
+    {
+        const int new_idx = remap_index(new_node_indices, node_idx);
+        if (new_idx != -1)
+        {
+            node_rects[new_idx] = router.node_rects[node_idx];
+        }
+    }
+    router.node_rects.swap(node_rects);
+
+    // Compacting into the freed screen points allocates just enough room.
+    router.screen_points.clear();
+    compact_route_points(router);
+    router.screen_points.clear();
+
+    router.dirty_rects.clear();
+    router.dirty_link_indices.clear();
+    router.bucket_heads.clear();
+    router.entry_nodes.clear();
+    router.entry_next.clear();
+    router.node_query_stamps.clear();
+    router.obstacles.clear();
+    router.xs.clear();
+    router.ys.clear();
+    router.blocked_cells.clear();
+    router.costs.clear();
+    router.parents.clear();
+    router.open_states.clear();
+    router.path.clear();
+}
+
+void compact_editor(EditorContext& editor)
+{
+    ImVector<int> new_node_indices;
+    ImVector<int> new_pin_indices;
+    ImVector<int> new_link_indices;
+
+    editor.nodes.compact(new_node_indices);
+    editor.pins.compact(new_pin_indices);
+    editor.links.compact(new_link_indices);
+    compact_parallel_array(
+        editor.node_rects, new_node_indices, editor.nodes.pool.size());
+    compact_parallel_array(
+        editor.pin_positions, new_pin_indices, editor.pins.pool.size());
+
+    for (int pin_idx = 0; pin_idx < editor.pins.pool.size(); ++pin_idx)
+    {
+        PinData& pin = editor.pins.pool[pin_idx];
+        pin.parent_node_idx =
+            remap_index(new_node_indices, pin.parent_node_idx);
+    }
+
+    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    {
+        LinkData& link = editor.links.pool[link_idx];
+        link.start_pin_idx = remap_index(new_pin_indices, link.start_pin_idx);
+        link.end_pin_idx = remap_index(new_pin_indices, link.end_pin_idx);
+    }
+
+    remap_selection(new_node_indices, editor.selected_node_indices);
+    remap_selection(new_link_indices, editor.selected_link_indices);
+
+    ClickInteractionState& state = editor.click_interaction_state;
+    state.link_creation.start_pin_idx =
+        remap_index(new_pin_indices, state.link_creation.start_pin_idx);
+    state.link_creation.end_pin_idx =
+        remap_index(new_pin_indices, state.link_creation.end_pin_idx);
+
+    // The hovered and active elements of the last frame are still queried
+    // through the context.
+    if (g->editor_ctx == &editor)
+    {
+        remap_optional_index(new_node_indices, g->hovered_node_idx);
+        remap_optional_index(new_link_indices, g->hovered_link_idx);
+        remap_optional_index(new_pin_indices, g->hovered_pin_idx);
+        remap_optional_index(new_pin_indices, g->active_pin_idx);
+        remap_optional_index(new_link_indices, g->deleted_link_idx);
+    }
+
+    if (editor.force_layout != NULL)
+    {
+        ForceLayout& layout = *editor.force_layout;
+        layout.vertex_of_node.clear();
+        layout.vertex_of_node.reserve(editor.nodes.pool.size());
+        layout.vertex_of_node.resize(editor.nodes.pool.size(), -1);
+        for (int v = 0; v < layout.node_ids.size(); ++v)
+        {
+            const int node_idx =
+                editor.nodes.id_map.GetInt(layout.node_ids[v], -1);
+            if (node_idx != -1)
+            {
+                layout.vertex_of_node[node_idx] = v;
+            }
+        }
+    }
+
+    compact_link_router(
+        editor.link_router,
+        new_node_indices,
+        editor.nodes.pool.size(),
+        new_link_indices,
+        editor.links.pool.size());
+    reset_minimap(editor.minimap);
+    reset_node_geometry_cache(editor.node_geometry);
+}
+} // namespace
+
+// [SECTION] API implementation
+
+IO::EmulateThreeButtonMouse::EmulateThreeButtonMouse()
+    : enabled(false), modifier(NULL)
+{
+}
+
+IO::LinkDetachWithModifierClick::LinkDetachWithModifierClick() : modifier(NULL)
+{
+}
+
+IO::TaskRunner::TaskRunner() : run(NULL), user_data(NULL) {}
+
+IO::Profiler::Profiler() : begin_zone(NULL), end_zone(NULL), user_data(NULL) {}
+
+IO::ParallelFor::ParallelFor()
+    : run(NULL), user_data(NULL), min_elements(16384), elements_per_job(4096)
+{
+}
+
+IO::IO()
+    : emulate_three_button_mouse(), link_detach_with_modifier_click(),
+      task_runner(), parallel_for(), profiler()
+{
+}
+
+Style::Style()
+    : grid_spacing(32.f), node_corner_rounding(4.f),
+      node_padding_horizontal(8.f), node_padding_vertical(8.f),
+      link_thickness(3.f), link_line_segments_per_length(0.1f),
+      link_hover_distance(10.f), link_route_spacing(10.f),
+      detail_zoom_threshold(0.5f), pin_circle_radius(4.f),
+      pin_quad_side_length(7.f), pin_triangle_side_length(9.5),
+      pin_line_thickness(1.f), pin_hover_radius(10.f), pin_offset(0.f),
+      flags(StyleFlags(StyleFlags_NodeOutline | StyleFlags_GridLines)), colors()
+{
+}
+
+EditorAllocator::EditorAllocator() : alloc(NULL), free(NULL), user_data(NULL) {}
+
+EditorContext* EditorContextCreate()
+{
+    return EditorContextCreate(EditorAllocator());
+}
+
+EditorContext* EditorContextCreate(const EditorAllocator& allocator)
+{
+    // Either both functions are provided, or neither.
+    assert((allocator.alloc == NULL) == (allocator.free == NULL));
+    void* mem = editor_alloc(&allocator, sizeof(EditorContext));
+    EditorContext* const ctx = new (mem) EditorContext();
+    ctx->allocator = allocator;
+    return ctx;
+}
+
+EditorContext* EditorContextCreateWithArena(const size_t block_size)
+{
+    MemoryArena arena;
+    arena.block_size =
+        align_arena_size(ImMax(block_size, sizeof(EditorContext)));
+    void* mem = arena_alloc(sizeof(EditorContext), &arena);
+    EditorContext* const ctx = new (mem) EditorContext();
+    ctx->arena = arena;
+    ctx->allocator.alloc = arena_alloc;
+    ctx->allocator.free = arena_free;
+    ctx->allocator.user_data = &ctx->arena;
+    return ctx;
+}
+
+void EditorContextFree(EditorContext* ctx)
+{
+    force_layout_free_all(*ctx);
+    // The context may live in its own arena.
+    const EditorAllocator allocator = ctx->allocator;
+    MemoryArena arena = ctx->arena;
+    ctx->~EditorContext();
+    editor_free(&allocator, ctx);
+    arena_release(arena);
 }
 
-void EditorContextSet(EditorContext* ctx) { g.editor_ctx = ctx; }
+void EditorContextSet(EditorContext* ctx) { g->editor_ctx = ctx; }
 
 ImVec2 EditorContextGetPanning()
 {
@@ -1503,194 +7640,341 @@ void EditorContextResetPanning(const ImVec2& pos)
     editor.panning = pos;
 }
 
+float EditorContextGetZoom()
+{
+    const EditorContext& editor = editor_context_get();
+    return editor.zoom;
+}
+
+void EditorContextSetZoom(const float zoom, const ImVec2& screen_space_anchor)
+{
+    assert(zoom > 0.f);
+    EditorContext& editor = editor_context_get();
+    const ImVec2 anchor = screen_space_to_grid_space(screen_space_anchor);
+    editor.zoom = zoom;
+    editor.panning = screen_space_anchor - g->canvas_origin_screen_space -
+                     anchor * editor.zoom;
+}
+
 void EditorContextMoveToNode(const int node_id)
 {
     EditorContext& editor = editor_context_get();
-    NodeData& node = editor.nodes.find_or_create_new(node_id);
+    const int node_idx = editor.nodes.id_map.GetInt(node_id, -1);
+    assert(node_idx != -1);
+    const NodeData& node = editor.nodes.pool[node_idx];
 
-    editor.panning.x = -node.origin.x;
-    editor.panning.y = -node.origin.y;
+    editor.panning.x = -node.origin.x * editor.zoom;
+    editor.panning.y = -node.origin.y * editor.zoom;
 }
 
-void Initialize()
+void EditorContextFitToContent()
+{
+    EditorContext& editor = editor_context_get();
+    frame_grid_space_rect(editor, editor.content_bounds);
+}
+
+void EditorContextFrameSelection()
+{
+    EditorContext& editor = editor_context_get();
+    frame_grid_space_rect(editor, editor.selection_bounds);
+}
+
+Context* CreateContext()
 {
-    assert(initialized == false);
-    initialized = true;
+    Context* const prev_ctx = g;
 
-    g.default_editor_ctx = NULL;
-    g.editor_ctx = NULL;
-    g.canvas_origin_screen_space = ImVec2(0.0f, 0.0f);
-    g.canvas_rect_screen_space = ImRect(ImVec2(0.f, 0.f), ImVec2(0.f, 0.f));
-    g.current_scope = Scope_None;
+    void* mem = ImGui::MemAlloc(sizeof(Context));
+    Context* const ctx = new (mem) Context();
+    g = ctx;
 
-    g.default_editor_ctx = EditorContextCreate();
-    EditorContextSet(g.default_editor_ctx);
+    g->default_editor_ctx = EditorContextCreate();
+    EditorContextSet(g->default_editor_ctx);
 
     const ImGuiIO& io = ImGui::GetIO();
-    g.io.emulate_three_button_mouse.modifier = &io.KeyAlt;
+    g->io.emulate_three_button_mouse.modifier = &io.KeyAlt;
 
-    g.current_attribute_flags = AttributeFlags_None;
-    g.attribute_flag_stack.push_back(g.current_attribute_flags);
+    g->attribute_flag_stack.push_back(g->current_attribute_flags);
 
     StyleColorsDark();
+
+    // Like ImGui::CreateContext(), the new context only becomes the current
+    // context if there wasn't one already.
+    g = prev_ctx == NULL ? ctx : prev_ctx;
+    return ctx;
+}
+
+void DestroyContext(Context* ctx)
+{
+    if (ctx == NULL)
+    {
+        ctx = g;
+    }
+    assert(ctx != NULL);
+
+    EditorContextFree(ctx->default_editor_ctx);
+    if (ctx == g)
+    {
+        g = NULL;
+    }
+    ctx->~Context();
+    ImGui::MemFree(ctx);
+}
+
+Context* GetCurrentContext() { return g; }
+
+void SetCurrentContext(Context* ctx) { g = ctx; }
+
+void Initialize()
+{
+    // Initialize() was already called!
+    assert(g == NULL);
+    SetCurrentContext(CreateContext());
 }
 
-void Shutdown() { EditorContextFree(g.default_editor_ctx); }
+void Shutdown() { DestroyContext(); }
 
-IO& GetIO() { return g.io; }
+IO& GetIO() { return g->io; }
 
-Style& GetStyle() { return g.style; }
+Style& GetStyle() { return g->style; }
 
 void StyleColorsDark()
 {
-    g.style.colors[ColorStyle_NodeBackground] = IM_COL32(50, 50, 50, 255);
-    g.style.colors[ColorStyle_NodeBackgroundHovered] =
+    g->style.colors[ColorStyle_NodeBackground] = IM_COL32(50, 50, 50, 255);
+    g->style.colors[ColorStyle_NodeBackgroundHovered] =
         IM_COL32(75, 75, 75, 255);
-    g.style.colors[ColorStyle_NodeBackgroundSelected] =
+    g->style.colors[ColorStyle_NodeBackgroundSelected] =
         IM_COL32(75, 75, 75, 255);
-    g.style.colors[ColorStyle_NodeOutline] = IM_COL32(100, 100, 100, 255);
+    g->style.colors[ColorStyle_NodeOutline] = IM_COL32(100, 100, 100, 255);
     // title bar colors match ImGui's titlebg colors
-    g.style.colors[ColorStyle_TitleBar] = IM_COL32(41, 74, 122, 255);
-    g.style.colors[ColorStyle_TitleBarHovered] = IM_COL32(66, 150, 250, 255);
-    g.style.colors[ColorStyle_TitleBarSelected] = IM_COL32(66, 150, 250, 255);
+    g->style.colors[ColorStyle_TitleBar] = IM_COL32(41, 74, 122, 255);
+    g->style.colors[ColorStyle_TitleBarHovered] = IM_COL32(66, 150, 250, 255);
+    g->style.colors[ColorStyle_TitleBarSelected] = IM_COL32(66, 150, 250, 255);
     // link colors match ImGui's slider grab colors
-    g.style.colors[ColorStyle_Link] = IM_COL32(61, 133, 224, 200);
-    g.style.colors[ColorStyle_LinkHovered] = IM_COL32(66, 150, 250, 255);
-    g.style.colors[ColorStyle_LinkSelected] = IM_COL32(66, 150, 250, 255);
+    g->style.colors[ColorStyle_Link] = IM_COL32(61, 133, 224, 200);
+    g->style.colors[ColorStyle_LinkHovered] = IM_COL32(66, 150, 250, 255);
+    g->style.colors[ColorStyle_LinkSelected] = IM_COL32(66, 150, 250, 255);
     // pin colors match ImGui's button colors
-    g.style.colors[ColorStyle_Pin] = IM_COL32(53, 150, 250, 180);
-    g.style.colors[ColorStyle_PinHovered] = IM_COL32(53, 150, 250, 255);
+    g->style.colors[ColorStyle_Pin] = IM_COL32(53, 150, 250, 180);
+    g->style.colors[ColorStyle_PinHovered] = IM_COL32(53, 150, 250, 255);
 
-    g.style.colors[ColorStyle_BoxSelector] = IM_COL32(61, 133, 224, 30);
-    g.style.colors[ColorStyle_BoxSelectorOutline] = IM_COL32(61, 133, 224, 150);
+    g->style.colors[ColorStyle_BoxSelector] = IM_COL32(61, 133, 224, 30);
+    g->style.colors[ColorStyle_BoxSelectorOutline] =
+        IM_COL32(61, 133, 224, 150);
 
-    g.style.colors[ColorStyle_GridBackground] = IM_COL32(40, 40, 50, 200);
-    g.style.colors[ColorStyle_GridLine] = IM_COL32(200, 200, 200, 40);
+    g->style.colors[ColorStyle_GridBackground] = IM_COL32(40, 40, 50, 200);
+    g->style.colors[ColorStyle_GridLine] = IM_COL32(200, 200, 200, 40);
+
+    g->style.colors[ColorStyle_MiniMapBackground] = IM_COL32(25, 25, 25, 150);
+    g->style.colors[ColorStyle_MiniMapOutline] = IM_COL32(150, 150, 150, 100);
+    g->style.colors[ColorStyle_MiniMapNode] = IM_COL32(200, 200, 200, 255);
+    g->style.colors[ColorStyle_MiniMapLink] = IM_COL32(61, 133, 224, 200);
+    g->style.colors[ColorStyle_MiniMapViewport] = IM_COL32(66, 150, 250, 30);
 }
 
 void StyleColorsClassic()
 {
-    g.style.colors[ColorStyle_NodeBackground] = IM_COL32(50, 50, 50, 255);
-    g.style.colors[ColorStyle_NodeBackgroundHovered] =
+    g->style.colors[ColorStyle_NodeBackground] = IM_COL32(50, 50, 50, 255);
+    g->style.colors[ColorStyle_NodeBackgroundHovered] =
         IM_COL32(75, 75, 75, 255);
-    g.style.colors[ColorStyle_NodeBackgroundSelected] =
+    g->style.colors[ColorStyle_NodeBackgroundSelected] =
         IM_COL32(75, 75, 75, 255);
-    g.style.colors[ColorStyle_NodeOutline] = IM_COL32(100, 100, 100, 255);
-    g.style.colors[ColorStyle_TitleBar] = IM_COL32(69, 69, 138, 255);
-    g.style.colors[ColorStyle_TitleBarHovered] = IM_COL32(82, 82, 161, 255);
-    g.style.colors[ColorStyle_TitleBarSelected] = IM_COL32(82, 82, 161, 255);
-    g.style.colors[ColorStyle_Link] = IM_COL32(255, 255, 255, 100);
-    g.style.colors[ColorStyle_LinkHovered] = IM_COL32(105, 99, 204, 153);
-    g.style.colors[ColorStyle_LinkSelected] = IM_COL32(105, 99, 204, 153);
-    g.style.colors[ColorStyle_Pin] = IM_COL32(89, 102, 156, 170);
-    g.style.colors[ColorStyle_PinHovered] = IM_COL32(102, 122, 179, 200);
-    g.style.colors[ColorStyle_BoxSelector] = IM_COL32(82, 82, 161, 100);
-    g.style.colors[ColorStyle_BoxSelectorOutline] = IM_COL32(82, 82, 161, 255);
-    g.style.colors[ColorStyle_GridBackground] = IM_COL32(40, 40, 50, 200);
-    g.style.colors[ColorStyle_GridLine] = IM_COL32(200, 200, 200, 40);
+    g->style.colors[ColorStyle_NodeOutline] = IM_COL32(100, 100, 100, 255);
+    g->style.colors[ColorStyle_TitleBar] = IM_COL32(69, 69, 138, 255);
+    g->style.colors[ColorStyle_TitleBarHovered] = IM_COL32(82, 82, 161, 255);
+    g->style.colors[ColorStyle_TitleBarSelected] = IM_COL32(82, 82, 161, 255);
+    g->style.colors[ColorStyle_Link] = IM_COL32(255, 255, 255, 100);
+    g->style.colors[ColorStyle_LinkHovered] = IM_COL32(105, 99, 204, 153);
+    g->style.colors[ColorStyle_LinkSelected] = IM_COL32(105, 99, 204, 153);
+    g->style.colors[ColorStyle_Pin] = IM_COL32(89, 102, 156, 170);
+    g->style.colors[ColorStyle_PinHovered] = IM_COL32(102, 122, 179, 200);
+    g->style.colors[ColorStyle_BoxSelector] = IM_COL32(82, 82, 161, 100);
+    g->style.colors[ColorStyle_BoxSelectorOutline] = IM_COL32(82, 82, 161, 255);
+    g->style.colors[ColorStyle_GridBackground] = IM_COL32(40, 40, 50, 200);
+    g->style.colors[ColorStyle_GridLine] = IM_COL32(200, 200, 200, 40);
+    g->style.colors[ColorStyle_MiniMapBackground] = IM_COL32(25, 25, 25, 150);
+    g->style.colors[ColorStyle_MiniMapOutline] = IM_COL32(150, 150, 150, 100);
+    g->style.colors[ColorStyle_MiniMapNode] = IM_COL32(200, 200, 200, 255);
+    g->style.colors[ColorStyle_MiniMapLink] = IM_COL32(255, 255, 255, 100);
+    g->style.colors[ColorStyle_MiniMapViewport] = IM_COL32(82, 82, 161, 50);
 }
 
 void StyleColorsLight()
 {
-    g.style.colors[ColorStyle_NodeBackground] = IM_COL32(240, 240, 240, 255);
-    g.style.colors[ColorStyle_NodeBackgroundHovered] =
+    g->style.colors[ColorStyle_NodeBackground] = IM_COL32(240, 240, 240, 255);
+    g->style.colors[ColorStyle_NodeBackgroundHovered] =
         IM_COL32(240, 240, 240, 255);
-    g.style.colors[ColorStyle_NodeBackgroundSelected] =
+    g->style.colors[ColorStyle_NodeBackgroundSelected] =
         IM_COL32(240, 240, 240, 255);
-    g.style.colors[ColorStyle_NodeOutline] = IM_COL32(100, 100, 100, 255);
-    g.style.colors[ColorStyle_TitleBar] = IM_COL32(248, 248, 248, 255);
-    g.style.colors[ColorStyle_TitleBarHovered] = IM_COL32(209, 209, 209, 255);
-    g.style.colors[ColorStyle_TitleBarSelected] = IM_COL32(209, 209, 209, 255);
+    g->style.colors[ColorStyle_NodeOutline] = IM_COL32(100, 100, 100, 255);
+    g->style.colors[ColorStyle_TitleBar] = IM_COL32(248, 248, 248, 255);
+    g->style.colors[ColorStyle_TitleBarHovered] = IM_COL32(209, 209, 209, 255);
+    g->style.colors[ColorStyle_TitleBarSelected] = IM_COL32(209, 209, 209, 255);
     // original imgui values: 66, 150, 250
-    g.style.colors[ColorStyle_Link] = IM_COL32(66, 150, 250, 100);
+    g->style.colors[ColorStyle_Link] = IM_COL32(66, 150, 250, 100);
     // original imgui values: 117, 138, 204
-    g.style.colors[ColorStyle_LinkHovered] = IM_COL32(66, 150, 250, 242);
-    g.style.colors[ColorStyle_LinkSelected] = IM_COL32(66, 150, 250, 242);
+    g->style.colors[ColorStyle_LinkHovered] = IM_COL32(66, 150, 250, 242);
+    g->style.colors[ColorStyle_LinkSelected] = IM_COL32(66, 150, 250, 242);
     // original imgui values: 66, 150, 250
-    g.style.colors[ColorStyle_Pin] = IM_COL32(66, 150, 250, 160);
-    g.style.colors[ColorStyle_PinHovered] = IM_COL32(66, 150, 250, 255);
-    g.style.colors[ColorStyle_BoxSelector] = IM_COL32(90, 170, 250, 30);
-    g.style.colors[ColorStyle_BoxSelectorOutline] = IM_COL32(90, 170, 250, 150);
-    g.style.colors[ColorStyle_GridBackground] = IM_COL32(225, 225, 225, 255);
-    g.style.colors[ColorStyle_GridLine] = IM_COL32(180, 180, 180, 100);
-    g.style.flags = StyleFlags(StyleFlags_None);
+    g->style.colors[ColorStyle_Pin] = IM_COL32(66, 150, 250, 160);
+    g->style.colors[ColorStyle_PinHovered] = IM_COL32(66, 150, 250, 255);
+    g->style.colors[ColorStyle_BoxSelector] = IM_COL32(90, 170, 250, 30);
+    g->style.colors[ColorStyle_BoxSelectorOutline] =
+        IM_COL32(90, 170, 250, 150);
+    g->style.colors[ColorStyle_GridBackground] = IM_COL32(225, 225, 225, 255);
+    g->style.colors[ColorStyle_GridLine] = IM_COL32(180, 180, 180, 100);
+    g->style.colors[ColorStyle_MiniMapBackground] = IM_COL32(25, 25, 25, 100);
+    g->style.colors[ColorStyle_MiniMapOutline] = IM_COL32(150, 150, 150, 100);
+    g->style.colors[ColorStyle_MiniMapNode] = IM_COL32(200, 200, 200, 255);
+    g->style.colors[ColorStyle_MiniMapLink] = IM_COL32(66, 150, 250, 100);
+    g->style.colors[ColorStyle_MiniMapViewport] = IM_COL32(90, 170, 250, 30);
+    g->style.flags = StyleFlags(StyleFlags_None);
 }
 
 void BeginNodeEditor()
 {
-    // Remember to call Initialize() before calling BeginNodeEditor()
-    assert(initialized);
-    assert(g.current_scope == Scope_None);
-    g.current_scope = Scope_Editor;
+    // Remember to create a context before calling BeginNodeEditor()
+    assert(g != NULL);
+    assert(g->current_scope == Scope_None);
+    g->current_scope = Scope_Editor;
+    IMNODES_STAT(g->stats = FrameStats());
+    IMNODES_STAT(const double update_begin = get_time_ms());
+    begin_trace_capture_frame();
+    begin_profile_zone("node_editor");
 
     // Reset state from previous pass
 
-    g.hovered_node_idx.reset();
-    g.hovered_link_idx.reset();
-    g.hovered_pin_idx.reset();
-    g.hovered_pin_flags = AttributeFlags_None;
-    g.active_pin_idx.reset();
-    g.deleted_link_idx.reset();
+    g->hovered_node_idx.reset();
+    g->hovered_link_idx.reset();
+    g->hovered_pin_idx.reset();
+    g->hovered_pin_flags = AttributeFlags_None;
+    g->active_pin_idx.reset();
+    g->deleted_link_idx.reset();
+
+    g->element_state_change = ElementStateChange_None;
+    g->content_bounds = ImRect(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
 
-    g.element_state_change = ElementStateChange_None;
+    g->node_styles.reset();
+    g->pin_styles.reset();
+    g->link_styles.reset();
+    g->pin_indices.resize(0);
 
     // reset ui content for the current editor
     EditorContext& editor = editor_context_get();
-    editor.nodes.update();
-    editor.pins.update();
-    editor.links.update();
+    {
+        const ProfileZone zone("ObjectPool::update");
+        editor.nodes.update();
+        editor.pins.update();
+        editor.links.update();
+    }
+
+    // The minimap's bins are only kept up to date while the minimap is shown.
+    if (!editor.minimap.shown)
+    {
+        reset_minimap(editor.minimap);
+    }
+    else if (!editor.minimap.dirty)
+    {
+        remove_freed_minimap_elements(editor);
+    }
+
+    force_layout_update(editor);
 
     ImGui::BeginGroup();
     {
         ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(1.f, 1.f));
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.f, 0.f));
         ImGui::PushStyleColor(
-            ImGuiCol_ChildBg, g.style.colors[ColorStyle_GridBackground]);
+            ImGuiCol_ChildBg, g->style.colors[ColorStyle_GridBackground]);
         ImGui::BeginChild(
             "scrolling_region",
             ImVec2(0.f, 0.f),
             true,
             ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoMove |
                 ImGuiWindowFlags_NoScrollWithMouse);
-        g.canvas_origin_screen_space = ImGui::GetCursorScreenPos();
+        g->canvas_origin_screen_space = ImGui::GetCursorScreenPos();
+        g->zoomed_out = editor.zoom < g->style.detail_zoom_threshold;
+        // The node contents are scaled along with the grid.
+        ImGui::SetWindowFontScale(editor.zoom);
 
         // NOTE: we have to fetch the canvas draw list *after* we call
         // BeginChild(), otherwise the ImGui UI elements are going to be
         // rendered into the parent window draw list.
-        g.canvas_draw_list = ImGui::GetWindowDrawList();
+        g->canvas_draw_list = ImGui::GetWindowDrawList();
+        reserve_canvas_draw_list(editor);
+        validate_node_geometry_cache(editor.node_geometry);
+
+        restore_node_geometry(editor);
 
         {
             const ImVec2 canvas_size = ImGui::GetWindowSize();
-            g.canvas_rect_screen_space = ImRect(
+            g->canvas_rect_screen_space = ImRect(
                 editor_space_to_screen_space(ImVec2(0.f, 0.f)),
                 editor_space_to_screen_space(canvas_size));
 
-            if (g.style.flags & StyleFlags_GridLines)
+            if (g->style.flags & StyleFlags_GridLines)
             {
                 draw_grid(editor, canvas_size);
             }
         }
+
+        // The minimap is hovered if the mouse is over the space which it took
+        // up during the last frame.
+        g->minimap_hovered =
+            editor.minimap.shown && ImGui::IsWindowHovered() &&
+            editor.minimap.screen_rect.Contains(ImGui::GetMousePos());
+        editor.minimap.shown = false;
     }
+
+    IMNODES_STAT(g->stats.update_ms = get_time_ms() - update_begin);
 }
 
 void EndNodeEditor()
 {
-    assert(g.current_scope == Scope_Editor);
-    g.current_scope = Scope_None;
+    assert(g->current_scope == Scope_Editor);
+    g->current_scope = Scope_None;
 
     EditorContext& editor = editor_context_get();
 
     const bool is_left_mouse_clicked = ImGui::IsMouseClicked(0);
     const bool is_middle_mouse_clicked = ImGui::IsMouseClicked(2);
+    IMNODES_STAT(const double draw_begin = get_time_ms());
 
-    for (int link_idx = 0; link_idx < editor.links.pool.size(); ++link_idx)
+    // Zoomed out, the links are straight lines, and aren't routed.
+    if ((g->style.flags & StyleFlags_OrthogonalLinks) && !g->zoomed_out)
     {
-        if (editor.links.in_use[link_idx])
+        const ProfileZone zone("update_link_routes");
+        update_link_routes(editor);
+    }
+
+    {
+        const ProfileZone zone("draw_links");
+        const IO::ParallelFor& parallel_for = g->io.parallel_for;
+        if (parallel_for.run != NULL &&
+            editor.links.pool.size() >= parallel_for.min_elements)
         {
-            draw_link(editor, link_idx);
+            draw_links_parallel(editor);
+        }
+        else
+        {
+            for (int link_idx = 0; link_idx < editor.links.pool.size();
+                 ++link_idx)
+            {
+                if (editor.links.in_use[link_idx])
+                {
+                    draw_link(editor, link_idx);
+                }
+            }
         }
     }
 
+    if (editor.minimap.shown)
+    {
+        draw_minimap(editor);
+    }
+
+    IMNODES_STAT(g->stats.draw_ms += get_time_ms() - draw_begin);
+    IMNODES_STAT(const double interaction_begin = get_time_ms());
+
     if (is_left_mouse_clicked || is_middle_mouse_clicked)
     {
         begin_canvas_interaction(editor);
@@ -1698,6 +7982,12 @@ void EndNodeEditor()
 
     click_interaction_update(editor);
 
+    IMNODES_STAT(g->stats.interaction_ms = get_time_ms() - interaction_begin);
+
+    update_view_bounds(editor);
+    IMNODES_STAT(end_frame_stats(editor));
+    record_canvas_draw_list_size(editor);
+
     // pop style
     ImGui::EndChild();      // end scrolling region
     ImGui::PopStyleColor(); // pop child window background color
@@ -1705,298 +7995,680 @@ void EndNodeEditor()
     ImGui::PopStyleVar();   // pop frame padding
     ImGui::EndGroup();
 
-    for (int idx = 0; idx < editor.nodes.pool.size(); idx++)
-    {
-        NodeData& node = editor.nodes.pool[idx];
-        node.pin_indices.clear();
-    }
+    end_profile_zone("node_editor");
+    end_trace_capture_frame();
+}
+
+void MiniMap(const float size_fraction, const MiniMapLocation location)
+{
+    assert(g->current_scope == Scope_Editor);
+    // The minimap has to fit inside of the canvas.
+    assert(size_fraction > 0.f && size_fraction <= 1.f);
+
+    MiniMapSummary& minimap = editor_context_get().minimap;
+    minimap.shown = true;
+    minimap.size_fraction = size_fraction;
+    minimap.location = location;
 }
 
 void BeginNode(const int node_id)
 {
     // Remember to call BeginNodeEditor before calling BeginNode
-    assert(g.current_scope == Scope_Editor);
-    g.current_scope = Scope_Node;
+    assert(g->current_scope == Scope_Editor);
+    g->current_scope = Scope_Node;
 
     EditorContext& editor = editor_context_get();
+    // The node is in a collapsed group. Skip submitting it while
+    // IsNodeCollapsed() returns true.
+    assert(
+        editor.node_groups.members.empty() ||
+        editor.node_groups.member_ids.GetInt(node_id, -1) == -1);
 
-    const int node_idx = editor.nodes.find_or_create_index_for(node_id);
-    g.current_node_idx = node_idx;
+    const int node_idx = find_or_create_node_index(editor, node_id);
+    g->current_node_idx = node_idx;
+
+    NodeData& node = editor.nodes.pool[node_idx];
+    node.id = node_id;
+    node.pin_index_begin = g->pin_indices.size();
+    node.pin_index_end = node.pin_index_begin;
+    NodeStyle style;
+    style.background = g->style.colors[ColorStyle_NodeBackground];
+    style.background_hovered =
+        g->style.colors[ColorStyle_NodeBackgroundHovered];
+    style.background_selected =
+        g->style.colors[ColorStyle_NodeBackgroundSelected];
+    style.outline = g->style.colors[ColorStyle_NodeOutline];
+    style.titlebar = g->style.colors[ColorStyle_TitleBar];
+    style.titlebar_hovered = g->style.colors[ColorStyle_TitleBarHovered];
+    style.titlebar_selected = g->style.colors[ColorStyle_TitleBarSelected];
+    style.corner_rounding = g->style.node_corner_rounding * editor.zoom;
+    style.padding = ImVec2(
+        g->style.node_padding_horizontal * editor.zoom,
+        g->style.node_padding_vertical * editor.zoom);
+    node.style_idx = g->node_styles.intern(style);
+
+    if (g->zoomed_out)
+    {
+        // The node's contents aren't drawn. Any widgets which are still
+        // submitted are clipped away, which also keeps them from drawing.
+        const ImVec2 clip_pos = g->canvas_rect_screen_space.Min;
+        ImGui::PushID(node.id);
+        ImGui::PushClipRect(clip_pos, clip_pos, true);
+        return;
+    }
+
+    // ImGui::SetCursorPos sets the cursor position, local to the current widget
+    // (in this case, the child object started in BeginNodeEditor). Use
+    // ImGui::SetCursorScreenPos to set the screen space coordinates directly.
+    ImGui::SetCursorPos(
+        grid_space_to_editor_space(get_node_title_bar_origin(node)));
+
+    g->canvas_draw_list->ChannelsSplit(Channels_Count);
+    g->canvas_draw_list->ChannelsSetCurrent(Channels_ImGui);
+
+    ImGui::PushID(node.id);
+    ImGui::BeginGroup();
+}
+
+void EndNode()
+{
+    assert(g->current_scope == Scope_Node);
+    g->current_scope = Scope_Editor;
+    IMNODES_STAT(++g->stats.nodes_submitted);
+
+    EditorContext& editor = editor_context_get();
+    const int group_idx =
+        find_node_group(editor, editor.nodes.pool[g->current_node_idx].id);
+
+    if (g->zoomed_out)
+    {
+        ImGui::PopClipRect();
+        ImGui::PopID();
+        IMNODES_STAT(const double draw_begin = get_time_ms());
+        update_zoomed_out_node(editor, g->current_node_idx);
+        if (group_idx != -1)
+        {
+            submit_node_group_proxy_pins(editor, group_idx);
+        }
+        draw_zoomed_out_node(editor, g->current_node_idx);
+        IMNODES_STAT(g->stats.draw_ms += get_time_ms() - draw_begin);
+        end_node_bounds(editor);
+        return;
+    }
+
+    // Makes room for the proxy pins of a group node.
+    if (group_idx != -1)
+    {
+        const int num_rows =
+            count_node_group_proxy_rows(editor.node_groups, group_idx);
+        ImGui::Dummy(ImVec2(
+            0.f,
+            ImGui::GetTextLineHeightWithSpacing() *
+                static_cast<float>(num_rows)));
+    }
+
+    // The node's rectangle depends on the ImGui UI group size.
+    ImGui::EndGroup();
+    ImGui::PopID();
+    {
+        NodeData& node = editor.nodes.pool[g->current_node_idx];
+        ImRect& node_rect = editor.node_rects[g->current_node_idx];
+        node_rect = get_item_rect();
+        node_rect.Expand(get_node_style(node).padding);
+        node.grid_space_size = node_rect.GetSize() / editor.zoom;
+    }
+
+    if (group_idx != -1)
+    {
+        submit_node_group_proxy_pins(editor, group_idx);
+    }
+
+    IMNODES_STAT(const double draw_begin = get_time_ms());
+    g->canvas_draw_list->ChannelsSetCurrent(Channels_NodeBackground);
+    draw_node(editor, g->current_node_idx);
+    g->canvas_draw_list->ChannelsMerge();
+    IMNODES_STAT(g->stats.draw_ms += get_time_ms() - draw_begin);
+
+    end_node_bounds(editor);
+}
+
+void BeginNodeTitleBar()
+{
+    assert(g->current_scope == Scope_Node);
+    if (!g->zoomed_out)
+    {
+        ImGui::BeginGroup();
+    }
+}
+
+void EndNodeTitleBar()
+{
+    assert(g->current_scope == Scope_Node);
+    if (g->zoomed_out)
+    {
+        return;
+    }
+
+    ImGui::EndGroup();
+
+    EditorContext& editor = editor_context_get();
+    NodeData& node = editor.nodes.pool[g->current_node_idx];
+    node.title_bar_content_rect = get_item_rect();
+
+    ImGui::SetCursorPos(
+        grid_space_to_editor_space(get_node_content_origin(node)));
+}
+
+void BeginInputAttribute(const int id, const PinShape shape)
+{
+    begin_attribute(id, AttributeType_Input, shape, g->current_node_idx);
+}
+
+void BeginOutputAttribute(const int id, const PinShape shape)
+{
+    begin_attribute(id, AttributeType_Output, shape, g->current_node_idx);
+}
+
+void EndAttribute()
+{
+    assert(g->current_scope == Scope_Attribute);
+    g->current_scope = Scope_Node;
+
+    ImGui::PopID();
+
+    EditorContext& editor = editor_context_get();
+    PinData& pin = editor.pins.pool[g->current_pin_idx];
+    NodeData& node = editor.nodes.pool[g->current_node_idx];
+    g->pin_indices.push_back(g->current_pin_idx);
+    node.pin_index_end = g->pin_indices.size();
+    IMNODES_STAT(++g->stats.pins_submitted);
+
+    // Zoomed out, the attribute rect is moved along with the node instead.
+    if (g->zoomed_out)
+    {
+        return;
+    }
+
+    ImGui::EndGroup();
+
+    if (ImGui::IsItemActive())
+    {
+        g->active_pin_idx = g->current_pin_idx;
+    }
+
+    pin.attribute_rect = get_item_rect();
+}
+
+void PushAttributeFlag(AttributeFlags flag)
+{
+    g->current_attribute_flags |= static_cast<int>(flag);
+    g->attribute_flag_stack.push_back(g->current_attribute_flags);
+}
+
+void PopAttributeFlag()
+{
+    // PopAttributeFlag called without a matching PushAttributeFlag!
+    // The bottom value is always the default value, pushed in
+    // CreateContext().
+    assert(g->attribute_flag_stack.size() > 1);
+
+    g->attribute_flag_stack.pop_back();
+    g->current_attribute_flags = g->attribute_flag_stack.back();
+}
+
+void Link(int id, const int start_attr_id, const int end_attr_id)
+{
+    assert(g->current_scope == Scope_Editor);
+
+    EditorContext& editor = editor_context_get();
+    if (!editor.node_groups.groups.empty() &&
+        !is_node_group_link_shown(
+            editor.node_groups, start_attr_id, end_attr_id))
+    {
+        return;
+    }
+
+    const int link_idx = editor.links.find_or_create_index_for(id);
+    LinkData& link = editor.links.pool[link_idx];
+    link.id = id;
+    link.start_pin_idx = find_or_create_pin_index(editor, start_attr_id);
+    link.end_pin_idx = find_or_create_pin_index(editor, end_attr_id);
+    LinkStyle style;
+    style.base = g->style.colors[ColorStyle_Link];
+    style.hovered = g->style.colors[ColorStyle_LinkHovered];
+    style.selected = g->style.colors[ColorStyle_LinkSelected];
+    link.style_idx = g->link_styles.intern(style);
+    IMNODES_STAT(++g->stats.links_submitted);
+
+    if (!editor.minimap.dirty)
+    {
+        update_minimap_link(editor, link_idx);
+    }
+}
+
+void PushColorStyle(ColorStyle item, unsigned int color)
+{
+    // Remember to create a context before using any other functions!
+    assert(g != NULL);
+    g->color_modifier_stack.push_back(
+        ColorStyleElement(g->style.colors[item], item));
+    g->style.colors[item] = color;
+}
+
+void PopColorStyle()
+{
+    assert(g->color_modifier_stack.size() > 0);
+    const ColorStyleElement elem = g->color_modifier_stack.back();
+    g->style.colors[elem.item] = elem.color;
+    g->color_modifier_stack.pop_back();
+}
+
+float& lookup_style_var(const StyleVar item)
+{
+    // TODO: once the switch gets too big and unwieldy to work with, we could do
+    // a byte-offset lookup into the Style struct, using the StyleVar as an
+    // index. This is how ImGui does it.
+    float* style_var = 0;
+    switch (item)
+    {
+    case StyleVar_GridSpacing:
+        style_var = &g->style.grid_spacing;
+        break;
+    case StyleVar_NodeCornerRounding:
+        style_var = &g->style.node_corner_rounding;
+        break;
+    case StyleVar_NodePaddingHorizontal:
+        style_var = &g->style.node_padding_horizontal;
+        break;
+    case StyleVar_NodePaddingVertical:
+        style_var = &g->style.node_padding_vertical;
+        break;
+    default:
+        assert(!"Invalid StyleVar value!");
+    }
+
+    return *style_var;
+}
+
+void PushStyleVar(const StyleVar item, const float value)
+{
+    float& style_var = lookup_style_var(item);
+    g->style_modifier_stack.push_back(StyleElement(style_var, item));
+    style_var = value;
+}
+
+void PopStyleVar()
+{
+    assert(g->style_modifier_stack.size() > 0);
+    const StyleElement style_elem = g->style_modifier_stack.back();
+    g->style_modifier_stack.pop_back();
+    float& style_var = lookup_style_var(style_elem.item);
+    style_var = style_elem.value;
+}
+
+void SetNodeScreenSpacePos(int node_id, const ImVec2& screen_space_pos)
+{
+    // Remember to create a context before using any other functions!
+    assert(g != NULL);
+    EditorContext& editor = editor_context_get();
+    NodeData& node =
+        editor.nodes.pool[find_or_create_node_index(editor, node_id)];
+    node.origin = screen_space_to_grid_space(screen_space_pos);
+}
+
+void SetNodeGridSpacePos(int node_id, const ImVec2& grid_pos)
+{
+    // Remember to create a context before using any other functions!
+    assert(g != NULL);
+    EditorContext& editor = editor_context_get();
+    NodeData& node =
+        editor.nodes.pool[find_or_create_node_index(editor, node_id)];
+    node.origin = grid_pos;
+}
+
+ImVec2 GetNodeGridSpacePos(int node_id)
+{
+    assert(g != NULL);
+    const EditorContext& editor = editor_context_get();
+    const int node_idx = editor.nodes.id_map.GetInt(node_id, -1);
+    assert(node_idx != -1);
+    return editor.nodes.pool[node_idx].origin;
+}
+
+ImVec2 GetNodeDimensions(int node_id)
+{
+    assert(g != NULL);
+    const EditorContext& editor = editor_context_get();
+    const int node_idx = editor.nodes.id_map.GetInt(node_id, -1);
+    assert(node_idx != -1);
+    return editor.nodes.pool[node_idx].grid_space_size;
+}
+
+void SetNodeDraggable(int node_id, const bool draggable)
+{
+    assert(g != NULL);
+    EditorContext& editor = editor_context_get();
+    NodeData& node =
+        editor.nodes.pool[find_or_create_node_index(editor, node_id)];
+    node.draggable = draggable;
+}
+
+FrameStats::FrameStats()
+    : nodes_submitted(0), nodes_culled(0), nodes_drawn(0), pins_submitted(0),
+      pins_culled(0), pins_drawn(0), links_submitted(0), links_culled(0),
+      links_drawn(0), hover_bezier_segments(0), render_bezier_segments(0),
+      node_pool_size(0), node_free_list_size(0), pin_pool_size(0),
+      pin_free_list_size(0), link_pool_size(0), link_free_list_size(0),
+      canvas_vertices(0), canvas_indices(0), update_ms(0.0), draw_ms(0.0),
+      interaction_ms(0.0)
+{
+}
 
-    NodeData& node = editor.nodes.pool[node_idx];
-    node.id = node_id;
-    node.color_style.background = g.style.colors[ColorStyle_NodeBackground];
-    node.color_style.background_hovered =
-        g.style.colors[ColorStyle_NodeBackgroundHovered];
-    node.color_style.background_selected =
-        g.style.colors[ColorStyle_NodeBackgroundSelected];
-    node.color_style.outline = g.style.colors[ColorStyle_NodeOutline];
-    node.color_style.titlebar = g.style.colors[ColorStyle_TitleBar];
-    node.color_style.titlebar_hovered =
-        g.style.colors[ColorStyle_TitleBarHovered];
-    node.color_style.titlebar_selected =
-        g.style.colors[ColorStyle_TitleBarSelected];
-    node.layout_style.corner_rounding = g.style.node_corner_rounding;
-    node.layout_style.padding =
-        ImVec2(g.style.node_padding_horizontal, g.style.node_padding_vertical);
+const FrameStats& GetFrameStats()
+{
+    assert(g != NULL);
+    return g->stats;
+}
 
-    // ImGui::SetCursorPos sets the cursor position, local to the current widget
-    // (in this case, the child object started in BeginNodeEditor). Use
-    // ImGui::SetCursorScreenPos to set the screen space coordinates directly.
-    ImGui::SetCursorPos(
-        grid_space_to_editor_space(get_node_title_bar_origin(node)));
+PoolMemoryStats::PoolMemoryStats()
+    : live(0), slots(0), capacity(0), high_water_mark(0), live_bytes(0),
+      capacity_bytes(0)
+{
+}
 
-    g.canvas_draw_list->ChannelsSplit(Channels_Count);
-    g.canvas_draw_list->ChannelsSetCurrent(Channels_ImGui);
+EditorMemoryReport::EditorMemoryReport()
+    : nodes(), pins(), links(), other_bytes(0), total_bytes(0)
+{
+}
 
-    ImGui::PushID(node.id);
-    ImGui::BeginGroup();
+EditorMemoryReport GetCurrentEditorMemoryReport()
+{
+    return GetEditorMemoryReport(&editor_context_get());
 }
 
-void EndNode()
+EditorMemoryReport GetEditorMemoryReport(const EditorContext* const editor)
 {
-    assert(g.current_scope == Scope_Node);
-    g.current_scope = Scope_Editor;
+    assert(editor != NULL);
+
+    EditorMemoryReport report;
+    report.nodes = get_pool_memory_stats(editor->nodes);
+    report.pins = get_pool_memory_stats(editor->pins);
+    report.links = get_pool_memory_stats(editor->links);
+    // The geometry which is stored next to the pools counts towards them.
+    report.nodes.live_bytes +=
+        static_cast<size_t>(report.nodes.live) * sizeof(ImRect);
+    report.nodes.capacity_bytes += vector_bytes(editor->node_rects);
+    report.pins.live_bytes +=
+        static_cast<size_t>(report.pins.live) * sizeof(ImVec2);
+    report.pins.capacity_bytes += vector_bytes(editor->pin_positions);
+
+    report.other_bytes =
+        vector_bytes(editor->selected_node_indices) +
+        vector_bytes(editor->selected_link_indices) +
+        vector_bytes(editor->layout.node_layers.pairs) +
+        vector_bytes(editor->layout.layer_xs) +
+        vector_bytes(editor->stopped_force_layouts) +
+        link_router_bytes(editor->link_router) +
+        minimap_bytes(editor->minimap) + vector_bytes(editor->grid.vertices) +
+        vector_bytes(editor->grid.indices) +
+        vector_bytes(editor->node_geometry.nodes) +
+        vector_bytes(editor->node_geometry.vertices) +
+        vector_bytes(editor->node_geometry.indices) +
+        node_groups_bytes(editor->node_groups);
+
+    report.total_bytes = sizeof(EditorContext) + report.nodes.capacity_bytes +
+                         report.pins.capacity_bytes +
+                         report.links.capacity_bytes + report.other_bytes;
+    return report;
+}
 
-    EditorContext& editor = editor_context_get();
+void CompactCurrentEditor() { CompactEditor(&editor_context_get()); }
 
-    // The node's rectangle depends on the ImGui UI group size.
-    ImGui::EndGroup();
-    ImGui::PopID();
+void CompactEditor(EditorContext* const editor)
+{
+    assert(g->current_scope == Scope_None);
+    assert(editor != NULL);
+    // An arena only gives its memory back when the editor is freed, so the
+    // compacted copies would only add to it.
+    if (editor->allocator.alloc == arena_alloc)
     {
-        NodeData& node = editor.nodes.pool[g.current_node_idx];
-        node.rect = get_item_rect();
-        node.rect.Expand(node.layout_style.padding);
+        return;
     }
-
-    g.canvas_draw_list->ChannelsSetCurrent(Channels_NodeBackground);
-    draw_node(editor, g.current_node_idx);
-    g.canvas_draw_list->ChannelsMerge();
+    compact_editor(*editor);
 }
 
-void BeginNodeTitleBar()
+void StartTraceCapture(
+    const char* const file_name,
+    const int num_frames,
+    const int skip_frames)
 {
-    assert(g.current_scope == Scope_Node);
-    ImGui::BeginGroup();
+    assert(g != NULL);
+    assert(file_name != NULL);
+    assert(num_frames > 0 && skip_frames >= 0);
+    // A capture is already running!
+    assert(g->trace_capture.frames_left == 0);
+
+    TraceCapture& capture = g->trace_capture;
+    capture.file_name.resize(int(strlen(file_name)) + 1);
+    memcpy(capture.file_name.Data, file_name, capture.file_name.size());
+    capture.frames_to_skip = skip_frames;
+    capture.frames_left = num_frames;
 }
 
-void EndNodeTitleBar()
+bool IsTraceCaptureRunning()
 {
-    assert(g.current_scope == Scope_Node);
-    ImGui::EndGroup();
-
-    EditorContext& editor = editor_context_get();
-    NodeData& node = editor.nodes.pool[g.current_node_idx];
-    node.title_bar_content_rect = get_item_rect();
-
-    ImGui::SetCursorPos(
-        grid_space_to_editor_space(get_node_content_origin(node)));
+    assert(g != NULL);
+    return g->trace_capture.frames_left > 0;
 }
 
-void BeginInputAttribute(const int id, const PinShape shape)
+LayoutOptions::LayoutOptions()
+    : layer_spacing(80.f), node_spacing(20.f), iterations(8)
 {
-    begin_attribute(id, AttributeType_Input, shape, g.current_node_idx);
 }
 
-void BeginOutputAttribute(const int id, const PinShape shape)
+void LayoutCurrentEditor(const LayoutOptions& options)
 {
-    begin_attribute(id, AttributeType_Output, shape, g.current_node_idx);
+    assert(g->current_scope == Scope_None);
+    layout_editor(editor_context_get(), options, false);
 }
 
-void EndAttribute()
+void LayoutEditor(EditorContext* editor, const LayoutOptions& options)
 {
-    assert(g.current_scope == Scope_Attribute);
-    g.current_scope = Scope_Node;
-
-    ImGui::PopID();
-    ImGui::EndGroup();
+    assert(editor != NULL);
+    layout_editor(*editor, options, false);
+}
 
-    if (ImGui::IsItemActive())
-    {
-        g.active_pin_idx = g.current_pin_idx;
-    }
+void UpdateCurrentEditorLayout(const LayoutOptions& options)
+{
+    assert(g->current_scope == Scope_None);
+    layout_editor(editor_context_get(), options, true);
+}
 
-    EditorContext& editor = editor_context_get();
-    PinData& pin = editor.pins.pool[g.current_pin_idx];
-    NodeData& node = editor.nodes.pool[g.current_node_idx];
-    pin.attribute_rect = get_item_rect();
-    node.pin_indices.push_back(g.current_pin_idx);
+void UpdateEditorLayout(EditorContext* editor, const LayoutOptions& options)
+{
+    assert(editor != NULL);
+    layout_editor(*editor, options, true);
 }
 
-void PushAttributeFlag(AttributeFlags flag)
+ForceLayoutOptions::ForceLayoutOptions()
+    : link_length(60.f), theta(0.75f), max_iterations(300)
 {
-    g.current_attribute_flags |= static_cast<int>(flag);
-    g.attribute_flag_stack.push_back(g.current_attribute_flags);
 }
 
-void PopAttributeFlag()
+void StartCurrentEditorForceLayout(const ForceLayoutOptions& options)
 {
-    // PopAttributeFlag called without a matching PushAttributeFlag!
-    // The bottom value is always the default value, pushed in Initialize().
-    assert(g.attribute_flag_stack.size() > 1);
+    assert(g->current_scope == Scope_None);
+    force_layout_start(editor_context_get(), options);
+}
 
-    g.attribute_flag_stack.pop_back();
-    g.current_attribute_flags = g.attribute_flag_stack.back();
+void StartEditorForceLayout(
+    EditorContext* editor,
+    const ForceLayoutOptions& options)
+{
+    assert(editor != NULL);
+    force_layout_start(*editor, options);
 }
 
-void Link(int id, const int start_attr_id, const int end_attr_id)
+void StopCurrentEditorForceLayout()
 {
-    assert(g.current_scope == Scope_Editor);
+    force_layout_stop(editor_context_get());
+}
 
-    EditorContext& editor = editor_context_get();
-    LinkData& link = editor.links.find_or_create_new(id);
-    link.id = id;
-    link.start_pin_idx = editor.pins.find_or_create_index_for(start_attr_id);
-    link.end_pin_idx = editor.pins.find_or_create_index_for(end_attr_id);
-    link.color_style.base = g.style.colors[ColorStyle_Link];
-    link.color_style.hovered = g.style.colors[ColorStyle_LinkHovered];
-    link.color_style.selected = g.style.colors[ColorStyle_LinkSelected];
+void StopEditorForceLayout(EditorContext* editor)
+{
+    assert(editor != NULL);
+    force_layout_stop(*editor);
 }
 
-void PushColorStyle(ColorStyle item, unsigned int color)
+bool IsCurrentEditorForceLayoutRunning()
 {
-    // Remember to call Initialize() before using any other functions!
-    assert(initialized);
-    g.color_modifier_stack.push_back(
-        ColorStyleElement(g.style.colors[item], item));
-    g.style.colors[item] = color;
+    return editor_context_get().force_layout != NULL;
 }
 
-void PopColorStyle()
+bool IsEditorForceLayoutRunning(const EditorContext* editor)
 {
-    assert(g.color_modifier_stack.size() > 0);
-    const ColorStyleElement elem = g.color_modifier_stack.back();
-    g.style.colors[elem.item] = elem.color;
-    g.color_modifier_stack.pop_back();
+    assert(editor != NULL);
+    return editor->force_layout != NULL;
 }
 
-float& lookup_style_var(const StyleVar item)
+void RemoveNodeOverlaps(
+    const int* const node_ids,
+    const int num_node_ids,
+    const float spacing)
 {
-    // TODO: once the switch gets too big and unwieldy to work with, we could do
-    // a byte-offset lookup into the Style struct, using the StyleVar as an
-    // index. This is how ImGui does it.
-    float* style_var = 0;
-    switch (item)
+    assert(g->current_scope == Scope_None);
+    assert(node_ids != NULL || num_node_ids == 0);
+
+    EditorContext& editor = editor_context_get();
+    OverlapRemoval state;
+    init_overlap_removal(editor, state);
+    for (int i = 0; i < num_node_ids; ++i)
     {
-    case StyleVar_GridSpacing:
-        style_var = &g.style.grid_spacing;
-        break;
-    case StyleVar_NodeCornerRounding:
-        style_var = &g.style.node_corner_rounding;
-        break;
-    case StyleVar_NodePaddingHorizontal:
-        style_var = &g.style.node_padding_horizontal;
-        break;
-    case StyleVar_NodePaddingVertical:
-        style_var = &g.style.node_padding_vertical;
-        break;
-    default:
-        assert(!"Invalid StyleVar value!");
+        const int node_idx = editor.nodes.id_map.GetInt(node_ids[i], -1);
+        if (node_idx != -1 && state.vertex_of_node[node_idx] != -1)
+        {
+            state.movable[state.vertex_of_node[node_idx]] = true;
+        }
     }
-
-    return *style_var;
+    remove_overlaps(editor, state, spacing);
 }
 
-void PushStyleVar(const StyleVar item, const float value)
+void RemoveSelectedNodeOverlaps(const float spacing)
 {
-    float& style_var = lookup_style_var(item);
-    g.style_modifier_stack.push_back(StyleElement(style_var, item));
-    style_var = value;
+    assert(g->current_scope == Scope_None);
+
+    EditorContext& editor = editor_context_get();
+    OverlapRemoval state;
+    init_overlap_removal(editor, state);
+    for (int i = 0; i < editor.selected_node_indices.size(); ++i)
+    {
+        const int node_idx = editor.selected_node_indices[i];
+        if (state.vertex_of_node[node_idx] != -1)
+        {
+            state.movable[state.vertex_of_node[node_idx]] = true;
+        }
+    }
+    remove_overlaps(editor, state, spacing);
 }
 
-void PopStyleVar()
+void CollapseNodeGroup(
+    const int group_id,
+    const int* const node_ids,
+    const int num_node_ids)
 {
-    assert(g.style_modifier_stack.size() > 0);
-    const StyleElement style_elem = g.style_modifier_stack.back();
-    g.style_modifier_stack.pop_back();
-    float& style_var = lookup_style_var(style_elem.item);
-    style_var = style_elem.value;
+    assert(g->current_scope == Scope_None);
+    assert(node_ids != NULL && num_node_ids > 0);
+    collapse_node_group(editor_context_get(), group_id, node_ids, num_node_ids);
 }
 
-void SetNodeScreenSpacePos(int node_id, const ImVec2& screen_space_pos)
+void ExpandNodeGroup(const int group_id)
 {
-    // Remember to call Initialize() before using any other functions!
-    assert(initialized);
+    assert(g->current_scope == Scope_None);
     EditorContext& editor = editor_context_get();
-    NodeData& node = editor.nodes.find_or_create_new(node_id);
-    node.origin = screen_space_to_grid_space(screen_space_pos);
+    const int group_idx = find_node_group(editor, group_id);
+    // The group isn't collapsed.
+    assert(group_idx != -1);
+    expand_node_group(editor, group_idx);
 }
 
-void SetNodeGridSpacePos(int node_id, const ImVec2& grid_pos)
+bool IsNodeGroupCollapsed(const int group_id)
 {
-    // Remember to call Initialize() before using any other functions!
-    assert(initialized);
-    EditorContext& editor = editor_context_get();
-    NodeData& node = editor.nodes.find_or_create_new(node_id);
-    node.origin = grid_pos;
+    assert(g != NULL);
+    return find_node_group(editor_context_get(), group_id) != -1;
 }
 
-void SetNodeDraggable(int node_id, const bool draggable)
+bool IsNodeCollapsed(const int node_id)
 {
-    assert(initialized);
-    EditorContext& editor = editor_context_get();
-    NodeData& node = editor.nodes.find_or_create_new(node_id);
-    node.draggable = draggable;
+    assert(g != NULL);
+    const NodeGroups& groups = editor_context_get().node_groups;
+    return !groups.members.empty() &&
+           groups.member_ids.GetInt(node_id, -1) != -1;
+}
+
+bool IsEditorZoomedOut()
+{
+    assert(g->current_scope != Scope_None);
+    return g->zoomed_out;
 }
 
 bool IsEditorHovered()
 {
-    return g.canvas_rect_screen_space.Contains(ImGui::GetMousePos()) &&
+    return g->canvas_rect_screen_space.Contains(ImGui::GetMousePos()) &&
            ImGui::IsWindowHovered();
 }
 
 bool IsNodeHovered(int* const node_id)
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     assert(node_id != NULL);
 
-    const bool is_hovered = g.hovered_node_idx.has_value();
+    const bool is_hovered = g->hovered_node_idx.has_value();
     if (is_hovered)
     {
         const EditorContext& editor = editor_context_get();
-        *node_id = editor.nodes.pool[g.hovered_node_idx.value()].id;
+        *node_id = editor.nodes.pool[g->hovered_node_idx.value()].id;
     }
     return is_hovered;
 }
 
 bool IsLinkHovered(int* const link_id)
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     assert(link_id != NULL);
 
-    const bool is_hovered = g.hovered_link_idx.has_value();
+    const bool is_hovered = g->hovered_link_idx.has_value();
     if (is_hovered)
     {
         const EditorContext& editor = editor_context_get();
-        *link_id = editor.links.pool[g.hovered_link_idx.value()].id;
+        *link_id = editor.links.pool[g->hovered_link_idx.value()].id;
     }
     return is_hovered;
 }
 
 bool IsPinHovered(int* const attr)
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     assert(attr != NULL);
 
-    const bool is_hovered = g.hovered_pin_idx.has_value();
+    const bool is_hovered = g->hovered_pin_idx.has_value();
     if (is_hovered)
     {
         const EditorContext& editor = editor_context_get();
-        *attr = editor.pins.pool[g.hovered_pin_idx.value()].id;
+        *attr = editor.pins.pool[g->hovered_pin_idx.value()].id;
     }
     return is_hovered;
 }
 
 int NumSelectedNodes()
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     const EditorContext& editor = editor_context_get();
     return editor.selected_node_indices.size();
 }
 
 int NumSelectedLinks()
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     const EditorContext& editor = editor_context_get();
     return editor.selected_link_indices.size();
 }
@@ -2027,21 +8699,21 @@ void GetSelectedLinks(int* link_ids)
 
 bool IsAttributeActive()
 {
-    assert((g.current_scope & Scope_Node) != 0);
+    assert((g->current_scope & Scope_Node) != 0);
 
-    if (!g.active_pin_idx.has_value())
+    if (!g->active_pin_idx.has_value())
     {
         return false;
     }
 
-    return g.active_pin_idx == g.current_pin_idx;
+    return g->active_pin_idx == g->current_pin_idx;
 }
 
 bool IsAnyAttributeActive(int* const attribute_id)
 {
-    assert((g.current_scope & (Scope_Node | Scope_Attribute)) == 0);
+    assert((g->current_scope & (Scope_Node | Scope_Attribute)) == 0);
 
-    if (!g.active_pin_idx.has_value())
+    if (!g->active_pin_idx.has_value())
     {
         return false;
     }
@@ -2049,7 +8721,7 @@ bool IsAnyAttributeActive(int* const attribute_id)
     if (attribute_id != NULL)
     {
         const EditorContext& editor = editor_context_get();
-        *attribute_id = editor.pins.pool[g.active_pin_idx.value()].id;
+        *attribute_id = editor.pins.pool[g->active_pin_idx.value()].id;
     }
 
     return true;
@@ -2058,11 +8730,11 @@ bool IsAnyAttributeActive(int* const attribute_id)
 bool IsLinkStarted(int* const started_at_id)
 {
     // Call this function after EndNodeEditor()!
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     assert(started_at_id != NULL);
 
     const bool is_started =
-        (g.element_state_change & ElementStateChange_LinkStarted) != 0;
+        (g->element_state_change & ElementStateChange_LinkStarted) != 0;
     if (is_started)
     {
         const EditorContext& editor = editor_context_get();
@@ -2077,19 +8749,19 @@ bool IsLinkStarted(int* const started_at_id)
 bool IsLinkDropped()
 {
     // Call this function after EndNodeEditor()!
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
 
-    return (g.element_state_change & ElementStateChange_LinkDropped) != 0;
+    return (g->element_state_change & ElementStateChange_LinkDropped) != 0;
 }
 
 bool IsLinkCreated(int* const started_at_pin_id, int* const ended_at_pin_id)
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
     assert(started_at_pin_id != NULL);
     assert(ended_at_pin_id != NULL);
 
     const bool is_created =
-        (g.element_state_change & ElementStateChange_LinkCreated) != 0;
+        (g->element_state_change & ElementStateChange_LinkCreated) != 0;
 
     if (is_created)
     {
@@ -2107,37 +8779,339 @@ bool IsLinkCreated(int* const started_at_pin_id, int* const ended_at_pin_id)
 
 bool IsLinkDestroyed(int* const link_id)
 {
-    assert(g.current_scope == Scope_None);
+    assert(g->current_scope == Scope_None);
 
-    const bool link_destroyed = g.deleted_link_idx.has_value();
+    const bool link_destroyed = g->deleted_link_idx.has_value();
     if (link_destroyed)
     {
         const EditorContext& editor = editor_context_get();
-        const int link_idx = g.deleted_link_idx.value();
+        const int link_idx = g->deleted_link_idx.value();
         *link_id = editor.links.pool[link_idx].id;
     }
 
     return link_destroyed;
 }
 
+struct EditorStateSnapshot
+{
+    struct Node
+    {
+        int id;
+        ImVec2 origin;
+
+        // The following fields are only valid if the snapshot was captured
+        // with SaveFlags_NodeGeometry. The rects are relative to the node's
+        // top-left corner.
+        bool has_geometry;
+        ImVec2 size;
+        ImRect title_bar_content_rect;
+        int pin_begin, pin_count;
+    };
+
+    struct Pin
+    {
+        int id;
+        AttributeType type;
+        ImRect attribute_rect;
+    };
+
+    ImVec2 panning;
+    ImVector<Node> nodes;
+    ImVector<Pin> pins;
+
+    // Only used by SaveEditorStateSnapshotToIniFileAsync. The state is written
+    // by the worker thread once the save is complete.
+    char* file_name;
+    volatile int save_state;
+
+    EditorStateSnapshot()
+        : panning(0.f, 0.f), nodes(), pins(), file_name(NULL),
+          save_state(SnapshotSaveState_Idle)
+    {
+    }
+};
+
 namespace
 {
+void capture_snapshot(
+    const EditorContext& editor,
+    const SaveFlags flags,
+    EditorStateSnapshot& snapshot)
+{
+    snapshot.panning = editor.panning;
+
+    // Maps a node's pool index to its index in the snapshot.
+    ImVector<int> snapshot_node_indices;
+    snapshot_node_indices.resize(editor.nodes.pool.size(), -1);
+
+    int num_nodes = 0;
+    for (int i = 0; i < editor.nodes.in_use.size(); ++i)
+    {
+        if (editor.nodes.in_use[i])
+        {
+            snapshot_node_indices[i] = num_nodes++;
+        }
+    }
+    // The collapsed nodes come after the nodes in the pool.
+    const NodeGroups& groups = editor.node_groups;
+    snapshot.nodes.resize(num_nodes + groups.members.size());
+
+    for (int i = 0; i < editor.nodes.pool.size(); ++i)
+    {
+        if (snapshot_node_indices[i] == -1)
+        {
+            continue;
+        }
+
+        const NodeData& node = editor.nodes.pool[i];
+        const ImVec2& node_min = editor.node_rects[i].Min;
+        EditorStateSnapshot::Node& snapshot_node =
+            snapshot.nodes[snapshot_node_indices[i]];
+        snapshot_node.id = node.id;
+        snapshot_node.origin = node.origin;
+        // A node which hasn't been submitted yet doesn't have a measured rect.
+        snapshot_node.has_geometry = (flags & SaveFlags_NodeGeometry) != 0 &&
+                                     node.grid_space_size.x > 0.f;
+        // The geometry is saved in grid space units.
+        snapshot_node.size = node.grid_space_size;
+        snapshot_node.title_bar_content_rect = ImRect(
+            (node.title_bar_content_rect.Min - node_min) / editor.zoom,
+            (node.title_bar_content_rect.Max - node_min) / editor.zoom);
+        snapshot_node.pin_begin = 0;
+        snapshot_node.pin_count = 0;
+    }
+
+    // Their pins aren't kept, so they are saved without their geometry.
+    for (int i = 0; i < groups.members.size(); ++i)
+    {
+        EditorStateSnapshot::Node& snapshot_node =
+            snapshot.nodes[num_nodes + i];
+        snapshot_node.id = groups.members[i].node_id;
+        snapshot_node.origin = get_collapsed_node_origin(editor, i);
+        snapshot_node.has_geometry = false;
+        snapshot_node.size = groups.members[i].grid_space_size;
+        snapshot_node.title_bar_content_rect = ImRect();
+        snapshot_node.pin_begin = 0;
+        snapshot_node.pin_count = 0;
+    }
+
+    if ((flags & SaveFlags_NodeGeometry) == 0)
+    {
+        return;
+    }
+
+    // The pins are grouped by their parent node with a counting sort, since
+    // the nodes' pin ranges are only kept for the frame they were submitted
+    // in.
+
+    for (int i = 0; i < editor.pins.pool.size(); ++i)
+    {
+        if (editor.pins.in_use[i])
+        {
+            const int node_idx = snapshot_node_indices
+                [editor.pins.pool[i].parent_node_idx];
+            if (node_idx != -1 && snapshot.nodes[node_idx].has_geometry)
+            {
+                snapshot.nodes[node_idx].pin_count++;
+            }
+        }
+    }
+
+    int num_pins = 0;
+    for (int i = 0; i < snapshot.nodes.size(); ++i)
+    {
+        snapshot.nodes[i].pin_begin = num_pins;
+        num_pins += snapshot.nodes[i].pin_count;
+        snapshot.nodes[i].pin_count = 0;
+    }
+    snapshot.pins.resize(num_pins);
+
+    for (int i = 0; i < editor.pins.pool.size(); ++i)
+    {
+        if (!editor.pins.in_use[i])
+        {
+            continue;
+        }
+
+        const PinData& pin = editor.pins.pool[i];
+        const int node_idx = snapshot_node_indices[pin.parent_node_idx];
+        if (node_idx == -1 || !snapshot.nodes[node_idx].has_geometry)
+        {
+            continue;
+        }
+
+        EditorStateSnapshot::Node& snapshot_node = snapshot.nodes[node_idx];
+        EditorStateSnapshot::Pin& snapshot_pin =
+            snapshot.pins[snapshot_node.pin_begin + snapshot_node.pin_count++];
+        const ImVec2& node_min = editor.node_rects[pin.parent_node_idx].Min;
+        snapshot_pin.id = pin.id;
+        snapshot_pin.type = pin.type;
+        snapshot_pin.attribute_rect = ImRect(
+            (pin.attribute_rect.Min - node_min) / editor.zoom,
+            (pin.attribute_rect.Max - node_min) / editor.zoom);
+    }
+}
+
+// Writes into a FILE* with the same interface as ImGuiTextBuffer, so that the
+// string and file serializers can share format_snapshot.
+struct FileWriter
+{
+    FILE* file;
+
+    FileWriter(FILE* f) : file(f) {}
+
+    void appendf(const char* fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        vfprintf(file, fmt, args);
+        va_end(args);
+    }
+};
+
+template<typename Writer>
+void format_snapshot(const EditorStateSnapshot& snapshot, Writer& out)
+{
+    out.appendf(
+        "[editor]\npanning=%i,%i\n",
+        (int)snapshot.panning.x,
+        (int)snapshot.panning.y);
+
+    for (int i = 0; i < snapshot.nodes.size(); ++i)
+    {
+        const EditorStateSnapshot::Node& node = snapshot.nodes[i];
+        out.appendf("\n[node.%d]\n", node.id);
+        out.appendf("origin=%i,%i\n", (int)node.origin.x, (int)node.origin.y);
+
+        if (!node.has_geometry)
+        {
+            continue;
+        }
+
+        out.appendf("size=%i,%i\n", (int)node.size.x, (int)node.size.y);
+        out.appendf(
+            "title_bar=%i,%i,%i,%i\n",
+            (int)node.title_bar_content_rect.Min.x,
+            (int)node.title_bar_content_rect.Min.y,
+            (int)node.title_bar_content_rect.Max.x,
+            (int)node.title_bar_content_rect.Max.y);
+        for (int j = 0; j < node.pin_count; ++j)
+        {
+            const EditorStateSnapshot::Pin& pin =
+                snapshot.pins[node.pin_begin + j];
+            out.appendf(
+                "pin=%d,%d,%i,%i,%i,%i\n",
+                pin.id,
+                (int)pin.type,
+                (int)pin.attribute_rect.Min.x,
+                (int)pin.attribute_rect.Min.y,
+                (int)pin.attribute_rect.Max.x,
+                (int)pin.attribute_rect.Max.y);
+        }
+    }
+}
+
+// Like ImFileOpen(), which allocates through ImGui's allocator on Windows, so
+// that the snapshots can be written on any thread.
+FILE* open_snapshot_file(const char* const file_name)
+{
+#if defined(_WIN32) && !defined(IMGUI_DISABLE_WIN32_FUNCTIONS) &&              \
+    !defined(__CYGWIN__) && !defined(__GNUC__)
+    // fopen() doesn't handle UTF-8 file names on Windows.
+    const int size = MultiByteToWideChar(CP_UTF8, 0, file_name, -1, NULL, 0);
+    if (size <= 0)
+    {
+        return NULL;
+    }
+    wchar_t* const wide_file_name =
+        static_cast<wchar_t*>(malloc(sizeof(wchar_t) * size));
+    if (wide_file_name == NULL)
+    {
+        return NULL;
+    }
+    MultiByteToWideChar(CP_UTF8, 0, file_name, -1, wide_file_name, size);
+    FILE* const file = _wfopen(wide_file_name, L"wt");
+    free(wide_file_name);
+    return file;
+#else
+    return fopen(file_name, "wt");
+#endif
+}
+
+bool write_snapshot_to_file(
+    const EditorStateSnapshot& snapshot,
+    const char* const file_name)
+{
+    FILE* file = open_snapshot_file(file_name);
+    if (!file)
+    {
+        return false;
+    }
+
+    FileWriter writer(file);
+    format_snapshot(snapshot, writer);
+
+    const bool success = ferror(file) == 0;
+    return (fclose(file) == 0) && success;
+}
+
+void save_snapshot_task(void* const task_data)
+{
+    EditorStateSnapshot& snapshot =
+        *static_cast<EditorStateSnapshot*>(task_data);
+    const bool success = write_snapshot_to_file(snapshot, snapshot.file_name);
+    atomic_store_release(
+        &snapshot.save_state,
+        success ? SnapshotSaveState_Succeeded : SnapshotSaveState_Failed);
+}
+
+// The node geometry is loaded relative to the node origin, in grid space.
+// restore_node_geometry() moves it to screen space once the canvas origin is
+// known in BeginNodeEditor().
 void node_line_handler(EditorContext& editor, const char* line)
 {
-    int id;
-    float x, y;
+    int id, type;
+    float x, y, z, w;
     if (sscanf(line, "[node.%i", &id) == 1)
     {
-        const int node_idx = editor.nodes.find_or_create_index_for(id);
-        g.current_node_idx = node_idx;
+        const int node_idx = find_or_create_node_index(editor, id);
+        g->current_node_idx = node_idx;
         NodeData& node = editor.nodes.pool[node_idx];
         node.id = id;
     }
     else if (sscanf(line, "origin=%f,%f", &x, &y) == 2)
     {
-        NodeData& node = editor.nodes.pool[g.current_node_idx];
+        NodeData& node = editor.nodes.pool[g->current_node_idx];
         node.origin = ImVec2(x, y);
     }
+    else if (sscanf(line, "size=%f,%f", &x, &y) == 2)
+    {
+        NodeData& node = editor.nodes.pool[g->current_node_idx];
+        editor.node_rects[g->current_node_idx] =
+            ImRect(node.origin, node.origin + ImVec2(x, y));
+        node.grid_space_size = ImVec2(x, y);
+        node.geometry_in_grid_space = true;
+        editor.has_grid_space_geometry = true;
+    }
+    else if (sscanf(line, "title_bar=%f,%f,%f,%f", &x, &y, &z, &w) == 4)
+    {
+        NodeData& node = editor.nodes.pool[g->current_node_idx];
+        node.title_bar_content_rect =
+            ImRect(node.origin + ImVec2(x, y), node.origin + ImVec2(z, w));
+    }
+    else if (
+        sscanf(line, "pin=%i,%i,%f,%f,%f,%f", &id, &type, &x, &y, &z, &w) ==
+            6 &&
+        (type == AttributeType_Input || type == AttributeType_Output))
+    {
+        const NodeData& node = editor.nodes.pool[g->current_node_idx];
+        PinData& pin = editor.pins.pool[find_or_create_pin_index(editor, id)];
+        pin.id = id;
+        pin.parent_node_idx = g->current_node_idx;
+        pin.type = static_cast<AttributeType>(type);
+        pin.attribute_rect =
+            ImRect(node.origin + ImVec2(x, y), node.origin + ImVec2(z, w));
+    }
 }
 
 void editor_line_handler(EditorContext& editor, const char* line)
@@ -2146,44 +9120,38 @@ void editor_line_handler(EditorContext& editor, const char* line)
 }
 } // namespace
 
-const char* SaveCurrentEditorStateToIniString(size_t* const data_size)
+const char* SaveCurrentEditorStateToIniString(
+    size_t* const data_size,
+    const SaveFlags flags)
 {
-    return SaveEditorStateToIniString(&editor_context_get(), data_size);
+    return SaveEditorStateToIniString(&editor_context_get(), data_size, flags);
 }
 
 const char* SaveEditorStateToIniString(
     const EditorContext* const editor_ptr,
-    size_t* const data_size)
+    size_t* const data_size,
+    const SaveFlags flags)
 {
     assert(editor_ptr != NULL);
     const EditorContext& editor = *editor_ptr;
+    const ProfileZone zone("SaveEditorStateToIniString");
 
-    g.text_buffer.clear();
-    // TODO: check to make sure that the estimate is the upper bound of element
-    g.text_buffer.reserve(64 * editor.nodes.pool.size());
+    EditorStateSnapshot snapshot;
+    capture_snapshot(editor, flags, snapshot);
 
-    g.text_buffer.appendf(
-        "[editor]\npanning=%i,%i\n",
-        (int)editor.panning.x,
-        (int)editor.panning.y);
+    g->text_buffer.clear();
+    // TODO: check to make sure that the estimate is the upper bound of element
+    g->text_buffer.reserve(
+        64 * snapshot.nodes.size() + 48 * snapshot.pins.size());
 
-    for (int i = 0; i < editor.nodes.pool.size(); i++)
-    {
-        if (editor.nodes.in_use[i])
-        {
-            const NodeData& node = editor.nodes.pool[i];
-            g.text_buffer.appendf("\n[node.%d]\n", node.id);
-            g.text_buffer.appendf(
-                "origin=%i,%i\n", (int)node.origin.x, (int)node.origin.y);
-        }
-    }
+    format_snapshot(snapshot, g->text_buffer);
 
     if (data_size != NULL)
     {
-        *data_size = g.text_buffer.size();
+        *data_size = g->text_buffer.size();
     }
 
-    return g.text_buffer.c_str();
+    return g->text_buffer.c_str();
 }
 
 void LoadCurrentEditorStateFromIniString(
@@ -2205,6 +9173,7 @@ void LoadEditorStateFromIniString(
 
     EditorContext& editor =
         editor_ptr == NULL ? editor_context_get() : *editor_ptr;
+    const ProfileZone zone("LoadEditorStateFromIniString");
 
     char* buf = (char*)ImGui::MemAlloc(data_size + 1);
     const char* buf_end = buf + data_size;
@@ -2253,17 +9222,20 @@ void LoadEditorStateFromIniString(
     ImGui::MemFree(buf);
 }
 
-void SaveCurrentEditorStateToIniFile(const char* const file_name)
+void SaveCurrentEditorStateToIniFile(
+    const char* const file_name,
+    const SaveFlags flags)
 {
-    SaveEditorStateToIniFile(&editor_context_get(), file_name);
+    SaveEditorStateToIniFile(&editor_context_get(), file_name, flags);
 }
 
 void SaveEditorStateToIniFile(
     const EditorContext* const editor,
-    const char* const file_name)
+    const char* const file_name,
+    const SaveFlags flags)
 {
     size_t data_size = 0u;
-    const char* data = SaveEditorStateToIniString(editor, &data_size);
+    const char* data = SaveEditorStateToIniString(editor, &data_size, flags);
     FILE* file = ImFileOpen(file_name, "wt");
     if (!file)
     {
@@ -2294,4 +9266,81 @@ void LoadEditorStateFromIniFile(
     LoadEditorStateFromIniString(editor, file_data, data_size);
     ImGui::MemFree(file_data);
 }
+
+EditorStateSnapshot* CaptureCurrentEditorStateSnapshot(const SaveFlags flags)
+{
+    return CaptureEditorStateSnapshot(&editor_context_get(), flags);
+}
+
+EditorStateSnapshot* CaptureEditorStateSnapshot(
+    const EditorContext* const editor,
+    const SaveFlags flags)
+{
+    assert(editor != NULL);
+    // The node origins are only final once EndNodeEditor() has been called.
+    assert(g->current_scope == Scope_None);
+
+    void* mem = ImGui::MemAlloc(sizeof(EditorStateSnapshot));
+    EditorStateSnapshot* snapshot = new (mem) EditorStateSnapshot();
+    capture_snapshot(*editor, flags, *snapshot);
+    return snapshot;
+}
+
+void EditorStateSnapshotFree(EditorStateSnapshot* const snapshot)
+{
+    // Don't free the snapshot while the worker thread is still using it!
+    assert(
+        atomic_load_acquire(&snapshot->save_state) !=
+        SnapshotSaveState_Pending);
+    if (snapshot->file_name != NULL)
+    {
+        ImGui::MemFree(snapshot->file_name);
+    }
+    snapshot->~EditorStateSnapshot();
+    ImGui::MemFree(snapshot);
+}
+
+bool SaveEditorStateSnapshotToIniFile(
+    const EditorStateSnapshot* const snapshot,
+    const char* const file_name)
+{
+    assert(snapshot != NULL);
+    return write_snapshot_to_file(*snapshot, file_name);
+}
+
+void SaveEditorStateSnapshotToIniFileAsync(
+    EditorStateSnapshot* const snapshot,
+    const char* const file_name)
+{
+    assert(snapshot != NULL);
+    // A snapshot can only be saved asynchronously once at a time.
+    assert(
+        atomic_load_acquire(&snapshot->save_state) !=
+        SnapshotSaveState_Pending);
+
+    if (snapshot->file_name != NULL)
+    {
+        ImGui::MemFree(snapshot->file_name);
+    }
+    // The caller's string may not outlive the task, so store a copy.
+    snapshot->file_name = ImStrdup(file_name);
+    snapshot->save_state = SnapshotSaveState_Pending;
+
+    run_task(g->io, save_snapshot_task, snapshot);
+}
+
+bool IsEditorStateSnapshotSaved(
+    const EditorStateSnapshot* const snapshot,
+    bool* const success)
+{
+    assert(snapshot != NULL);
+    const int save_state = atomic_load_acquire(&snapshot->save_state);
+    const bool is_saved = save_state == SnapshotSaveState_Succeeded ||
+                          save_state == SnapshotSaveState_Failed;
+    if (is_saved && success != NULL)
+    {
+        *success = save_state == SnapshotSaveState_Succeeded;
+    }
+    return is_saved;
+}
 } // namespace imnodes
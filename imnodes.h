@@ -24,6 +24,11 @@ enum ColorStyle
     ColorStyle_BoxSelectorOutline,
     ColorStyle_GridBackground,
     ColorStyle_GridLine,
+    ColorStyle_MiniMapBackground,
+    ColorStyle_MiniMapOutline,
+    ColorStyle_MiniMapNode,
+    ColorStyle_MiniMapLink,
+    ColorStyle_MiniMapViewport,
     ColorStyle_Count
 };
 
@@ -39,7 +44,10 @@ enum StyleFlags
 {
     StyleFlags_None = 0,
     StyleFlags_NodeOutline = 1 << 0,
-    StyleFlags_GridLines = 1 << 2
+    StyleFlags_GridLines = 1 << 2,
+    // Route the links around the nodes with horizontal and vertical segments,
+    // instead of drawing them as curves.
+    StyleFlags_OrthogonalLinks = 1 << 3
 };
 
 // This enum controls the way attribute pins look.
@@ -53,6 +61,15 @@ enum PinShape
     PinShape_QuadFilled
 };
 
+// The corner of the canvas which the minimap is drawn in.
+enum MiniMapLocation
+{
+    MiniMapLocation_BottomLeft,
+    MiniMapLocation_BottomRight,
+    MiniMapLocation_TopLeft,
+    MiniMapLocation_TopRight
+};
+
 // This enum controls the way the attribute pins behave.
 enum AttributeFlags
 {
@@ -92,6 +109,70 @@ struct IO
         const bool* modifier;
     } link_detach_with_modifier_click;
 
+    struct TaskRunner
+    {
+        TaskRunner();
+
+        // Pointer to a function which runs task(task_data) on a worker thread.
+        // Set to NULL by default, in which case imnodes runs the task
+        // synchronously on the calling thread. Hook this up to your
+        // application's thread pool to move work off the UI thread.
+        //
+        // Every task must eventually be run exactly once, without waiting on
+        // the calling thread: EditorContextFree() blocks until the task of a
+        // running force layout has returned, which it does promptly once the
+        // editor is being freed. user_data is passed through as is.
+        void (*run)(void (*task)(void*), void* task_data, void* user_data);
+        void* user_data;
+    } task_runner;
+
+    struct ParallelFor
+    {
+        ParallelFor();
+
+        // Pointer to a function which calls job(job_idx, job_data) once for
+        // each job_idx in [0, job_count), spread out over worker threads. The
+        // function must not return before all of the jobs have finished. Set
+        // to NULL by default, in which case all work is done serially on the
+        // calling thread.
+        //
+        // The jobs write to disjoint memory, and the results are always
+        // gathered in a deterministic order, so the output doesn't depend on
+        // the scheduling of the jobs.
+        //
+        // Used for box selection and for tessellating the links. The
+        // parallel link rendering produces exactly the same vertices, indices
+        // and draw commands as the serial path.
+        void (*run)(
+            void (*job)(int job_idx, void* job_data),
+            int job_count,
+            void* job_data,
+            void* user_data);
+        void* user_data;
+
+        // Work is only split into jobs when the number of elements to process
+        // is at least min_elements. Below that, dispatching the jobs costs
+        // more than it saves.
+        int min_elements;
+        // The number of elements processed by each job.
+        int elements_per_job;
+    } parallel_for;
+
+    struct Profiler
+    {
+        Profiler();
+
+        // Called when imnodes enters and leaves one of its profiling zones:
+        // each editor frame, the object pool updates, drawing each node and
+        // all of the links, the box selection, the click interactions, and
+        // saving and loading the editor state. Zones nest, and are entered and
+        // left on the thread which calls imnodes. name is a string literal,
+        // and is the same for both calls. Set to NULL by default.
+        void (*begin_zone)(const char* name, void* user_data);
+        void (*end_zone)(const char* name, void* user_data);
+        void* user_data;
+    } profiler;
+
     IO();
 };
 
@@ -106,6 +187,14 @@ struct Style
     float link_thickness;
     float link_line_segments_per_length;
     float link_hover_distance;
+    // The distance kept between the nodes and the links routed around them,
+    // when StyleFlags_OrthogonalLinks is set.
+    float link_route_spacing;
+
+    // Below this zoom factor, the editor is zoomed out: the nodes are drawn as
+    // plain rectangles, the pins are hidden, and the links are drawn as
+    // straight lines. See IsEditorZoomedOut().
+    float detail_zoom_threshold;
 
     // The following variables control the look and behavior of the pins. The
     // default size of each pin shape is balanced to occupy approximately the
@@ -146,15 +235,74 @@ struct Style
 // context.
 struct EditorContext;
 
+// Provides the memory of an editor context in place of ImGui::MemAlloc() and
+// ImGui::MemFree(), e.g. to account for or to bound the memory of each editor.
+// The functions are only called from the thread which uses the editor. If they
+// are NULL, the editor uses ImGui::MemAlloc() and ImGui::MemFree().
+struct EditorAllocator
+{
+    void* (*alloc)(size_t size, void* user_data);
+    void (*free)(void* ptr, void* user_data);
+    void* user_data;
+
+    EditorAllocator();
+};
+
 EditorContext* EditorContextCreate();
+// The editor context, and the memory of its nodes, pins, links, selection,
+// cached link routes, minimap and layout state come from the allocator. The
+// scratch memory shared by all of the editors, and the memory of a running
+// force layout, still come from ImGui::MemAlloc().
+EditorContext* EditorContextCreate(const EditorAllocator& allocator);
+// Bump allocates the editor's memory from blocks of block_size bytes, which
+// are only released when the editor context is freed, all at once. Memory
+// which the editor frees while it's in use isn't reused, so this suits short
+// lived editors, such as previews.
+EditorContext* EditorContextCreateWithArena(size_t block_size = 64 * 1024);
 void EditorContextFree(EditorContext*);
 void EditorContextSet(EditorContext*);
 ImVec2 EditorContextGetPanning();
 void EditorContextResetPanning(const ImVec2& pos);
 void EditorContextMoveToNode(const int node_id);
-
-// Initialize the node editor system.
+// Center the view on all of the nodes, or on the selected nodes and the nodes
+// at either end of the selected links, zooming out until they fit in the
+// canvas. These use bounds which the editor keeps up to date every frame, as of
+// the last EndNodeEditor(), so nodes moved since then aren't accounted for.
+void EditorContextFitToContent();
+void EditorContextFrameSelection();
+// The zoom factor scales the grid space to the screen space, and is 1 by
+// default. The node contents are scaled along with the fonts, and the style's
+// node, pin and link sizes are scaled along with the nodes.
+float EditorContextGetZoom();
+// Sets the zoom factor while keeping the grid space position under the screen
+// space anchor in place. For example, zoom around the mouse cursor with
+// EditorContextSetZoom(zoom * 1.1f, ImGui::GetMousePos()).
+void EditorContextSetZoom(float zoom, const ImVec2& screen_space_anchor);
+
+// The imnodes context holds the style, the IO configuration, the per-frame
+// state, and the default editor context. Functions which don't take a context
+// argument operate on the current context.
+//
+// To drive node editors from several threads at once (each with its own ImGui
+// context), give each thread its own imnodes context, and make the current
+// context pointer thread local by defining IMNODES_THREAD_LOCAL when compiling
+// imnodes.cpp, e.g. -DIMNODES_THREAD_LOCAL=__thread, or thread_local in C++11.
+// This mirrors making ImGui's GImGui pointer thread local. Contexts don't share
+// any mutable state.
+struct Context;
+
+// The new context becomes the current context only if there is no current
+// context. Requires a current ImGui context.
+Context* CreateContext();
+// Destroys the current context if ctx is NULL.
+void DestroyContext(Context* ctx = NULL);
+Context* GetCurrentContext();
+void SetCurrentContext(Context* ctx);
+
+// Initialize the node editor system. Equivalent to creating a context and
+// setting it as the current context.
 void Initialize();
+// Destroys the current context.
 void Shutdown();
 
 IO& GetIO();
@@ -173,7 +321,21 @@ void StyleColorsLight();
 void BeginNodeEditor();
 void EndNodeEditor();
 
+// Draws a minimap of the whole editor in a corner of the canvas, which shows
+// where the nodes and links are, and the part of the editor which is visible.
+// Clicking or dragging inside of the minimap moves the view there. The minimap
+// takes up size_fraction of the canvas along each axis. Call after the nodes
+// and links, just before EndNodeEditor(), in every frame which shows the
+// minimap.
+void MiniMap(
+    float size_fraction = 0.2f,
+    MiniMapLocation location = MiniMapLocation_TopRight);
+
 // Use PushColorStyle and PopColorStyle to modify Style::colors mid-frame.
+//
+// Up to 65536 different node styles, pin styles and link styles can be used
+// during a frame. Once they run out, an element with a new style is drawn
+// with the style of the element of the same kind submitted before it.
 void PushColorStyle(ColorStyle item, unsigned int color);
 void PopColorStyle();
 void PushStyleVar(StyleVar style_item, float value);
@@ -217,12 +379,247 @@ void Link(int id, int start_attribute_id, int end_attribute_id);
 
 void SetNodeScreenSpacePos(int node_id, const ImVec2& screen_space_pos);
 void SetNodeGridSpacePos(int node_id, const ImVec2& grid_pos);
+// Returns the node's position in node editor grid coordinates.
+ImVec2 GetNodeGridSpacePos(int node_id);
+// Returns the size of the node in grid space units, as measured during the last
+// frame which drew the node's contents.
+ImVec2 GetNodeDimensions(int node_id);
 // Enable or disable the ability to click and drag a specific node.
 void SetNodeDraggable(int node_id, const bool draggable);
 
+// Use the following functions to arrange the nodes automatically. The nodes
+// are placed in layers from left to right, so that the links run from output
+// pins towards input pins, with as few link crossings as possible. The layout
+// uses the nodes, pins and links submitted during the last frame, and their
+// measured sizes, so call these functions after EndNodeEditor(). The new node
+// positions take effect on the next frame.
+struct LayoutOptions
+{
+    // The horizontal gap between the widest node of a layer and the next
+    // layer.
+    float layer_spacing;
+    // The vertical gap between the nodes of a layer.
+    float node_spacing;
+    // The number of sweeps over the layers made to reduce the link crossings,
+    // and then to straighten the links.
+    int iterations;
+
+    LayoutOptions();
+};
+
+// Lays out all of the nodes. The top left corner of the nodes' bounding box
+// stays in place.
+void LayoutCurrentEditor(const LayoutOptions& options = LayoutOptions());
+void LayoutEditor(
+    EditorContext* editor,
+    const LayoutOptions& options = LayoutOptions());
+// Only lays out the layers which gained or lost nodes since the last layout,
+// e.g. after adding a few nodes. The nodes of the other layers aren't moved.
+// Does a full layout if the editor hasn't been laid out before.
+void UpdateCurrentEditorLayout(const LayoutOptions& options = LayoutOptions());
+void UpdateEditorLayout(
+    EditorContext* editor,
+    const LayoutOptions& options = LayoutOptions());
+
+// Use the following functions to run a force-directed layout, which suits
+// graphs with cycles better than the layered layout does. Linked nodes pull
+// each other closer, and all nodes push each other apart. The layout runs
+// through IO::task_runner, or synchronously when starting the layout if no
+// task runner is set. Like the layered layout, start it after EndNodeEditor().
+//
+// While the layout is running, BeginNodeEditor() moves the nodes to the
+// layout's latest positions once per frame. Nodes which aren't draggable, and
+// nodes which are being dragged by the user, stay in place.
+struct ForceLayoutOptions
+{
+    // The ideal gap between linked nodes.
+    float link_length;
+    // Controls the accuracy of the repulsion between the nodes. Groups of nodes
+    // which are further away than their size divided by theta are treated as
+    // a single node. Zero is exact, but the cost of an iteration then grows
+    // quadratically with the number of nodes.
+    float theta;
+    // The layout stops after this many iterations, or once it has converged.
+    int max_iterations;
+
+    ForceLayoutOptions();
+};
+
+// Starting a layout stops the running one.
+void StartCurrentEditorForceLayout(
+    const ForceLayoutOptions& options = ForceLayoutOptions());
+void StartEditorForceLayout(
+    EditorContext* editor,
+    const ForceLayoutOptions& options = ForceLayoutOptions());
+// The nodes stay where they are when the layout is stopped. Stopping doesn't
+// wait for the worker, but EditorContextFree() and DestroyContext() do.
+void StopCurrentEditorForceLayout();
+void StopEditorForceLayout(EditorContext* editor);
+// Returns false once the layout has converged and the final positions have
+// been applied, or once it has been stopped.
+bool IsCurrentEditorForceLayoutRunning();
+bool IsEditorForceLayoutRunning(const EditorContext* editor);
+
+// Use the following functions to move overlapping nodes apart, e.g. after
+// pasting or loading nodes. Each overlapping node is moved to the nearest
+// free position, and nodes stacked at the same position are spread out on a
+// grid. Only the given nodes are moved, but they are kept clear of all nodes.
+// spacing is the minimum gap left between the nodes. The node rects measured
+// during the last frame are used, so call these after EndNodeEditor().
+void RemoveNodeOverlaps(
+    const int* node_ids,
+    int num_node_ids,
+    float spacing = 0.f);
+void RemoveSelectedNodeOverlaps(float spacing = 0.f);
+
+// Use the following functions to collapse a set of nodes into a single group
+// node, e.g. to keep a large graph responsive by collapsing the parts which
+// aren't being worked on. Collapse the nodes after EndNodeEditor(), as the
+// nodes, pins and links of the last frame are used.
+//
+// While the group is collapsed, skip submitting its member nodes; they aren't
+// drawn or hit tested. Submit the group node instead, with BeginNode(group_id)
+// and any title bar or contents. It starts out at the top left corner of the
+// members' bounding box, and can be selected and dragged like any other node.
+// The member pins which are linked to pins outside of the group become the
+// group node's proxy pins, under their own ids, with the inputs on the left
+// and the outputs on the right. Keep submitting the links as they are: the
+// links between the members are skipped, and a link which is later made to
+// another member pin adds a proxy pin for it from the next frame on.
+//
+// A group node can be collapsed into another group. Saving the editor state
+// saves the members' positions as if the groups were expanded, but not the
+// groups.
+void CollapseNodeGroup(int group_id, const int* node_ids, int num_node_ids);
+// Restores the members' positions around where the group node is, and stops
+// skipping them. Stop submitting the group node. The groups which a group was
+// collapsed into have to be expanded first.
+void ExpandNodeGroup(int group_id);
+bool IsNodeGroupCollapsed(int group_id);
+// Returns true if the node is a member of a collapsed group, including the
+// members of the groups nested in it. Can be called while submitting nodes.
+bool IsNodeCollapsed(int node_id);
+
+// Counters describing the work done by the last Begin/EndNodeEditor pair.
+// They are only collected when imnodes.cpp is compiled with
+// IMNODES_ENABLE_STATS defined. Otherwise the counting compiles away, and all
+// of the counters stay zero.
+struct FrameStats
+{
+    // The elements submitted during the frame, and how many of them were
+    // culled or drawn. Zoomed out, the pins aren't drawn at all.
+    int nodes_submitted;
+    int nodes_culled;
+    int nodes_drawn;
+    int pins_submitted;
+    int pins_culled;
+    int pins_drawn;
+    int links_submitted;
+    int links_culled;
+    int links_drawn;
+
+    // The bezier curve segments evaluated to test whether the mouse is near a
+    // link, and the segments which the drawn links were tessellated into.
+    int hover_bezier_segments;
+    int render_bezier_segments;
+
+    // The number of slots in the editor's object pools, and how many of them
+    // are free.
+    int node_pool_size;
+    int node_free_list_size;
+    int pin_pool_size;
+    int pin_free_list_size;
+    int link_pool_size;
+    int link_free_list_size;
+
+    // Added to the canvas draw list between BeginNodeEditor() and
+    // EndNodeEditor().
+    int canvas_vertices;
+    int canvas_indices;
+
+    // Milliseconds spent updating the editor state in BeginNodeEditor(),
+    // drawing the nodes, links and minimap, and handling the mouse
+    // interactions.
+    double update_ms;
+    double draw_ms;
+    double interaction_ms;
+
+    FrameStats();
+};
+
+// Returns the counters of the last editor frame. Call after EndNodeEditor().
+const FrameStats& GetFrameStats();
+
+// Records the profiling zones of the current context, and writes them to
+// file_name as a Chrome trace, which can be opened in chrome://tracing. The
+// recording skips skip_frames editor frames (BeginNodeEditor() calls), and
+// then records num_frames of them, along with anything between them such as
+// saving the editor state. The IO::Profiler callbacks are still called.
+void StartTraceCapture(
+    const char* file_name,
+    int num_frames,
+    int skip_frames = 0);
+// Returns true until the trace has been written.
+bool IsTraceCaptureRunning();
+
+// The memory held by one of an editor's object pools. The slots of the
+// elements which weren't submitted during a frame are reused by new elements,
+// but a pool never shrinks by itself.
+struct PoolMemoryStats
+{
+    // The elements in use, and the slots in the pool, used or free.
+    int live;
+    int slots;
+    // The slots which memory is allocated for.
+    int capacity;
+    // The most elements in use at once since the pool was created or
+    // compacted.
+    int high_water_mark;
+    // The bytes taken by the live elements, and allocated for the pool and its
+    // bookkeeping.
+    size_t live_bytes;
+    size_t capacity_bytes;
+
+    PoolMemoryStats();
+};
+
+struct EditorMemoryReport
+{
+    PoolMemoryStats nodes;
+    PoolMemoryStats pins;
+    PoolMemoryStats links;
+    // The bytes allocated for the selection, the layout state, the cached link
+    // routes and the minimap.
+    size_t other_bytes;
+    // Everything above, and the editor context itself.
+    size_t total_bytes;
+
+    EditorMemoryReport();
+};
+
+EditorMemoryReport GetCurrentEditorMemoryReport();
+EditorMemoryReport GetEditorMemoryReport(const EditorContext* editor);
+
+// Moves the elements which were submitted during the last frame to the front
+// of the editor's pools, and frees the rest of the slots, along with the
+// cached data kept for them, e.g. after closing a large graph. The elements
+// which weren't submitted are dropped, as they would be at the start of the
+// next frame. Call outside of BeginNodeEditor()/EndNodeEditor().
+//
+// Does nothing for editors created with EditorContextCreateWithArena(), as
+// their memory is only released when they are freed.
+void CompactCurrentEditor();
+void CompactEditor(EditorContext* editor);
+
 // Returns true if the current node editor canvas is being hovered over by the
 // mouse, and is not blocked by any other windows.
 bool IsEditorHovered();
+// Returns true if the current editor is zoomed out below
+// Style::detail_zoom_threshold. The node contents aren't drawn then, so skip
+// submitting the widgets between BeginNode() and EndNode() to save their cost.
+// The attribute calls still have to be made, as the links are drawn between
+// their pins. Call after BeginNodeEditor().
+bool IsEditorZoomedOut();
 // The following functions return true if a UI element is being hovered over by
 // the mouse cursor. Assigns the id of the UI element being hovered over to the
 // function argument. Use these functions after EndNodeEditor() has been called.
@@ -264,10 +661,25 @@ bool IsLinkDestroyed(int* link_id);
 // or directly to a file. The editor context is serialized in the INI file
 // format.
 
-const char* SaveCurrentEditorStateToIniString(size_t* data_size = NULL);
+// This enum controls what gets written when saving the editor state.
+enum SaveFlags
+{
+    // Only the node origins and the editor panning are saved.
+    SaveFlags_None = 0,
+    // Also save the measured node rects and the pins' attribute rects. Loading
+    // the geometry lets the first frame after loading cull, hit test and draw
+    // links without first waiting for the nodes to be submitted. Node layout
+    // code can also use the node sizes straight after loading.
+    SaveFlags_NodeGeometry = 1 << 0
+};
+
+const char* SaveCurrentEditorStateToIniString(
+    size_t* data_size = NULL,
+    SaveFlags flags = SaveFlags_None);
 const char* SaveEditorStateToIniString(
     const EditorContext* editor,
-    size_t* data_size = NULL);
+    size_t* data_size = NULL,
+    SaveFlags flags = SaveFlags_None);
 
 void LoadCurrentEditorStateFromIniString(const char* data, size_t data_size);
 void LoadEditorStateFromIniString(
@@ -275,11 +687,50 @@ void LoadEditorStateFromIniString(
     const char* data,
     size_t data_size);
 
-void SaveCurrentEditorStateToIniFile(const char* file_name);
+void SaveCurrentEditorStateToIniFile(
+    const char* file_name,
+    SaveFlags flags = SaveFlags_None);
 void SaveEditorStateToIniFile(
     const EditorContext* editor,
-    const char* file_name);
+    const char* file_name,
+    SaveFlags flags = SaveFlags_None);
 
 void LoadCurrentEditorStateFromIniFile(const char* file_name);
 void LoadEditorStateFromIniFile(EditorContext* editor, const char* file_name);
+
+// Use the following functions to save the editor context's state without
+// blocking the UI thread. Capturing a snapshot copies the node ids, node
+// origins and the editor panning (and the node geometry, if requested with
+// SaveFlags_NodeGeometry), and must be done on the UI thread, outside of a
+// BeginNodeEditor/EndNodeEditor pair. The snapshot is immutable once it has
+// been captured, and doesn't reference the editor context.
+struct EditorStateSnapshot;
+
+EditorStateSnapshot* CaptureCurrentEditorStateSnapshot(
+    SaveFlags flags = SaveFlags_None);
+EditorStateSnapshot* CaptureEditorStateSnapshot(
+    const EditorContext* editor,
+    SaveFlags flags = SaveFlags_None);
+// Free the snapshot on the UI thread, once IsEditorStateSnapshotSaved()
+// returns true if the snapshot was passed to
+// SaveEditorStateSnapshotToIniFileAsync().
+void EditorStateSnapshotFree(EditorStateSnapshot* snapshot);
+
+// Formats the snapshot in the INI file format and writes it to a file. This
+// function doesn't touch any imnodes or ImGui state, and opens the file
+// without ImGui's file functions, so it is safe to call on any thread. Returns
+// false if the file could not be written to.
+bool SaveEditorStateSnapshotToIniFile(
+    const EditorStateSnapshot* snapshot,
+    const char* file_name);
+// Calls SaveEditorStateSnapshotToIniFile() via IO::task_runner. Use
+// IsEditorStateSnapshotSaved() to poll for completion.
+void SaveEditorStateSnapshotToIniFileAsync(
+    EditorStateSnapshot* snapshot,
+    const char* file_name);
+// Returns true once the asynchronous save has finished. success is set to
+// whether the file was written successfully.
+bool IsEditorStateSnapshotSaved(
+    const EditorStateSnapshot* snapshot,
+    bool* success = NULL);
 } // namespace imnodes
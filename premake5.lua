@@ -150,3 +150,28 @@ workspace "imnodes"
     imnodes_example_project("colornode", "color_node_editor.cpp")
 
     imnodes_example_project("multieditor", "multi_editor.cpp")
+
+    group "benchmarks"
+
+    -- The benchmarks run without a window or a renderer, so they don't depend
+    -- on SDL or OpenGL. The imgui project also builds the SDL and OpenGL
+    -- backends, so the bench compiles the core imgui sources itself.
+    project "bench"
+        location(projectlocation)
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++11"
+        targetdir "bin/%{cfg.buildcfg}"
+        debugdir "bin/%{cfg.buildcfg}"
+        files {
+            "bench/*.h",
+            "bench/*.cpp",
+            path.join(imguilocation, "imgui.cpp"),
+            path.join(imguilocation, "imgui_demo.cpp"),
+            path.join(imguilocation, "imgui_draw.cpp"),
+            path.join(imguilocation, "imgui_widgets.cpp") }
+        includedirs { os.getcwd(), imguilocation }
+        links { "imnodes" }
+
+        filter "system:linux"
+            links { "pthread" }